@@ -12,6 +12,7 @@
 #ifndef STIME_HPP
 #define STIME_HPP
 
+#include "../core/liberty_registry.hpp"
 #include "../core/read_placement_file.hpp"
 #include "base/abc/abc.h"
 
@@ -39,16 +40,7 @@ class stime_command : public command {
 
     begin = clock();
     Abc_Ntk_t *pNtk;
-    pabc::Abc_Frame_t *pAbc = pabc::Abc_FrameGetGlobalFrame();
-    SC_DontUse dont_use = {0};
-    SC_Lib *pLib =
-        Scl_ReadLibraryFile(pAbc, (char *)(lib_file.c_str()), 1, 0, dont_use);
-    ABC_FREE(dont_use.dont_use_list);
-    Abc_SclLoad(pLib, (SC_Lib **)&pAbc->pLibScl);
-    if (pAbc->pLibScl) {
-      Abc_SclInstallGenlib(pAbc->pLibScl, 0, 0, 0);
-      Mio_LibraryTransferCellIds();
-    }
+    SC_Lib *pLib = phyLS::liberty_library(lib_file);
 
     if (Abc_FrameReadLibGen() == NULL) {
       Abc_Print(-1,
@@ -87,7 +79,9 @@ class stime_command : public command {
          i < Abc_NtkNodeNum(pNtk) + Abc_NtkPiNum(pNtk) + Abc_NtkPoNum(pNtk);
          i++)
       VecNP[i] = Vec_IntAlloc(2);
-    phyLS::read_def_file_abc(def_file, VecNP);
+    phyLS::read_def_file_abc(
+        def_file, VecNP,
+        Abc_NtkNodeNum(pNtk) + Abc_NtkPiNum(pNtk) + Abc_NtkPoNum(pNtk));
 
     for (int j = 0;
          j < Abc_NtkNodeNum(pNtk) + Abc_NtkPiNum(pNtk) + Abc_NtkPoNum(pNtk);
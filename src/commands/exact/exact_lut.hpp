@@ -22,6 +22,7 @@
 #include "../../core/exact/exact_dag.hpp"
 #include "../../core/exact/exact_lut.hpp"
 #include "../core/exact/lut_rewriting.hpp"
+#include "../../core/library_registry.hpp"
 
 using namespace std;
 using namespace percy;
@@ -425,9 +426,11 @@ class exact_command : public command {
             }
           }
           if (is_set("map")) {
-            std::vector<mockturtle::gate> gates =
+            std::vector<mockturtle::gate> const& gates =
                 store<std::vector<mockturtle::gate>>().current();
-            mockturtle::tech_library<5> lib(gates);
+            auto const lib_ptr =
+                phyLS::library_registry::instance().technology(gates);
+            auto const& lib = *lib_ptr;
             mockturtle::map_params ps;
             mockturtle::map_stats st;
             klut_network klut = create_network(x);
@@ -483,9 +486,11 @@ class exact_command : public command {
           }
         }
         if (is_set("map")) {
-          std::vector<mockturtle::gate> gates =
+          std::vector<mockturtle::gate> const& gates =
               store<std::vector<mockturtle::gate>>().current();
-          mockturtle::tech_library<5> lib(gates);
+          auto const lib_ptr =
+              phyLS::library_registry::instance().technology(gates);
+          auto const& lib = *lib_ptr;
           mockturtle::map_params ps;
           mockturtle::map_stats st;
           klut_network klut = create_network(chain);
@@ -531,9 +536,11 @@ class exact_command : public command {
           }
         }
         if (is_set("map")) {
-          std::vector<mockturtle::gate> gates =
+          std::vector<mockturtle::gate> const& gates =
               store<std::vector<mockturtle::gate>>().current();
-          mockturtle::tech_library<5> lib(gates);
+          auto const lib_ptr =
+              phyLS::library_registry::instance().technology(gates);
+          auto const& lib = *lib_ptr;
           mockturtle::map_params ps;
           mockturtle::map_stats st;
           klut_network klut = create_network(x);
@@ -21,6 +21,7 @@
 #include <mockturtle/utils/tech_library.hpp>
 #include <string>
 
+#include "../core/library_registry.hpp"
 #include "../core/mapper_MCTS.hpp"
 #include "../core/properties.hpp"
 #include "../core/read_placement_file.hpp"
@@ -46,7 +47,22 @@ class imap_command : public command {
     add_option("--baseline_def, -b", baseline_def_file, "def file for baseline netlist");
     add_option("--baseline_v, -a", baseline_v, "verilog of baseline circuit");
     add_option("--result_dir, -t", result_dir, "directory for saving intermediate file");
-    
+    add_option("--threads, -j", num_threads,
+               "Number of parallel searches, 0 uses all cores [default = 1]");
+    add_option("--load_stats", load_stats_file,
+               "warm-start the search with saved tree statistics");
+    add_option("--save_stats", save_stats_file,
+               "save the tree statistics of the search");
+    add_flag("--native_sta, -n",
+             "time states with the built-in placement-aware STA instead of "
+             "ABC");
+    add_option("--wire_model", wire_model,
+               "wire delay model of the built-in STA: none, hpwl or elmore "
+               "[default = elmore]");
+    add_option("--wire_r", wire_resistance,
+               "wire resistance per placement unit [default = 0]");
+    add_option("--wire_c", wire_capacitance,
+               "wire capacitance per placement unit [default = 0]");
   }
 
   rules validity_rules() const {
@@ -65,52 +81,49 @@ class imap_command : public command {
   std::string baseline_def_file = "";
   std::string baseline_v = "";
   std::string result_dir = "";
-
-  template <typename TT>
-  std::string to_hex(const TT& tt) {
-    std::string hexstr;
-    auto const chunk_size =
-        std::min<uint64_t>(tt.num_vars() <= 1 ? 1 : (tt.num_bits() >> 2), 16);
-
-    for_each_block_reversed(tt, [&hexstr, chunk_size](uint64_t word) {
-      std::string chunk(chunk_size, '0');
-
-      auto it = chunk.rbegin();
-      while (word && it != chunk.rend()) {
-        auto hex = word & 0xf;
-        if (hex < 10) {
-          *it = '0' + static_cast<char>(hex);
-        } else {
-          *it = 'a' + static_cast<char>(hex - 10);
-        }
-        ++it;
-        word >>= 4;
-      }
-      hexstr += chunk;
-    });
-    return hexstr;
-  }
+  uint32_t num_threads{1u};
+  std::string load_stats_file = "";
+  std::string save_stats_file = "";
+  std::string wire_model = "elmore";
+  double wire_resistance{0.0};
+  double wire_capacitance{0.0};
 
  protected:
   void execute() {
     /* derive genlib */
-    std::vector<mockturtle::gate> gates =
+    std::vector<mockturtle::gate> const& gates =
         store<std::vector<mockturtle::gate>>().current();
-    mockturtle::tech_library<5> lib(gates);
-    std::vector<mockturtle::gate> gates_small;
-    for (auto& x : gates) {
-      if (to_hex(x.function) == "8" || to_hex(x.function) == "7" ||
-          to_hex(x.function) == "2" || to_hex(x.function) == "1" ||
-          to_hex(x.function) == "0")
-        gates_small.push_back(x);
-    }
-    mockturtle::tech_library<5> cri_lib(gates_small);
+    auto& registry = phyLS::library_registry::instance();
+    auto const lib_ptr = registry.technology(gates);
+    auto const cri_lib_ptr = registry.critical(gates);
+    auto const& lib = *lib_ptr;
+    auto const& cri_lib = *cri_lib_ptr;
 
     MCTS::MCTS_params mcts_ps;
-    if (is_set("mcts_ps"))
+    if (is_set("mcts_ps") && !phyLS::read_mcts_ps(mcts_ps_file, mcts_ps))
     {
-      phyLS::read_mcts_ps(mcts_ps_file, mcts_ps);
+      std::cerr << "[e] invalid MCTS parameters in " << mcts_ps_file << "\n";
+      return;
+    }
+    if (is_set("threads")) mcts_ps.num_threads = num_threads;
+    if (is_set("load_stats")) mcts_ps.load_statistics = load_stats_file;
+    if (is_set("save_stats")) mcts_ps.save_statistics = save_stats_file;
+    if (is_set("native_sta")) mcts_ps.native_sta = true;
+    if (is_set("wire_model")) {
+      phyLS::wire_model model;
+      if (!phyLS::parse_wire_model(wire_model, model)) {
+        std::cerr << "[e] unknown wire model " << wire_model << "\n";
+        return;
+      }
+      mcts_ps.wire_model = wire_model;
     }
+    if (is_set("wire_r")) mcts_ps.wire_resistance = wire_resistance;
+    if (is_set("wire_c")) mcts_ps.wire_capacitance = wire_capacitance;
+    if (mcts_ps.native_sta && mcts_ps.wire_model != "none" &&
+        mcts_ps.wire_resistance == 0.0 && mcts_ps.wire_capacitance == 0.0)
+      std::cerr << "[w] wire model " << mcts_ps.wire_model
+                << " without wire RC adds no wire delay, set --wire_r and "
+                   "--wire_c\n";
 
     mockturtle::map_params ps;
     if (is_set("best_result_file")) {
@@ -137,7 +150,7 @@ class imap_command : public command {
         auto aig = store<aig_network>().current();
         std::vector<mockturtle::node_position> np(aig.size() + aig.num_pos());
         phyLS::read_def_file_openroad(def_filename, np, aig.num_pis());
-        mockturtle::map_mcts(aig, library, lib, cri_lib, np, ps, &st);
+        mockturtle::map_mcts(aig, library, lib, cri_lib, np, ps, &st, mcts_ps);
         // if (is_set("output")) write_verilog_with_binding(res, filename);
         // std::cout << fmt::format(
         //     "Mapped AIG into #gates = {}, area = {:.2f}, delay = {:.2f}, "
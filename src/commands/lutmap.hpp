@@ -13,6 +13,8 @@
 #ifndef LUTMAP_HPP
 #define LUTMAP_HPP
 
+#include <memory>
+
 #include <mockturtle/generators/arithmetic.hpp>
 #include <mockturtle/networks/aig.hpp>
 #include <mockturtle/traits.hpp>
@@ -48,12 +50,25 @@ class lutmap_command : public command {
              "LUT map with cost function [default = false]");
     add_flag("--dominated_cuts, -d",
              "Remove the cuts that are contained in others [default = true]");
+    add_option("--threads, -t", num_threads,
+               "number of threads for cut enumeration, 0 = all cores "
+               "[default = 1]");
+    add_option("--cost_db, -b", cost_db_file,
+               "cost database file loaded before and saved after mapping "
+               "with cost function");
+    add_flag("--incremental, -i",
+             "AIG only: keep the mapper between calls and remap only the "
+             "nodes edited since the last call");
+    add_flag("--verify, -y",
+             "with --incremental, also map from scratch and compare");
     add_option("--output, -o", filename, "the bench filename");
     add_flag("--verbose, -v", "print the information");
   }
 
  protected:
   struct lut_custom_cost {
+    static constexpr char const* id = "lut_custom_cost"; /* cost database */
+
     std::pair<uint32_t, uint32_t> operator()(uint32_t num_leaves) const {
       if (num_leaves < 2u) return {0u, 0u};
       return {num_leaves, 1u}; /* area, delay */
@@ -67,6 +82,8 @@ class lutmap_command : public command {
   };
 
   void execute() {
+    /* a mapper kept for `lutmap -i` holds the AIG it was built on */
+    if (!is_set("incremental")) incremental.reset();
     if (is_set("mig")) {
       if (store<mig_network>().size() == 0u)
         std::cerr << "Error: Empty MIG network\n";
@@ -81,6 +98,7 @@ class lutmap_command : public command {
         if (is_set("recompute_cuts")) ps.recompute_cuts = false;
         if (is_set("edge")) ps.edge_optimization = false;
         if (is_set("dominated_cuts")) ps.remove_dominated_cuts = false;
+        ps.num_threads = num_threads;
         cout << "Mapped MIG into " << cut_size << "-LUT : ";
         phyLS::lut_map(mapped_mig, ps);
         mapped_mig.clear_mapping();
@@ -99,6 +117,7 @@ class lutmap_command : public command {
         if (is_set("recompute_cuts")) ps.recompute_cuts = false;
         if (is_set("edge")) ps.edge_optimization = false;
         if (is_set("dominated_cuts")) ps.remove_dominated_cuts = false;
+        ps.num_threads = num_threads;
         cout << "Mapped XAG into " << cut_size << "-LUT : ";
         phyLS::lut_map(mapped_xag, ps);
         mapped_xag.clear_mapping();
@@ -117,6 +136,7 @@ class lutmap_command : public command {
         if (is_set("recompute_cuts")) ps.recompute_cuts = false;
         if (is_set("edge")) ps.edge_optimization = false;
         if (is_set("dominated_cuts")) ps.remove_dominated_cuts = false;
+        ps.num_threads = num_threads;
         cout << "Mapped XMG into " << cut_size << "-LUT : ";
         phyLS::lut_map(mapped_xmg, ps);
         mapped_xmg.clear_mapping();
@@ -135,6 +155,7 @@ class lutmap_command : public command {
         if (is_set("recompute_cuts")) ps.recompute_cuts = false;
         if (is_set("edge")) ps.edge_optimization = false;
         if (is_set("dominated_cuts")) ps.remove_dominated_cuts = false;
+        ps.num_threads = num_threads;
         cout << "Mapped kLUT into " << cut_size << "-LUT : ";
         phyLS::lut_map(mapped_klut, ps);
         mapped_klut.clear_mapping();
@@ -153,12 +174,36 @@ class lutmap_command : public command {
         if (is_set("recompute_cuts")) ps.recompute_cuts = false;
         if (is_set("edge")) ps.edge_optimization = false;
         if (is_set("dominated_cuts")) ps.remove_dominated_cuts = false;
+        ps.num_threads = num_threads;
+        if (is_set("incremental")) {
+          if (is_set("cost_function") || is_set("cost_db")) {
+            std::cerr << "Error: --incremental maps with the unit LUT cost, "
+                         "it cannot be combined with --cost_function or "
+                         "--cost_db\n";
+            return;
+          }
+          execute_incremental(aig, ps);
+          return;
+        }
         cout << "Mapped AIG into " << cut_size << "-LUT : ";
+        phyLS::lut_cost_database cost_db;
+        if (is_set("cost_function") && is_set("cost_db")) {
+          cost_db.load(cost_db_file);
+          ps.cost_database = &cost_db;
+        }
         if (is_set("cost_function"))
           phyLS::lut_map<decltype(mapped_aig), true, lut_custom_cost>(
               mapped_aig, ps);
         else
           phyLS::lut_map(mapped_aig, ps);
+        if (ps.cost_database != nullptr) {
+          if (is_set("verbose"))
+            std::cout << "[i] cost database: " << cost_db.size()
+                      << " entries, " << cost_db.hits() << " hits, "
+                      << cost_db.misses() << " misses\n";
+          if (cost_db.is_modified() && !cost_db.save(cost_db_file))
+            std::cerr << "Error: cannot write " << cost_db_file << "\n";
+        }
         if (is_set("output")) {
           write_bench(mapped_aig, filename);
         } else {
@@ -169,10 +214,92 @@ class lutmap_command : public command {
   }
 
  private:
+  /* Mapper kept between calls of `lutmap -i`.  It holds a handle on the
+   * stored AIG, so it sees in-place edits through the network events, such
+   * as those of `refactor -i` and `resub -i`; a different AIG in the store
+   * or other parameters start a new mapper. */
+  struct incremental_state {
+    using view_t = mapping_view<aig_network, true>;
+
+    incremental_state(aig_network const& aig, phyLS::lut_map_params const& ps)
+        : aig(aig), ps(ps), view(this->aig), mapper(view, this->ps) {}
+
+    bool reusable(aig_network const& other,
+                  phyLS::lut_map_params const& other_ps) const {
+      return aig._storage == other._storage &&
+             ps.cut_enumeration_ps.cut_size ==
+                 other_ps.cut_enumeration_ps.cut_size &&
+             ps.cut_enumeration_ps.cut_limit ==
+                 other_ps.cut_enumeration_ps.cut_limit &&
+             ps.area_oriented_mapping == other_ps.area_oriented_mapping &&
+             ps.relax_required == other_ps.relax_required &&
+             ps.recompute_cuts == other_ps.recompute_cuts &&
+             ps.edge_optimization == other_ps.edge_optimization &&
+             ps.remove_dominated_cuts == other_ps.remove_dominated_cuts;
+    }
+
+    aig_network aig;
+    phyLS::lut_map_params ps;
+    view_t view;
+    phyLS::lut_map_incremental<view_t> mapper;
+  };
+
+  /* every mapped node has its leaves mapped or is fed by PIs, and every PO
+   * is driven by a mapped node, a PI or a constant */
+  static bool is_valid_cover(incremental_state::view_t const& view) {
+    bool valid = true;
+    view.foreach_po([&](auto const& f) {
+      auto const n = view.get_node(f);
+      valid = valid && (view.is_constant(n) || view.is_pi(n) ||
+                        view.is_cell_root(n));
+    });
+    view.foreach_gate([&](auto const& n) {
+      if (!view.is_cell_root(n)) return;
+      view.foreach_cell_fanin(n, [&](auto const& l) {
+        valid = valid && (view.is_constant(l) || view.is_pi(l) ||
+                          view.is_cell_root(l));
+      });
+    });
+    return valid;
+  }
+
+  void execute_incremental(aig_network const& aig,
+                           phyLS::lut_map_params const& ps) {
+    if (incremental && !incremental->reusable(aig, ps)) {
+      if (incremental->aig._storage != aig._storage)
+        std::cout << "[i] the stored AIG was replaced, mapping it from "
+                     "scratch; refactor -i and resub -i edit it in place\n";
+      incremental.reset(); /* release the old AIG before mapping the new */
+    }
+    if (!incremental)
+      incremental = std::make_unique<incremental_state>(aig, ps);
+
+    phyLS::lut_map_stats st;
+    cout << "Mapped AIG into " << cut_size << "-LUT (incremental) : ";
+    incremental->mapper.run(&st);
+
+    if (is_set("verify")) {
+      mapping_view<aig_network, true> full{aig};
+      phyLS::lut_map_stats full_st;
+      cout << "Mapped AIG into " << cut_size << "-LUT (from scratch) : ";
+      phyLS::lut_map(full, ps, &full_st);
+      if (!is_valid_cover(incremental->view))
+        std::cerr << "Error: the incremental mapping is not a valid cover\n";
+      std::cout << fmt::format(
+          "[i] incremental: delay = {} area = {}, from scratch: delay = {} "
+          "area = {}\n",
+          st.delay, st.area, full_st.delay, full_st.area);
+    }
+    if (is_set("output")) write_bench(incremental->view, filename);
+  }
+
   uint32_t cut_size{6u};
   uint32_t cut_limit{8u};
   uint32_t relax_required{0u};
+  uint32_t num_threads{1u};
+  std::string cost_db_file;
   std::string filename = "lut.bench";
+  std::unique_ptr<incremental_state> incremental;
 };
 
 ALICE_ADD_COMMAND(lutmap, "Mapping")
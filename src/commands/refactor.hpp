@@ -40,6 +40,9 @@ class refactor_command : public command {
     add_flag("--xmg, -x", "refactoring for XMG");
     add_flag("--akers, -a", "Refactoring with Akers synthesis for MIG");
     add_flag("--gain, -n", "optimize until there is no gain");
+    add_flag("--in_place, -i",
+             "AIG only: edit the stored AIG in place without cleanup, so "
+             "that lutmap -i remaps only the changed nodes");
     add_flag("--verbose, -v", "print the information");
   }
 
@@ -128,12 +131,15 @@ class refactor_command : public command {
         refactoring_params ps;
         ps.max_pis = cut_size;
         refactoring(aig, aig_resyn, ps);
-        aig = cleanup_dangling(aig);
+        /* in place, the handle shares the storage of the stored AIG */
+        if (!is_set("in_place")) aig = cleanup_dangling(aig);
         end = clock();
         totalTime = (double)(end - begin) / CLOCKS_PER_SEC;
         phyLS::print_stats(aig);
-        store<aig_network>().extend();
-        store<aig_network>().current() = aig;
+        if (!is_set("in_place")) {
+          store<aig_network>().extend();
+          store<aig_network>().current() = aig;
+        }
       }
     }
 
@@ -47,6 +47,9 @@ class resub_command : public command {
     add_flag("--mig, -m", "Resubstitution for MIG");
     add_flag("--xag, -g", "Resubstitution for XAG");
     add_flag("--simulation, -s", "Simulation-guided resubstitution for AIG");
+    add_flag("--in_place, -i",
+             "AIG only: edit the stored AIG in place without cleanup, so "
+             "that lutmap -i remaps only the changed nodes");
     add_flag("--verbose, -v", "print the information");
   }
 
@@ -115,7 +118,7 @@ class resub_command : public command {
         if (is_set("simulation")) {
           begin = clock();
           sim_resubstitution(aig);
-          aig = cleanup_dangling(aig);
+          if (!is_set("in_place")) aig = cleanup_dangling(aig);
           end = clock();
           totalTime = (double)(end - begin) / CLOCKS_PER_SEC;
         } else {
@@ -124,13 +127,16 @@ class resub_command : public command {
           fanout_view<aig_network> fanout_view{aig};
           view_t resub_view{fanout_view};
           aig_resubstitution(resub_view);
-          aig = cleanup_dangling(aig);
+          if (!is_set("in_place")) aig = cleanup_dangling(aig);
           end = clock();
           totalTime = (double)(end - begin) / CLOCKS_PER_SEC;
         }
         phyLS::print_stats(aig);
-        store<aig_network>().extend();
-        store<aig_network>().current() = aig;
+        /* in place, the handle shares the storage of the stored AIG */
+        if (!is_set("in_place")) {
+          store<aig_network>().extend();
+          store<aig_network>().current() = aig;
+        }
       }
     }
 
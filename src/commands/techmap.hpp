@@ -27,6 +27,7 @@
  #include "../core/properties.hpp"
  #include "../core/read_placement_file.hpp"
  #include "../core/RUDY.hpp"
+ #include "../core/library_registry.hpp"
  #include "../core/mapper_RUDY.hpp"
  // #include "../core/phymap.hpp"
  // #include <mockturtle/algorithms/phymap.hpp>
@@ -46,6 +47,31 @@
      add_option("--node_position_pl, -p", pl_filename, "the pl filename");
      add_option("--node_position_def, -d", def_filename, "the def filename");
      add_flag("--rudy, -r", "RUDY-based standard cell mapping");
+     add_option("--threads, -j", num_threads,
+                "Number of threads for RUDY-based matching, 0 uses all cores "
+                "[default = 1]");
+     add_option("--tile_size", rudy_ps.tile_size,
+                "Tile size of the RUDY map [default = 600]");
+     add_option("--wire_width", rudy_ps.wire_width,
+                "Wire width of the RUDY map [default = 12]");
+     add_option("--h_capacity", rudy_ps.h_capacity,
+                "Horizontal routing capacity of a tile [default = 100]");
+     add_option("--v_capacity", rudy_ps.v_capacity,
+                "Vertical routing capacity of a tile [default = 100]");
+     add_option("--threshold", rudy_ps.threshold,
+                "Utilization above which a RUDY tile is a hotspot "
+                "[default = 1]");
+     add_option("--heatmap", heatmap_filename,
+                "write the RUDY map as a binary heatmap");
+     add_flag("--sta, -s",
+              "report slacks and the critical path of the RUDY-based mapping");
+     add_option("--wire_model", wire_model,
+                "wire delay model of the STA: none, hpwl or elmore "
+                "[default = elmore]");
+     add_option("--wire_r", sta_ps.resistance,
+                "wire resistance per placement unit [default = 0]");
+     add_option("--wire_c", sta_ps.capacitance,
+                "wire capacitance per placement unit [default = 0]");
      add_flag("--area, -a", "Area-only standard cell mapping");
      add_flag("--delay, -e", "Delay-only standard cell mapping");
      add_flag("--performance, -w",
@@ -68,13 +94,18 @@
    std::string def_filename = "";
    uint32_t cut_limit{49u};
    double trade_off = 0.0;
+   uint32_t num_threads{1u};
+   phyLS::rudy_params rudy_ps;
+   std::string heatmap_filename = "";
+   std::string wire_model = "elmore";
+   phyLS::sta_params sta_ps;
  
   protected:
    void execute() {
      /* derive genlib */
-     std::vector<mockturtle::gate> gates =
-         store<std::vector<mockturtle::gate>>().current();
-     mockturtle::tech_library<5> lib(gates);
+     auto const lib_ptr = phyLS::library_registry::instance().technology(
+         store<std::vector<mockturtle::gate>>().current());
+     auto const& lib = *lib_ptr;
  
      mockturtle::map_params ps;
      mockturtle::map_stats st;
@@ -175,10 +206,29 @@
          if (store<aig_network>().size() == 0u) {
            std::cerr << "[e] no AIG in the store\n";
          } else {
+           if (rudy_ps.tile_size <= 0) {
+             std::cerr << "[e] --tile_size must be positive\n";
+             return;
+           }
            auto aig = store<aig_network>().current();
            std::vector<mockturtle::node_position> nps(aig.size() + aig.num_pos());;
            phyLS::read_def_file(def_filename, nps, aig.num_pis());
-           auto res = mockturtle::phymap(aig, lib, nps, ps, &st);
+           mockturtle::phy_map_params pps;
+           pps.num_threads = num_threads;
+           pps.rudy = rudy_ps;
+           pps.report_timing = is_set("sta");
+           pps.sta = sta_ps;
+           pps.sta.num_threads = num_threads;
+           if (!phyLS::parse_wire_model(wire_model, pps.sta.wires)) {
+             std::cerr << "[e] unknown wire model " << wire_model << "\n";
+             return;
+           }
+           if (pps.report_timing && pps.sta.wires != phyLS::wire_model::none &&
+               pps.sta.resistance == 0.0 && pps.sta.capacitance == 0.0)
+             std::cerr << "[w] wire model " << wire_model
+                       << " without wire RC adds no wire delay, set --wire_r "
+                          "and --wire_c\n";
+           auto res = mockturtle::phymap(aig, lib, nps, ps, &st, pps);
            if (is_set("output")) write_verilog_with_binding(res, filename);
            std::cout << fmt::format(
                "Mapped AIG into #gates = {}, area = {:.2f}, delay = {:.2f}, "
@@ -186,9 +236,17 @@
                "{:.2f}\n",
                res.num_gates(), st.area, st.delay, st.power, st.wirelength,
                st.total_wirelength);
-           phyLS::RUDY rudy_map(&nps, &aig, aig.num_pis(), aig.num_pos());
-           rudy_map.calculateRudy();
-           rudy_map.show();
+           phyLS::RUDY rudy_map(&nps, &aig, aig.num_pis(), aig.num_pos(),
+                                rudy_ps);
+           /* the fine map is only computed for the heatmap */
+           if (is_set("heatmap")) {
+             rudy_map.calculateRudy();
+             rudy_map.report();
+             if (!rudy_map.writeHeatmap(heatmap_filename))
+               std::cerr << "[e] cannot write " << heatmap_filename << "\n";
+           } else {
+             rudy_map.reportHotspots();
+           }
          }
        } else {
          if (store<aig_network>().size() == 0u) {
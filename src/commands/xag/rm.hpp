@@ -26,6 +26,9 @@ class xagopt_command : public command {
   explicit xagopt_command(const environment::ptr& env)
       : command(env, "Performs two-level RM logic optimization") {
     add_option("strategy, -s", strategy, "cut = 0, mffc = 1");
+    add_option("cut_size, -k", cut_size,
+               "maximum number of cut (or MFFC) inputs, at most 12 "
+               "[default = 6]");
     add_flag("--minimum_and_gates, -m",
              "minimum multiplicative complexity in XAG");
     add_flag("--xag, -g", "RM logic optimization for xag network");
@@ -37,12 +40,18 @@ class xagopt_command : public command {
     if (is_set("xmg")) {
       return {has_store_element<xmg_network>(env),
               {[this]() { return (strategy <= 1 && strategy >= 0); },
-               "strategy must in [0,1] "}};
+               "strategy must in [0,1] "},
+              {[this]() { return (cut_size >= 2u && cut_size <= 12u); },
+               "cut_size must in [2,12], each cone visits 3^cut_size "
+               "polarities (531441 at 12) "}};
     }
 
     return {has_store_element<xag_network>(env),
             {[this]() { return (strategy <= 1 && strategy >= 0); },
-             "strategy must in [0,1] "}};
+             "strategy must in [0,1] "},
+            {[this]() { return (cut_size >= 2u && cut_size <= 12u); },
+             "cut_size must in [2,12], each cone visits 3^cut_size "
+             "polarities (531441 at 12) "}};
   }
 
  protected:
@@ -52,6 +61,7 @@ class xagopt_command : public command {
       // start = clock();
       mockturtle::xag_network xag = store<xag_network>().current();
       /* parameters */
+      ps_ntk.cut_size = cut_size;
       ps_ntk.multiplicative_complexity = is_set("minimum_and_gates");
 
       if (strategy == 0)
@@ -92,6 +102,7 @@ class xagopt_command : public command {
       // start = clock();
       mockturtle::xmg_network xmg = store<xmg_network>().current();
       /* parameters */
+      ps_ntk.cut_size = cut_size;
       if (strategy == 0)
         ps_ntk.strategy = rm_rewriting_params::cut;
       else if (strategy == 1)
@@ -129,6 +140,7 @@ class xagopt_command : public command {
 
  private:
   int strategy = 0;
+  uint32_t cut_size = 6u;
   rm_rewriting_params ps_ntk;
 };
 
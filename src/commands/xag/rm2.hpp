@@ -26,6 +26,13 @@ class xagopt2_command : public command {
   explicit xagopt2_command(const environment::ptr& env)
       : command(env, "Performs multi-level RM logic optimization") {
     add_option("strategy, -s", strategy, "cut = 0, mffc = 1");
+    add_option("cut_size, -k", cut_size,
+               "maximum number of cut (or MFFC) inputs, at most 12 "
+               "[default = 6]");
+    add_option("threads, -t", num_threads,
+               "threads computing RM forms, 0 = all cores; with MFFCs, more "
+               "than one skips gates by a gain estimated up front and may "
+               "differ from one thread [default = 1]");
     add_flag("--minimum_and_gates, -m",
              "minimum multiplicative complexity in XAG");
     add_flag("--xag, -g", "RM logic optimization for xag network");
@@ -37,12 +44,18 @@ class xagopt2_command : public command {
     if (is_set("xmg")) {
       return {has_store_element<xmg_network>(env),
               {[this]() { return (strategy <= 1 && strategy >= 0); },
-               "strategy must in [0,1] "}};
+               "strategy must in [0,1] "},
+              {[this]() { return (cut_size >= 2u && cut_size <= 12u); },
+               "cut_size must in [2,12], each cone visits 3^cut_size "
+               "polarities (531441 at 12) "}};
     }
 
     return {has_store_element<xag_network>(env),
             {[this]() { return (strategy <= 1 && strategy >= 0); },
-             "strategy must in [0,1] "}};
+             "strategy must in [0,1] "},
+            {[this]() { return (cut_size >= 2u && cut_size <= 12u); },
+             "cut_size must in [2,12], each cone visits 3^cut_size "
+             "polarities (531441 at 12) "}};
   }
 
  protected:
@@ -53,6 +66,7 @@ class xagopt2_command : public command {
       mockturtle::xag_network xag = store<xag_network>().current();
       /* parameters */
       ps_ntk.multiplicative_complexity = is_set("minimum_and_gates");
+      ps_ntk.num_threads = num_threads;
 
       if (strategy == 0)
         ps_ntk.strategy = rm_rewriting_params2::cut;
@@ -67,7 +81,7 @@ class xagopt2_command : public command {
       // depth_view<mockturtle::xag_network,unit_cost<mockturtle::xag_network>>
       // depth_xag1(xag);
       cut_rewriting_params ps;
-      ps.cut_enumeration_ps.cut_size = 6;
+      ps.cut_enumeration_ps.cut_size = cut_size;
       ps.cut_enumeration_ps.cut_limit = 12;
       ps.min_cand_cut_size = 2;
       ps.allow_zero_gain = true;
@@ -99,6 +113,7 @@ class xagopt2_command : public command {
       // start = clock();
       mockturtle::xmg_network xmg = store<xmg_network>().current();
       /* parameters */
+      ps_ntk.num_threads = num_threads;
       if (strategy == 0)
         ps_ntk.strategy = rm_rewriting_params2::cut;
       else if (strategy == 1)
@@ -110,7 +125,7 @@ class xagopt2_command : public command {
       xmg1 = xmg;
 
       cut_rewriting_params ps;
-      ps.cut_enumeration_ps.cut_size = 6;
+      ps.cut_enumeration_ps.cut_size = cut_size;
       ps.cut_enumeration_ps.cut_limit = 12;
       ps.min_cand_cut_size = 2;
       ps.allow_zero_gain = true;
@@ -141,6 +156,8 @@ class xagopt2_command : public command {
 
  private:
   int strategy = 0;
+  uint32_t cut_size = 6u;
+  uint32_t num_threads = 1u;
   rm_rewriting_params2 ps_ntk;
 };
 
@@ -1,8 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <fstream>
+#include <iomanip>
 #include <limits>
 #include <iostream>
+#include <string>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <assert.h>
 #include <vector>
@@ -43,6 +50,18 @@ public:
   }
 };
 
+using StateId = uint32_t;
+constexpr StateId no_state = std::numeric_limits<StateId>::max();
+
+// key of the action sequence leading to a child, from the key of its father
+inline uint64_t child_key(uint64_t father_key, uint32_t action)
+{
+  uint64_t x = father_key ^ (0x9e3779b97f4a7c15ull * (action + 1));
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
 struct State
 {
   // long term effect
@@ -63,15 +82,21 @@ struct State
   bool is_root {false};
   // if search should be terminated
   bool terminal_flag {false};
+  // if the reward was obtained in this run, loaded statistics are not
+  bool evaluated {false};
 
-  // position of the state
-  std::vector<State> children;
+  // action taken from the father
+  uint32_t action {0};
+  // children are stored consecutively in the arena, from first_child
+  StateId first_child { no_state };
   // father node
-  State* father { nullptr };
-  // index of the node in state network
-  std::string position = "R";
+  StateId father { no_state };
+  // hash of the action sequence leading to the node
+  uint64_t key {0};
+  // state of the implement after reaching the node, if it is cached
+  std::shared_ptr<const void> snapshot;
 
-  bool terminal()
+  bool terminal() const
   {
     return terminal_flag;
   }
@@ -85,20 +110,81 @@ struct MCTS_params
   uint32_t action_size { 4 };
   double PUCT { 50 };
   double lambda { 0.4 };
+  // number of independent searches run in parallel, 0 uses all cores
+  uint32_t num_threads { 1 };
+  // number of tree nodes caching the implement state, 0 replays every
+  // iteration from the root
+  uint32_t max_snapshots { 1024 };
+  // wall-clock budget of the search in seconds, 0 means no limit
+  double time_budget { 0 };
+  // stop after this many iterations without a better reward, 0 disables
+  uint32_t early_stop { 0 };
+  // statistics file to warm-start the search from, and to save it to
+  std::string load_statistics;
+  std::string save_statistics;
+  // intermediate results: record every n-th step only, or only those that
+  // improve on the last recorded one
+  uint32_t record_every { 1 };
+  bool record_improvements { false };
+  // gzip the result files and bound the queue of the writer thread
+  bool compress_results { false };
+  uint32_t writer_capacity { 16 };
+  // time results with the built-in placement-aware STA instead of ABC, with
+  // wire model none, hpwl or elmore and RC per placement unit
+  bool native_sta { false };
+  std::string wire_model { "elmore" };
+  double wire_resistance { 0 };
+  double wire_capacitance { 0 };
+};
+
+// best rewards shared by searches running in parallel, so that results
+// are only recorded when they improve on every search
+struct SharedBest
+{
+  std::mutex mutex;
+  double best_reward = std::numeric_limits<double>::max();
+  double best_mulReward = std::numeric_limits<double>::max();
+};
+
+// statistics of one action taken from the root
+struct ActionStatistic
+{
+  uint32_t visited {0};
+  double Q {std::numeric_limits<double>::lowest()};
+  double reward {std::numeric_limits<double>::max()};
 };
 
+// merges the root statistics of independent searches: visits are summed,
+// the best long term effect and reward are kept
+inline std::vector<ActionStatistic> merge_root_statistics(std::vector<std::vector<ActionStatistic>> const& roots)
+{
+  std::vector<ActionStatistic> merged;
+  for (auto const& root : roots)
+  {
+    if (merged.size() < root.size()) merged.resize(root.size());
+    for (size_t i = 0; i < root.size(); i++)
+    {
+      merged[i].visited += root[i].visited;
+      if (root[i].visited == 0) continue;
+      merged[i].Q = std::max(merged[i].Q, root[i].Q);
+      merged[i].reward = std::min(merged[i].reward, root[i].reward);
+    }
+  }
+  return merged;
+}
+
 /*  The input implement should has following funtion:
       reward = take_action(int action) --> with given action, take action and return a reward
       terminal() --> if the agent should be terminated 
+      snapshot() / restore(snapshot) --> save and resume the state of the implement
     The Position should has following function:
 */
 template<typename Implement>
 class MCTS_impl
 {
-  using DictState = std::unordered_map<std::string, State*>;
-  using VecSequence = std::vector<char>;
+  using TranspositionTable = std::unordered_map<uint64_t, StateId>;
 public: 
-  explicit MCTS_impl(Implement& MCTS_imple, MCTS_params const& ps): imple(MCTS_imple), param(ps), \
+  explicit MCTS_impl(Implement& MCTS_imple, MCTS_params const& ps, SharedBest* shared = nullptr): imple(MCTS_imple), param(ps), shared(shared), \
                                                 action_size(ps.action_size), search_length_limit(param.sequence_length)
   {
     initialize_MCTS();
@@ -107,18 +193,91 @@ public:
   void run()
   {
     // std::cout<<"run\n";
-    State* node_ptr = &root;
+    auto const start = std::chrono::steady_clock::now();
+    uint32_t stale = 0;
 
     for ( uint32_t i = 0; i < param.search_iteration; i++ )
     {
+      if (param.time_budget > 0 &&
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= param.time_budget)
+      {
+        std::cout << "time budget reached after " << i << " iterations\n";
+        break;
+      }
+
       // std::cout << "Iteration " << i << std::endl;
-      root.visited++;
-      auto prt = iter(root);
+      double const last_reward = best_reward;
+      double const last_mulReward = best_mulReward;
+      states[root].visited++;
+      iter(root);
+
+      stale = (best_reward < last_reward || best_mulReward < last_mulReward) ? 0 : stale + 1;
+      if (param.early_stop > 0 && stale >= param.early_stop)
+      {
+        std::cout << "no improvement in " << stale << " iterations, stopped after " << i + 1 << " iterations\n";
+        break;
+      }
 
       // std::cout << "Current state: " << imple.get_state() << ", Reward: " << imple.get_reward() << std::endl;
     }
   }
 
+  // statistics of the children of the root
+  std::vector<ActionStatistic> root_statistics() const
+  {
+    std::vector<ActionStatistic> stats(action_size);
+    for (int a = 0; a < action_size; a++)
+    {
+      auto const& child = states[states[root].first_child + a];
+      stats[a].visited = child.visited;
+      if (child.visited == 0) continue;
+      stats[a].Q = child.Q + child.R;
+      stats[a].reward = child.reward;
+    }
+    return stats;
+  }
+
+  /* Saves the statistics of the tree, one node per line after a header:
+   *   MCTS <version> <action_size> <number of nodes>
+   *   <key> <father key> <action> <visited> <Q> <R> <P> <reward> <terminal>
+   * keys are hexadecimal and fathers come before their children. */
+  bool save(std::string const& filename) const
+  {
+    std::ofstream out(filename);
+    if (!out.is_open()) return false;
+
+    out << "MCTS 1 " << action_size << " " << states.size() << "\n";
+    out << std::setprecision(17);
+    for (auto const& state : states)
+    {
+      out << std::hex << state.key << " ";
+      if (state.father == no_state) out << "-";
+      else out << states[state.father].key;
+      out << std::dec << " " << state.action << " " << state.visited << " " << state.Q
+          << " " << state.R << " " << state.P << " " << state.reward << " " << state.terminal_flag << "\n";
+    }
+    return true;
+  }
+
+  /* Warm-starts the search with statistics saved by `save`.  Nodes are found
+   * by the key of their action sequence, so the file must come from the same
+   * actions; rewards of loaded nodes are not taken as results of this run. */
+  bool load(std::string const& filename)
+  {
+    /* a file that cannot be applied completely leaves the tree unchanged */
+    auto saved_states = states;
+    auto saved_table = table;
+    if (load_states(filename)) return true;
+    states = std::move(saved_states);
+    table = std::move(saved_table);
+    return false;
+  }
+
+  size_t num_states() const
+  {
+    return states.size();
+  }
+
   Implement* get()
   {
     if ( !imple.terminal()) {
@@ -127,38 +286,121 @@ public:
     return &imple;
   }
 private:
+  bool load_states(std::string const& filename)
+  {
+    std::ifstream in(filename);
+    if (!in.is_open()) return false;
+
+    std::string magic;
+    uint32_t version = 0, file_action_size = 0;
+    size_t num_states = 0;
+    if (!(in >> magic >> version >> file_action_size >> num_states) || magic != "MCTS" || version != 1)
+    {
+      std::cerr << "[e] " << filename << " is not an MCTS statistics file\n";
+      return false;
+    }
+    if (static_cast<int>(file_action_size) != action_size)
+    {
+      std::cerr << "[e] " << filename << " was saved with " << file_action_size << " actions, the search uses " << action_size << "\n";
+      return false;
+    }
+
+    for (size_t i = 0; i < num_states; i++)
+    {
+      std::string key_str, father_str;
+      State loaded;
+      if (!(in >> key_str >> father_str >> loaded.action >> loaded.visited >> loaded.Q >> loaded.R
+              >> loaded.P >> loaded.reward >> loaded.terminal_flag))
+      {
+        std::cerr << "[e] truncated MCTS statistics file " << filename << "\n";
+        return false;
+      }
+
+      StateId id = root;
+      if (father_str != "-")
+      {
+        auto const father = table.find(std::stoull(father_str, nullptr, 16));
+        if (father == table.end() || loaded.action >= static_cast<uint32_t>(action_size))
+        {
+          std::cerr << "[e] unknown node " << key_str << " in " << filename << "\n";
+          return false;
+        }
+        if (states[father->second].first_child == no_state) init_node(father->second);
+        id = states[father->second].first_child + loaded.action;
+        states[id].P = loaded.P;
+        states[id].reward = loaded.reward;
+        states[id].terminal_flag = loaded.terminal_flag;
+      }
+      if (states[id].key != std::stoull(key_str, nullptr, 16))
+      {
+        std::cerr << "[e] node " << key_str << " in " << filename << " does not match the search\n";
+        return false;
+      }
+      states[id].visited += loaded.visited;
+      states[id].Q = loaded.Q;
+      states[id].R = loaded.R;
+    }
+    return true;
+  }
+
   // Initialize nodes in MCTS
   void initialize_MCTS()
   {
     // std::cout<<"initialize_mcts\n";
-    root.is_root = true;
+    root = static_cast<StateId>(states.size());
+    auto& state = states.emplace_back();
+    state.is_root = true;
+    state.evaluated = true;
+    state.key = child_key(0, action_size);
+    table[state.key] = root;
     init_node(root);
-    root.visited++;
+    states[root].visited++;
     auto baseline = imple.initialize();
-    root.reward = baseline;
+    states[root].reward = baseline;
+    take_snapshot(root);
+  }
+
+  void take_snapshot(StateId id)
+  {
+    if (num_snapshots >= param.max_snapshots) return;
+    states[id].snapshot = imple.snapshot();
+    num_snapshots++;
+  }
+
+  // brings the implement to the deepest cached state of the current path
+  void resume()
+  {
+    if (!pending) return;
+    imple.restore(pending);
+    pending.reset();
   }
 
   // produce a gaussian noise distributed by normal distribution
   double gaussian_rand(double m = 0.0, double v = 1)
   {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-
     std::normal_distribution<double> gaussian(m, v);
 
     return gaussian(gen);
   }
 
-  void init_node(State& node)
+  void init_node(StateId id)
   {
     // std::cout<<"action_size : "<<action_size<<"\n";
+    auto const first = static_cast<StateId>(states.size());
+    auto const key = states[id].key;
     for (int i = 0; i < action_size; i++)
     {
-      State& child = node.children.emplace_back();
-      child.father = &node;
-      child.position = node.position + std::to_string(i);
+      State& child = states.emplace_back();
+      child.father = id;
+      child.action = i;
+      child.key = child_key(key, i);
       child.P = param.PUCT * (0.98 * 1/action_size + 0.02 * gaussian_rand(0.0, 1.0));
+      if (!table.emplace(child.key, first + i).second)
+      {
+        std::cerr << "action sequence hash collision\n";
+      }
     }
+    states[id].first_child = first;
   }
 
   double getValue(State const& node)
@@ -166,54 +408,55 @@ private:
     return (node.R + node.Q + get_U(node));
   }
 
-  int bestAction(State const& node)
+  int bestAction(StateId id)
   {
     double best_value = std::numeric_limits<double>::lowest();
     int best_action = -1;
-    int crt = -1;
-    for (auto& child : node.children)
+    for (int a = 0; a < action_size; a++)
     {
-      crt++;
-      double value = getValue(child);
+      double value = getValue(states[states[id].first_child + a]);
 
       if ( value > best_value )
       {
         best_value = value;
-        best_action = crt;
+        best_action = a;
       }
     }
     return best_action;
   }
 
-  void simulate(State& node)
+  void simulate(StateId id)
   { 
     // generate a seed of random integer
-    init_node(node);
+    init_node(id);
   }
 
-  State* iter(State& node)
+  StateId iter(StateId node)
   {
-    if (iteration > 0) imple.reinit();
+    // resume from the deepest cached ancestor instead of replaying the path
+    if (iteration > 0)
+    {
+      if (states[node].snapshot) pending = states[node].snapshot;
+      else imple.reinit();
+    }
     // std::cout<<"iteration : "<<iteration<<"\n";
     int i = 0;
-    State* res = &node;
-    State* r;
-    while (!r->terminal() && i < search_length_limit)
+    position = "R";
+    StateId res = node;
+    StateId r = res;
+    while (!states[r].terminal() && i < search_length_limit)
     {
       r = res;
-      res = forward(*res, i);
+      res = forward(res, i);
       i++;
       // std::cout<<"search depth is : "<<i<<"\t";
       // if(r->terminal()) std::cout<<"the node is set terminated\n";
     } 
+    resume();
 
-    while (!res->is_root) 
+    while (!states[res].is_root) 
     {
-      if (res->father == nullptr)
-      {
-        std::cerr<<"Father node is nullptr\n";
-      }
-      res = backpropagate(*res);
+      res = backpropagate(res);
     }     
 
     iteration++;
@@ -225,9 +468,9 @@ private:
   
 
   // search forward for aquiring reward
-  State* forward(State& node, int depth = 0)
+  StateId forward(StateId node, int depth = 0)
   {
-    // std::cout<<"searching position : "<<node.position<<"\n";
+    // std::cout<<"searching position : "<<position<<"\n";
     /* the action is an integer */
     int action = bestAction(node);
     if (action < 0)
@@ -237,31 +480,32 @@ private:
     }
     // std::cout<<"\nThe best action is "<<action<<"\n";
 
-    State& picked_child = node.children[action];
-    std::string position = node.position + std::to_string(action);
+    StateId const picked = states[node].first_child + action;
+    position += std::to_string(action);
+    if (states[picked].snapshot)
+    {
+      /* the state is cached, only the statistics are updated */
+      pending = states[picked].snapshot;
+      states[picked].R = get_R(states[picked]);
+      states[picked].visited++;
+      return picked;
+    }
+    resume();
+
     // expand a new node if it's unvisited
-    if (!picked_child.visited)
+    if (states[picked].first_child == no_state)
     {
-      if (state_ntk.find(position) == state_ntk.end())
-      {
-        init_node(picked_child);
-        state_ntk[position] = &picked_child;
-      }
-      else
-      {
-        std::cerr << "node at position"<<picked_child.position
-              <<" is unvisited but has been in state ntk\n";
-        throw std::out_of_range("Invalid action choice");
-      }
+      init_node(picked);
     }
 
     /* compute reward */
     double reward = imple.take_action(action, depth);
 
-    imple.record_result(picked_child.position);
-    if ( node.children[action].visited ) 
+    imple.record_result(position);
+    auto& picked_child = states[picked];
+    if ( picked_child.evaluated ) 
     { 
-      // std::cout<<"Visited child's reward = "<<node.children[action].reward<<".\t"
+      // std::cout<<"Visited child's reward = "<<picked_child.reward<<".\t"
       //   <<"Computed reward = "<<reward<<"\n"; 
       
     }
@@ -270,12 +514,12 @@ private:
       double mulReward = imple.get_mulReward();
       if (reward < best_reward) { 
         best_reward = reward;
-        imple.record_bestResult();
+        record_best(reward, &SharedBest::best_reward, [&]{ imple.record_bestResult(); });
       }
       if (mulReward < best_mulReward)
       {
         best_mulReward = mulReward;
-        imple.record_mulResult();
+        record_best(mulReward, &SharedBest::best_mulReward, [&]{ imple.record_mulResult(); });
       }
     }
     // std::cout<<"reward : "<<reward<<"\n";
@@ -285,26 +529,46 @@ private:
     picked_child.reward = reward;
     picked_child.R = get_R(picked_child);  
     picked_child.visited++;
+    picked_child.evaluated = true;
+    take_snapshot(picked);
+
+    return picked;
+  }
 
-    return &picked_child;
+  // records a result unless a parallel search already recorded a better one
+  template<typename Fn>
+  void record_best(double value, double SharedBest::*best, Fn&& record)
+  {
+    if (shared == nullptr)
+    {
+      record();
+      return;
+    }
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    if (value < shared->*best)
+    {
+      shared->*best = value;
+      record();
+    }
   }
 
-  State* backpropagate(State& node)
+  StateId backpropagate(StateId id)
   {
-    State* father = node.father;
-    if ( ((node.Q + node.R) * param.lambda) > father->Q )
+    auto const& node = states[id];
+    auto& father = states[node.father];
+    if ( ((node.Q + node.R) * param.lambda) > father.Q )
     {
-      father->Q = (node.Q + node.R) * param.lambda;
-      // std::cout<<"updated father "<<father->position<<" to "<<father->Q<<"\n";
+      father.Q = (node.Q + node.R) * param.lambda;
+      // std::cout<<"updated father "<<node.father<<" to "<<father.Q<<"\n";
     }
-    return father;
+    return node.father;
   }
 
   #pragma region compute statistic
   double get_R(State const& child)
   {
     double R;
-    auto const& father = *(child.father);
+    auto const& father = states[child.father];
     if (father.reward > child.reward)
     {
       R = (sqrt((father.reward - child.reward) / baseline));
@@ -318,7 +582,7 @@ private:
   double get_U(State const& child)
   {
     double U;
-    auto const& father = *(child.father);
+    auto const& father = states[child.father];
     U = child.P * (sqrt(father.visited / (child.visited + 1)));
     return U;
   }
@@ -329,9 +593,17 @@ private:
 private:
   Implement& imple;
   MCTS_params const& param;
-  DictState state_ntk;
-  VecSequence sequence;
-  State root;
+  // arena of the tree, nodes refer to each other by index
+  std::vector<State> states;
+  // node of each action sequence, by hash
+  TranspositionTable table;
+  StateId root { no_state };
+  // position of the current node, used to name recorded results
+  std::string position;
+  SharedBest* shared { nullptr };
+  std::shared_ptr<const void> pending;
+  uint32_t num_snapshots {0};
+  std::mt19937 gen { std::random_device{}() };
   
   /*  */
   int iteration {0};
@@ -344,4 +616,4 @@ private:
   double best_reward = std::numeric_limits<double>::max();
   double best_mulReward = std::numeric_limits<double>::max();
 };
-} 
\ No newline at end of file
+}
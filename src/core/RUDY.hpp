@@ -1,6 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
 #include <vector>
 #include <utility>
 #include <unordered_map>
@@ -128,73 +135,210 @@ class Rect
   int _yhi = 0;
 };
 
-template <typename Ntk>
-class RUDY
+// Grid and capacity settings of a RUDY map
+struct rudy_params
+{
+  int tile_size = 600;        // tile edge length in placement units
+  int wire_width = 12;        // width of a wire in placement units
+  double h_capacity = 100.0;  // horizontal RUDY a tile can route
+  double v_capacity = 100.0;  // vertical RUDY a tile can route
+  double threshold = 1.0;     // utilization above which a tile is a hotspot
+};
+
+// A fine tile whose utilization exceeds the hotspot threshold
+struct RudyHotspot
+{
+  int x;
+  int y;
+  float utilization;
+};
+
+// Temporary RUDY on top of a committed map, only the touched tiles are
+// recorded so that clearing is proportional to them
+struct RudyOverlay
+{
+  std::vector<float> offset;      // temporary RUDY per tile
+  std::vector<uint8_t> touched;   // tile is in tiles
+  std::vector<uint32_t> tiles;    // tiles with temporary RUDY
+};
+
+// Range sums (2D Fenwick tree) and range maxima (2D segment tree) over the
+// committed RUDY of a tile grid, both updated per tile in O(log^2 tiles)
+class RudyIndex
 {
 public:
-  class Tile
+  void build(std::vector<float> const& values, int cnt_x, int cnt_y)
   {
-  public:
-    Rect getRect() const { return _rect; }
-
-    void setRect(int lx, int ly, int ux, int uy)
+    _cnt_x = cnt_x;
+    _cnt_y = cnt_y;
+
+    // Fenwick tree built in linear time, first along y, then along x
+    _sum.assign(static_cast<size_t>(cnt_x + 1) * (cnt_y + 1), 0.0);
+    for (int x = 0; x < cnt_x; ++x)
+      for (int y = 0; y < cnt_y; ++y)
+        _sum[sumIndex(x + 1, y + 1)] = values[static_cast<size_t>(x) * cnt_y + y];
+    for (int x = 1; x <= cnt_x; ++x)
+      for (int y = 1; y <= cnt_y; ++y)
+        if (int p = y + (y & -y); p <= cnt_y)
+          _sum[sumIndex(x, p)] += _sum[sumIndex(x, y)];
+    for (int x = 1; x <= cnt_x; ++x)
+      if (int p = x + (x & -x); p <= cnt_x)
+        for (int y = 1; y <= cnt_y; ++y)
+          _sum[sumIndex(p, y)] += _sum[sumIndex(x, y)];
+
+    // Segment tree with leaves at [cnt_x, 2 cnt_x) x [cnt_y, 2 cnt_y)
+    _max.assign(static_cast<size_t>(2 * cnt_x) * (2 * cnt_y), std::numeric_limits<float>::lowest());
+    for (int x = 0; x < cnt_x; ++x)
     {
-      _rect = Rect(lx, ly, ux, uy);
+      const int i = x + cnt_x;
+      for (int y = 0; y < cnt_y; ++y)
+        _max[maxIndex(i, y + cnt_y)] = values[static_cast<size_t>(x) * cnt_y + y];
+      for (int j = cnt_y - 1; j > 0; --j)
+        _max[maxIndex(i, j)] = std::max(_max[maxIndex(i, 2 * j)], _max[maxIndex(i, 2 * j + 1)]);
     }
+    for (int i = cnt_x - 1; i > 0; --i)
+      for (int j = 1; j < 2 * cnt_y; ++j)
+        _max[maxIndex(i, j)] = std::max(_max[maxIndex(2 * i, j)], _max[maxIndex(2 * i + 1, j)]);
+  }
+
+  // Tile (x, y) changed by delta to value
+  void update(int x, int y, double delta, float value)
+  {
+    for (int i = x + 1; i <= _cnt_x; i += i & -i)
+      for (int j = y + 1; j <= _cnt_y; j += j & -j)
+        _sum[sumIndex(i, j)] += delta;
+
+    int i = x + _cnt_x;
+    const int leaf_j = y + _cnt_y;
+    _max[maxIndex(i, leaf_j)] = value;
+    for (int j = leaf_j >> 1; j > 0; j >>= 1)
+      _max[maxIndex(i, j)] = std::max(_max[maxIndex(i, 2 * j)], _max[maxIndex(i, 2 * j + 1)]);
+    for (i >>= 1; i > 0; i >>= 1)
+      for (int j = leaf_j; j > 0; j >>= 1)
+        _max[maxIndex(i, j)] = std::max(_max[maxIndex(2 * i, j)], _max[maxIndex(2 * i + 1, j)]);
+  }
+
+  // Sum over the tiles [x0, x1] x [y0, y1]
+  double sum(int x0, int y0, int x1, int y1) const
+  {
+    return prefix(x1 + 1, y1 + 1) - prefix(x0, y1 + 1) - prefix(x1 + 1, y0) + prefix(x0, y0);
+  }
+
+  // Maximum over the tiles [x0, x1] x [y0, y1]
+  float max(int x0, int y0, int x1, int y1) const
+  {
+    auto const row = [&](int i) {
+      float result = std::numeric_limits<float>::lowest();
+      for (int l = y0 + _cnt_y, r = y1 + _cnt_y + 1; l < r; l >>= 1, r >>= 1)
+      {
+        if (l & 1) result = std::max(result, _max[maxIndex(i, l++)]);
+        if (r & 1) result = std::max(result, _max[maxIndex(i, --r)]);
+      }
+      return result;
+    };
 
-    void addRudy(double rudy) { _rudy += rudy; }
-    void addOffset(double offset) { _offset += offset; }
-    template <bool TEMP = false>
-    double getRudy() const { return _rudy; }
-    double getOffset() const { return _offset; }
-    void setRudy(double rudy) { _rudy = rudy; }
-    void setOffset(double offset) { _offset = offset; }
-    void clearRudy() { 
-      _rudy = 0.0;
-      _offset = 0.0;
+    float result = std::numeric_limits<float>::lowest();
+    for (int l = x0 + _cnt_x, r = x1 + _cnt_x + 1; l < r; l >>= 1, r >>= 1)
+    {
+      if (l & 1) result = std::max(result, row(l++));
+      if (r & 1) result = std::max(result, row(--r));
     }
+    return result;
+  }
 
-  private:
-    Rect _rect;
-    float _rudy = 0.0f;
-    float _offset = 0.0f;
-  };
+private:
+  double prefix(int x, int y) const
+  {
+    double result = 0.0;
+    for (int i = x; i > 0; i -= i & -i)
+      for (int j = y; j > 0; j -= j & -j)
+        result += _sum[sumIndex(i, j)];
+    return result;
+  }
 
-  struct TemporaryRudy {
-    TemporaryRudy(int x, int y, double offset) : x(x), y(y), offset(offset) {}
-    int x;
-    int y;
-    double offset;
-  };
+  size_t sumIndex(int i, int j) const { return static_cast<size_t>(i) * (_cnt_y + 1) + j; }
+  size_t maxIndex(int i, int j) const { return static_cast<size_t>(i) * (2 * _cnt_y) + j; }
+
+  int _cnt_x = 0;
+  int _cnt_y = 0;
+  std::vector<double> _sum;
+  std::vector<float> _max;
+};
 
+template <typename Ntk>
+class RUDY
+{
+public:
   RUDY() = default;
 
-  explicit RUDY(const std::vector<node_position>* placement, const Ntk* ntk, int num_pi, int num_po) : 
+  explicit RUDY(const std::vector<node_position>* placement, const Ntk* ntk, int num_pi, int num_po,
+                rudy_params const& ps = {}) : 
                                             _placement(placement), _ntk(ntk), _num_pi(num_pi), _num_po(num_po),
-                                            _nets(ntk->size()) 
+                                            _ps(ps), _wire_width(ps.wire_width), _tile_size(ps.tile_size)
   {
-    // Set the wire width to 1 as default
-    _wire_width = 12;
     // Build up the core grid
     buildCore();
     makeGrid();
     extractNets();
   }
 
+  /**
+   * Computes the RUDY map of all nets from scratch.
+   * Each net adds a constant density over its bounding box, which is split
+   * into at most 3 x 3 blocks of tiles with a constant covered fraction and
+   * accumulated into a 2D difference array, so a net costs O(pins) and the
+   * map is integrated once with prefix sums at the end.
+   * */
   void calculateRudy()
   {
-    for (auto& grid_colun : _grids)
+    std::fill(_rudy.begin(), _rudy.end(), 0.0f);
+    std::fill(_rudy_h.begin(), _rudy_h.end(), 0.0f);
+    std::fill(_rudy_v.begin(), _rudy_v.end(), 0.0f);
+    clearOverlay(_temp);
+    _index_valid = false;
+    if (_rudy.empty())
+      return;
+
+    gatherPins();
+
+    const int stride = _tile_cnt_y + 1;
+    std::vector<double> diff_h(static_cast<size_t>(_tile_cnt_x + 1) * stride, 0.0);
+    std::vector<double> diff_v(diff_h.size(), 0.0);
+
+    for (size_t net = 0; net + 1 < _net_offsets.size(); ++net)
     {
-      for (auto& tile : grid_colun)
+      if (_net_offsets[net] == _net_offsets[net + 1])
+        continue;
+
+      const Rect net_rect = netBox(net);
+      const auto [density_h, density_v] = netDemand(net_rect);
+      if (density_h + density_v == 0.0)
+        continue;
+
+      AxisSpan const sx = axisSpan(net_rect.xMin(), net_rect.xMax(), _block_grid.xMin(), _tile_cnt_x, _block_grid.dx());
+      AxisSpan const sy = axisSpan(net_rect.yMin(), net_rect.yMax(), _block_grid.yMin(), _tile_cnt_y, _block_grid.dy());
+      if (sx.first > sx.last || sy.first > sy.last)
+        continue;
+
+      Segment segs_x[3], segs_y[3];
+      const int num_x = sx.segments(segs_x);
+      const int num_y = sy.segments(segs_y);
+      for (int i = 0; i < num_x; ++i)
       {
-        tile.clearRudy();
+        for (int j = 0; j < num_y; ++j)
+        {
+          const double frac = segs_x[i].frac * segs_y[j].frac;
+          addBlock(diff_h.data(), stride, segs_x[i], segs_y[j], density_h * frac);
+          addBlock(diff_v.data(), stride, segs_x[i], segs_y[j], density_v * frac);
+        }
       }
     }
 
-    // Consider all nets are 2-pin nets
-    for (auto net : _nets)
+    integrate(diff_h, stride, _rudy_h);
+    integrate(diff_v, stride, _rudy_v);
+    for (size_t i = 0; i < _rudy.size(); ++i)
     {
-      addNetsRudy<false>(net);
+      _rudy[i] = _rudy_h[i] + _rudy_v[i];
     }
   }
 
@@ -203,361 +347,374 @@ public:
    * If the layer which name is metal1 and it has getWidth value, then this
    * function will not applied, but it will apply that information.
    * */
-  void setWireWidth(int wire_width) { _wire_width = wire_width; }
+  void setWireWidth(int wire_width)
+  {
+    _wire_width = wire_width;
+    _ps.wire_width = wire_width;
+  }
 
-  void printGrids()
+  // Changes the tile size; the grid is rebuilt and the map must be
+  // recomputed with calculateRudy
+  void set_tile_size(int tile_size)
   {
-    for (const auto& grid : _grids)
-    {
-      std::cout << "At grid: " << grid.getRect().xMin() << " " << grid.getRect().yMin() << " " << grid.getRect().xMax() << " " << grid.getRect().yMax() << " Rudy: " << grid.getRudy() << std::endl;
-    }
+    _tile_size = tile_size;
+    _ps.tile_size = tile_size;
+    makeGrid();
   }
 
-  void show()
+  rudy_params const& params() const { return _ps; }
+  int tilesX() const { return _tile_cnt_x; }
+  int tilesY() const { return _tile_cnt_y; }
+
+  // Routing utilization of a tile: the larger of the horizontal and the
+  // vertical demand relative to the capacity of the tile
+  float utilization(int x, int y) const
   {
-    int cur_x = 0;
-    for (const auto& grid : _grids) {
-      int cur_y = 0;
-      for (const auto& tile : grid) {
-        std::cout << "At grid: [" <<  cur_x << ", " << cur_y << "] Rudy: " << tile.getRudy() << std::endl;
-        ++cur_y;
-      }
-      ++cur_x;
-    }
+    const size_t tile = tileIndex(x, y);
+    return static_cast<float>(std::max(_rudy_h[tile] / _ps.h_capacity, _rudy_v[tile] / _ps.v_capacity));
   }
 
-  template <bool TEMP = false>
-  void addNetsRudy(std::vector<int> net_pins)
+  /**
+   * Returns the fine tiles whose utilization exceeds threshold, computed from
+   * the nets without the fine map. A coarse grid of kHotspotBlock x
+   * kHotspotBlock tiles is bounded directly: a net adds its full density to
+   * every coarse tile it overlaps, which bounds the RUDY of each fine tile
+   * below. Only coarse tiles whose bound exceeds threshold are refined, by
+   * accumulating the nets that overlap them into a local difference array.
+   * Temporary and incremental edits of the map are not included.
+   * */
+  std::vector<RudyHotspot> hotspots(double threshold)
   {
-    if (net_pins.size() < 1) return;
+    std::vector<RudyHotspot> result;
+    if (_rudy.empty())
+      return result;
+    gatherPins();
 
-    // The first element of the vector is the driver node, and the rest are the fanouts
-    Rect net_rect;
-    int xmax = 0;
-    int ymax = 0;
-    int xmin = std::numeric_limits<int>::max();
-    int ymin = std::numeric_limits<int>::max();
+    struct NetSpan
+    {
+      AxisSpan sx;
+      AxisSpan sy;
+      double h;
+      double v;
+    };
+    std::vector<NetSpan> spans;
+    spans.reserve(_net_offsets.size());
+    for (size_t net = 0; net + 1 < _net_offsets.size(); ++net)
+    {
+      if (_net_offsets[net] == _net_offsets[net + 1])
+        continue;
+      const Rect net_rect = netBox(net);
+      const auto [h, v] = netDemand(net_rect);
+      if (h + v == 0.0)
+        continue;
+      AxisSpan const sx = axisSpan(net_rect.xMin(), net_rect.xMax(), _block_grid.xMin(), _tile_cnt_x, _block_grid.dx());
+      AxisSpan const sy = axisSpan(net_rect.yMin(), net_rect.yMax(), _block_grid.yMin(), _tile_cnt_y, _block_grid.dy());
+      if (sx.first <= sx.last && sy.first <= sy.last)
+        spans.push_back({sx, sy, h, v});
+    }
 
-    for (auto pin : net_pins)
+    // Upper bounds of the horizontal and vertical RUDY per coarse tile
+    const int b = kHotspotBlock;
+    const int coarse_x = (_tile_cnt_x + b - 1) / b;
+    const int coarse_y = (_tile_cnt_y + b - 1) / b;
+    const int coarse_stride = coarse_y + 1;
+    std::vector<double> bound_h(static_cast<size_t>(coarse_x + 1) * coarse_stride, 0.0);
+    std::vector<double> bound_v(bound_h.size(), 0.0);
+    for (auto const& span : spans)
     {
-      node_position fanout_np = (*_placement)[pin];
-      if (fanout_np.x_coordinate < xmin)
-        xmin = fanout_np.x_coordinate;
-      if (fanout_np.x_coordinate > xmax)
-        xmax = fanout_np.x_coordinate;
-      if (fanout_np.y_coordinate < ymin)
-        ymin = fanout_np.y_coordinate;
-      if (fanout_np.y_coordinate > ymax)
-        ymax = fanout_np.y_coordinate;
+      const Segment cx{span.sx.first / b, span.sx.last / b, 1.0};
+      const Segment cy{span.sy.first / b, span.sy.last / b, 1.0};
+      addBlock(bound_h.data(), coarse_stride, cx, cy, span.h);
+      addBlock(bound_v.data(), coarse_stride, cx, cy, span.v);
     }
-    int xlo = static_cast<int>(xmin);
-    int ylo = static_cast<int>(ymin);
-    int xhi = static_cast<int>(xmax);
-    int yhi = static_cast<int>(ymax);
-    if (xmax != xhi)
-      ++xhi; // Consider the upper bound is 1 more than the actual value
-    if (ymax != yhi)
-      ++yhi; // Consider the upper bound is 1 more than the actual value
-    net_rect.init(xlo - _wire_width / 2, ylo - _wire_width / 2, 
-                  xhi + _wire_width / 2, yhi + _wire_width / 2);
-    
-    if constexpr (TEMP) {
-      if (_operated_rect == nullptr) {
-        _operated_rect = std::make_unique<Rect>(net_rect);
-      }
-      else {
-        _operated_rect->merge(net_rect);
-      }
+    for (auto* bound : {&bound_h, &bound_v})
+    {
+      auto& d = *bound;
+      for (int x = 1; x < coarse_x; ++x)
+        for (int y = 0; y < coarse_y; ++y)
+          d[x * coarse_stride + y] += d[(x - 1) * coarse_stride + y];
+      for (int x = 0; x < coarse_x; ++x)
+        for (int y = 1; y < coarse_y; ++y)
+          d[x * coarse_stride + y] += d[x * coarse_stride + y - 1];
     }
-    
-    const auto net_area = net_rect.area();
-    if (net_area == 0)
-      std::cerr << "Error: Net area is zero" << std::endl;
-    
-    const auto hpwl = static_cast<float>(net_rect.dx() + net_rect.dy());
-    const auto wire_area = hpwl * _wire_width;
-    const auto net_congestion = wire_area / net_area;
 
-    const int min_x_index
-      = std::max(0, (net_rect.xMin() - _block_grid.xMin() ) / _tile_size);
-    const int max_x_index = std::min(
-        _tile_cnt_x - 1, (net_rect.xMax() - _block_grid.xMin()) / _tile_size);
-    const int min_y_index
-        = std::max(0, (net_rect.yMin() - _block_grid.yMin()) / _tile_size);
-    const int max_y_index = std::min(
-        _tile_cnt_y - 1, (net_rect.yMax() - _block_grid.yMin()) / _tile_size);
+    // Local difference arrays of the coarse tiles above the threshold
+    const int local_stride = b + 1;
+    const size_t local_size = static_cast<size_t>(b + 1) * local_stride;
+    std::vector<int> slot(static_cast<size_t>(coarse_x) * coarse_y, -1);
+    std::vector<std::array<int, 2>> hot;
+    for (int x = 0; x < coarse_x; ++x)
+      for (int y = 0; y < coarse_y; ++y)
+      {
+        const double h = bound_h[x * coarse_stride + y] / _ps.h_capacity;
+        const double v = bound_v[x * coarse_stride + y] / _ps.v_capacity;
+        if (std::max(h, v) <= threshold)
+          continue;
+        slot[static_cast<size_t>(x) * coarse_y + y] = static_cast<int>(hot.size());
+        hot.push_back({x, y});
+      }
+    if (hot.empty())
+      return result;
 
-    // Iterate over the tiles in the calculated range
-    for (int x = min_x_index; x <= max_x_index; ++x)
+    std::vector<double> local_h(hot.size() * local_size, 0.0);
+    std::vector<double> local_v(local_h.size(), 0.0);
+    for (auto const& span : spans)
     {
-      for (int y = min_y_index; y <= max_y_index; ++y)
-      {
-        Tile& tile = getGrid(x, y);
-        const auto tile_box = tile.getRect();
-        if (net_rect.overlaps(tile_box)) {
-          const auto intersect_area = net_rect.intersect(tile_box).area();
-          const auto tile_area = tile_box.area();
-          const auto tile_net_box_ratio = static_cast<float>(intersect_area)
-                                          / static_cast<float>(tile_area);
-          const auto rudy = net_congestion * tile_net_box_ratio * 100;
-          if constexpr (TEMP) {
-            tile.addOffset(rudy);
-            // _offset_grids.emplace_back(x, y, rudy);
-          }
-          else {
-            tile.addRudy(rudy);
+      Segment segs_x[3], segs_y[3];
+      const int num_x = span.sx.segments(segs_x);
+      const int num_y = span.sy.segments(segs_y);
+      for (int cx = span.sx.first / b; cx <= span.sx.last / b; ++cx)
+        for (int cy = span.sy.first / b; cy <= span.sy.last / b; ++cy)
+        {
+          const int k = slot[static_cast<size_t>(cx) * coarse_y + cy];
+          if (k < 0)
+            continue;
+          double* dh = &local_h[k * local_size];
+          double* dv = &local_v[k * local_size];
+          for (int i = 0; i < num_x; ++i)
+          {
+            const int lo_x = std::max(segs_x[i].lo, cx * b) - cx * b;
+            const int hi_x = std::min(segs_x[i].hi, cx * b + b - 1) - cx * b;
+            if (lo_x > hi_x)
+              continue;
+            for (int j = 0; j < num_y; ++j)
+            {
+              const int lo_y = std::max(segs_y[j].lo, cy * b) - cy * b;
+              const int hi_y = std::min(segs_y[j].hi, cy * b + b - 1) - cy * b;
+              if (lo_y > hi_y)
+                continue;
+              const double frac = segs_x[i].frac * segs_y[j].frac;
+              const Segment lx{lo_x, hi_x, 1.0};
+              const Segment ly{lo_y, hi_y, 1.0};
+              addBlock(dh, local_stride, lx, ly, span.h * frac);
+              addBlock(dv, local_stride, lx, ly, span.v * frac);
+            }
           }
         }
+    }
+
+    for (size_t k = 0; k < hot.size(); ++k)
+    {
+      const auto [cx, cy] = hot[k];
+      double* dh = &local_h[k * local_size];
+      double* dv = &local_v[k * local_size];
+      const int nx = std::min(b, _tile_cnt_x - cx * b);
+      const int ny = std::min(b, _tile_cnt_y - cy * b);
+      for (int x = 1; x < nx; ++x)
+        for (int y = 0; y < ny; ++y)
+        {
+          dh[x * local_stride + y] += dh[(x - 1) * local_stride + y];
+          dv[x * local_stride + y] += dv[(x - 1) * local_stride + y];
+        }
+      for (int x = 0; x < nx; ++x)
+      {
+        double sum_h = 0.0, sum_v = 0.0;
+        for (int y = 0; y < ny; ++y)
+        {
+          sum_h += dh[x * local_stride + y];
+          sum_v += dv[x * local_stride + y];
+          const float value = static_cast<float>(std::max(static_cast<float>(sum_h) / _ps.h_capacity,
+                                                          static_cast<float>(sum_v) / _ps.v_capacity));
+          if (value > threshold)
+            result.push_back({cx * b + x, cy * b + y, value});
+        }
       }
     }
-  }
 
-  template<bool TEMP = false>
-  void addRectRudy(double x1, double y1, double x2, double y2)
-  {
-    // The first element of the vector is the driver node, and the rest are the fanouts
-    Rect net_rect;
-    auto [xmin, xmax] = std::minmax(x1, x2);
-    auto [ymin, ymax] = std::minmax(y1, y2);
-    int xlo = static_cast<int>(xmin);
-    int ylo = static_cast<int>(ymin);
-    int xhi = static_cast<int>(xmax);
-    int yhi = static_cast<int>(ymax);
-    if (xmax != xhi)
-      ++xhi; // Consider the upper bound is 1 more than the actual value
-    if (ymax != yhi)
-      ++yhi; // Consider the upper bound is 1 more than the actual value
+    std::sort(result.begin(), result.end(), [](auto const& a, auto const& b) {
+      return a.x != b.x ? a.x < b.x : a.y < b.y;
+    });
+    return result;
+  }
 
-    net_rect.init(static_cast<int>(xlo) - _wire_width / 2, static_cast<int>(ylo) - _wire_width / 2, 
-                     static_cast<int>(xhi) + _wire_width / 2, static_cast<int>(yhi) + _wire_width / 2);
+  std::vector<RudyHotspot> hotspots() { return hotspots(_ps.threshold); }
 
-    if constexpr (TEMP) {
-      if (_operated_rect == nullptr) {
-        _operated_rect = std::make_unique<Rect>(net_rect);
-      }
-      else {
-        _operated_rect->merge(net_rect);
-      }
+  /**
+   * Writes the map as a binary heatmap (host byte order):
+   * "RUDY", uint32 version = 1, int32 tiles_x, tiles_y, tile_size, origin_x,
+   * origin_y, float32 h_capacity, v_capacity, followed by tiles_x * tiles_y
+   * float32 values each of the total, horizontal and vertical RUDY, with tile
+   * (x, y) at x * tiles_y + y.
+   * */
+  bool writeHeatmap(std::string const& filename) const
+  {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open())
+      return false;
+
+    const uint32_t version = 1;
+    const int32_t header[5] = {_tile_cnt_x, _tile_cnt_y, _tile_size, _block_grid.xMin(), _block_grid.yMin()};
+    const float capacity[2] = {static_cast<float>(_ps.h_capacity), static_cast<float>(_ps.v_capacity)};
+    out.write("RUDY", 4);
+    out.write(reinterpret_cast<char const*>(&version), sizeof(version));
+    out.write(reinterpret_cast<char const*>(header), sizeof(header));
+    out.write(reinterpret_cast<char const*>(capacity), sizeof(capacity));
+    for (auto const* grid : {&_rudy, &_rudy_h, &_rudy_v})
+    {
+      out.write(reinterpret_cast<char const*>(grid->data()), grid->size() * sizeof(float));
     }
-    
-    const auto net_area = net_rect.area();
-    if (net_area == 0)
-      std::cerr << "Error: Net area is zero" << std::endl;
-    
-    const auto hpwl = static_cast<float>(net_rect.dx() + net_rect.dy());
-    const auto wire_area = hpwl * _wire_width;
-    const auto net_congestion = wire_area / net_area;
-
-    const int min_x_index
-      = std::max(0, (net_rect.xMin() - _block_grid.xMin() ) / _tile_size);
-    const int max_x_index = std::min(
-        _tile_cnt_x - 1, (net_rect.xMax() - _block_grid.xMin()) / _tile_size);
-    const int min_y_index
-        = std::max(0, (net_rect.yMin() - _block_grid.yMin()) / _tile_size);
-    const int max_y_index = std::min(
-        _tile_cnt_y - 1, (net_rect.yMax() - _block_grid.yMin()) / _tile_size);
+    return static_cast<bool>(out);
+  }
 
-    // Iterate over the tiles in the calculated range
-    for (int x = min_x_index; x <= max_x_index; ++x)
+  // Prints the size of the grid, the peak and average RUDY and the number of
+  // hotspots of the computed map
+  void report()
+  {
+    float max_rudy = 0.0f;
+    double sum = 0.0;
+    size_t hot = 0;
+    for (int x = 0; x < _tile_cnt_x; ++x)
     {
-      for (int y = min_y_index; y <= max_y_index; ++y)
+      for (int y = 0; y < _tile_cnt_y; ++y)
       {
-        Tile& tile = getGrid(x, y);
-        const auto tile_box = tile.getRect();
-        if (net_rect.overlaps(tile_box)) {
-          const auto intersect_area = net_rect.intersect(tile_box).area();
-          const auto tile_area = tile_box.area();
-          const auto tile_net_box_ratio = static_cast<float>(intersect_area)
-                                          / static_cast<float>(tile_area);
-          const auto rudy = net_congestion * tile_net_box_ratio * 100;
-          if constexpr (TEMP) {
-            tile.addOffset(rudy);
-            // _offset_grids.emplace_back(x, y, rudy);
-          }
-          else
-            tile.addRudy(rudy);
-        }
+        const float value = _rudy[tileIndex(x, y)];
+        max_rudy = std::max(max_rudy, value);
+        sum += value;
+        hot += utilization(x, y) > _ps.threshold;
       }
     }
+    std::cout << "RUDY grid: " << _tile_cnt_x << " x " << _tile_cnt_y << " tiles of " << _tile_size
+              << ", max = " << max_rudy << ", average = " << (_rudy.empty() ? 0.0 : sum / _rudy.size())
+              << ", hotspots = " << hot << std::endl;
   }
 
-  template <bool TEMP = false>
-  void removeNetsRudy(std::vector<int> net_pins)
+  // Prints the number of hotspots and the worst count of them, found with
+  // hotspots() without computing the fine map
+  void reportHotspots(size_t count = 5)
   {
-    // The first element of the vector is the driver node, and the rest are the fanouts
-    Rect net_rect;
-
-    int xhi = 0;
-    int yhi = 0;
-    int xlo = std::numeric_limits<int>::max();
-    int ylo = std::numeric_limits<int>::max();
-
-    for (auto pin : net_pins)
+    auto hot = hotspots();
+    std::cout << "RUDY grid: " << _tile_cnt_x << " x " << _tile_cnt_y << " tiles of " << _tile_size
+              << ", hotspots = " << hot.size() << std::endl;
+    count = std::min(count, hot.size());
+    std::partial_sort(hot.begin(), hot.begin() + count, hot.end(), [](auto const& a, auto const& b) {
+      return a.utilization > b.utilization;
+    });
+    for (size_t i = 0; i < count; ++i)
     {
-      node_position fanout_np = (*_placement)[pin];
-      if (fanout_np.x_coordinate < xlo)
-        xlo = fanout_np.x_coordinate;
-      if (fanout_np.x_coordinate > xhi)
-        xhi = fanout_np.x_coordinate;
-      if (fanout_np.y_coordinate < ylo)
-        ylo = fanout_np.y_coordinate;
-      if (fanout_np.y_coordinate > yhi)
-        yhi = fanout_np.y_coordinate;
-    }
-    net_rect.init(xlo - _wire_width / 2, ylo - _wire_width / 2, xhi + _wire_width / 2, yhi + _wire_width / 2);
-
-    if constexpr (TEMP) {
-      if (_operated_rect == nullptr) {
-        _operated_rect = std::make_unique<Rect>(net_rect);
-      }
-      else {
-        _operated_rect->merge(net_rect);
-      }
+      const Rect rect = tileRect(hot[i].x, hot[i].y);
+      std::cout << "  tile (" << hot[i].x << ", " << hot[i].y << ") at " << rect.xMin() << " " << rect.yMin()
+                << " " << rect.xMax() << " " << rect.yMax() << ": utilization = " << hot[i].utilization
+                << std::endl;
     }
-    
-    const auto net_area = net_rect.area();
-    if (net_area == 0)
-      std::cerr << "Error: Net area is zero" << std::endl;
-    
-    const auto hpwl = static_cast<float>(net_rect.dx() + net_rect.dy());
-    const auto wire_area = hpwl * _wire_width;
-    const auto net_congestion = wire_area / net_area;
-
-    const int min_x_index
-      = std::max(0, (net_rect.xMin() - _block_grid.xMin() ) / _tile_size);
-    const int max_x_index = std::min(
-      _tile_cnt_x - 1, (net_rect.xMax() - _block_grid.xMin()) / _tile_size);
-    const int min_y_index
-      = std::max(0, (net_rect.yMin() - _block_grid.yMin()) / _tile_size);
-    const int max_y_index = std::min(
-      _tile_cnt_y - 1, (net_rect.yMax() - _block_grid.yMin()) / _tile_size);
+  }
 
-    // Iterate over the tiles in the calculated range
-    for (int x = min_x_index; x <= max_x_index; ++x)
+  void printGrids()
+  {
+    for (int x = 0; x < _tile_cnt_x; ++x)
     {
-      for (int y = min_y_index; y <= max_y_index; ++y)
+      for (int y = 0; y < _tile_cnt_y; ++y)
       {
-        Tile& tile = getGrid(x, y);
-        const auto tile_box = tile.getRect();
-        if (net_rect.overlaps(tile_box)) {
-          const auto intersect_area = net_rect.intersect(tile_box).area();
-          const auto tile_area = tile_box.area();
-          const auto tile_net_box_ratio = static_cast<float>(intersect_area)
-                                          / static_cast<float>(tile_area);
-          const auto rudy = net_congestion * tile_net_box_ratio * 100;
-          if constexpr (TEMP) {
-            tile.addOffset(-rudy);
-          }
-          else
-            tile.addRudy(-rudy);
-        }
+        const Rect rect = tileRect(x, y);
+        std::cout << "At grid: " << rect.xMin() << " " << rect.yMin() << " " << rect.xMax() << " " << rect.yMax() << " Rudy: " << _rudy[tileIndex(x, y)] << std::endl;
       }
     }
   }
 
   template <bool TEMP = false>
-  void removeRectRudy(double x1, double y1, double x2, double y2) {
-    // The first element of the vector is the driver node, and the rest are the fanouts
-        Rect net_rect;
-    auto [xmin, xmax] = std::minmax(x1, x2);
-    auto [ymin, ymax] = std::minmax(y1, y2);
-    int xlo = static_cast<int>(xmin);
-    int ylo = static_cast<int>(ymin);
-    int xhi = static_cast<int>(xmax);
-    int yhi = static_cast<int>(ymax);
-    if (xmax != xhi)
-      ++xhi; // Consider the upper bound is 1 more than the actual value
-    if (ymax != yhi)
-      ++yhi; // Consider the upper bound is 1 more than the actual value
+  void addNetsRudy(std::vector<int> const& net_pins)
+  {
+    if (net_pins.size() < 1) return;
 
-    net_rect.init(static_cast<int>(xlo) - _wire_width / 2, static_cast<int>(ylo) - _wire_width / 2, 
-                     static_cast<int>(xhi) + _wire_width / 2, static_cast<int>(yhi) + _wire_width / 2);
-    
-    if constexpr (TEMP) {
-      if (_operated_rect == nullptr) {
-        _operated_rect = std::make_unique<Rect>(net_rect);
-      }
-      else {
-        _operated_rect->merge(net_rect);
-      }
-    }
+    // The first element of the vector is the driver node, and the rest are the fanouts
+    accumulateRect<TEMP>(pinsRect(net_pins), 1.0);
+  }
 
-    const auto net_area = net_rect.area();
-    if (net_area == 0)
-      std::cerr << "Error: Net area is zero" << std::endl;
-    
-    const auto hpwl = static_cast<float>(net_rect.dx() + net_rect.dy());
-    const auto wire_area = hpwl * _wire_width;
-    const auto net_congestion = wire_area / net_area;
+  template<bool TEMP = false>
+  void addRectRudy(double x1, double y1, double x2, double y2)
+  {
+    accumulateRect<TEMP>(boxRect(x1, y1, x2, y2), 1.0);
+  }
 
-    const int min_x_index
-      = std::max(0, (net_rect.xMin() - _block_grid.xMin() ) / _tile_size);
-    const int max_x_index = std::min(
-        _tile_cnt_x - 1, (net_rect.xMax() - _block_grid.xMin()) / _tile_size);
-    const int min_y_index
-        = std::max(0, (net_rect.yMin() - _block_grid.yMin()) / _tile_size);
-    const int max_y_index = std::min(
-        _tile_cnt_y - 1, (net_rect.yMax() - _block_grid.yMin()) / _tile_size);
+  template <bool TEMP = false>
+  void removeNetsRudy(std::vector<int> const& net_pins)
+  {
+    if (net_pins.size() < 1) return;
 
-    // Iterate over the tiles in the calculated range
-    for (int x = min_x_index; x <= max_x_index; ++x)
-    {
-      for (int y = min_y_index; y <= max_y_index; ++y)
-      {
-        Tile& tile = getGrid(x, y);
-        const auto tile_box = tile.getRect();
-        if (net_rect.overlaps(tile_box)) {
-          const auto intersect_area = net_rect.intersect(tile_box).area();
-          const auto tile_area = tile_box.area();
-          const auto tile_net_box_ratio = static_cast<float>(intersect_area)
-                                          / static_cast<float>(tile_area);
-          const auto rudy = net_congestion * tile_net_box_ratio * 100;
-          if constexpr (TEMP) {
-            tile.addOffset(-rudy);
-            // _offset_grids.emplace_back(x, y, rudy);
-          }
-          else
-            tile.addRudy(-rudy);
-        }
-      }
-    }
+    // The first element of the vector is the driver node, and the rest are the fanouts
+    accumulateRect<TEMP>(pinsRect(net_pins), -1.0);
   }
 
-  void set_tile_size(int tile_size) { _tile_size = tile_size; }
+  template <bool TEMP = false>
+  void removeRectRudy(double x1, double y1, double x2, double y2) {
+    accumulateRect<TEMP>(boxRect(x1, y1, x2, y2), -1.0);
+  }
 
   // Return rudy at specified grid
   template <bool TEMP = false>
   double getRudy(int x, int y) {
     if constexpr (TEMP) {
-      return( getGrid(x, y).getOffset() + getGrid(x, y).getRudy());
+      return _temp.offset[tileIndex(x, y)] + _rudy[tileIndex(x, y)];
     }
     else {
-      return getGrid(x, y).getRudy();
+      return _rudy[tileIndex(x, y)];
     }
   }
 
   void nodeRUDYRemove(int node_index) {
+    nodeRUDYRemove(_temp, node_index);
+  }
+
+  template <typename T>
+  double hpwlCongestCompute(T x1, T y1, T x2, T y2) {
+    buildIndex();
+    return hpwlCongestCompute(_temp, x1, y1, x2, y2);
+  }
+
+  // Drops all temporary RUDY, only the touched tiles are visited
+  void clearTempRUDY() {
+    clearOverlay(_temp);
+  }
+
+  // Maximum and average RUDY including the temporary RUDY over the tiles
+  // overlapped by rect, in O(log^2 tiles) while there is none
+  std::pair<float, float> queryRUDY(Rect const& rect) {
+    buildIndex();
+    return maxAverRUDY(rect, &_temp);
+  }
+
+  /**
+   * Overlays hold temporary RUDY on top of the committed map. The methods
+   * taking an overlay only read the committed map and may be called from
+   * several threads with one overlay each, once buildIndex has been called.
+   * */
+  RudyOverlay makeOverlay() const
+  {
+    RudyOverlay overlay;
+    overlay.offset.assign(_rudy.size(), 0.0f);
+    overlay.touched.assign(_rudy.size(), 0u);
+    return overlay;
+  }
+
+  void addRectRudy(RudyOverlay& overlay, double x1, double y1, double x2, double y2) const
+  {
+    accumulateRect(overlay, boxRect(x1, y1, x2, y2), 1.0);
+  }
+
+  void removeRectRudy(RudyOverlay& overlay, double x1, double y1, double x2, double y2) const
+  {
+    accumulateRect(overlay, boxRect(x1, y1, x2, y2), -1.0);
+  }
+
+  void nodeRUDYRemove(RudyOverlay& overlay, int node_index) const {
     auto node = _ntk->index_to_node(node_index);
 
-    int old_size = _offset_grids.size();
     // if the node is  invertor, then remove the net of the child node
     _ntk->foreach_fanin(node, [&](auto f) { 
       auto child_index = _ntk->node_to_index(_ntk->get_node(f));
       if (_ntk->_storage->nodes[child_index].data[1].h1 == 3) {
         _ntk->foreach_fanin(_ntk->index_to_node(child_index), [&](auto f) {
           auto grand_child_index = _ntk->node_to_index(_ntk->get_node(f));
-          removeRectRudy<true>(_placement->at(child_index).x_coordinate, _placement->at(child_index).y_coordinate,
-                               _placement->at(grand_child_index).x_coordinate, _placement->at(grand_child_index).y_coordinate);
+          removeRectRudy(overlay, _placement->at(child_index).x_coordinate, _placement->at(child_index).y_coordinate,
+                         _placement->at(grand_child_index).x_coordinate, _placement->at(grand_child_index).y_coordinate);
         });
       } 
-      removeRectRudy<true>(_placement->at(node_index).x_coordinate, _placement->at(node_index).y_coordinate,
-                           _placement->at(child_index).x_coordinate, _placement->at(child_index).y_coordinate);
+      removeRectRudy(overlay, _placement->at(node_index).x_coordinate, _placement->at(node_index).y_coordinate,
+                     _placement->at(child_index).x_coordinate, _placement->at(child_index).y_coordinate);
     });
   }
 
   template <typename T>
-  double hpwlCongestCompute(T x1, T y1, T x2, T y2) {
-        Rect net_rect;
+  double hpwlCongestCompute(RudyOverlay& overlay, T x1, T y1, T x2, T y2) const {
     auto [xmin, xmax] = std::minmax(x1, x2);
     auto [ymin, ymax] = std::minmax(y1, y2);
     int xlo = static_cast<int>(xmin);
@@ -569,35 +726,270 @@ public:
     if (ymax != yhi)
       ++yhi; // Consider the upper bound is 1 more than the actual value
 
-    net_rect.init(static_cast<int>(xlo - _wire_width / 2), static_cast<int>(ylo - _wire_width / 2), 
-                  static_cast<int>(xhi + _wire_width / 2), static_cast<int>(yhi + _wire_width / 2));
-
-    auto [max_rudy, aver_rudy] = maxAverRUDY<true>(net_rect);
+    auto [max_rudy, aver_rudy] = maxAverRUDY(netRect(xlo, ylo, xhi, yhi), &overlay);
     return ((xhi - xlo) + (yhi - ylo)) * (static_cast<float>(max_rudy) / 2 + static_cast<float>(aver_rudy));
   }
 
-  void clearTempRUDY() {
-    const int min_x_index
-      = std::max(0, (_operated_rect->xMin() - _block_grid.xMin() ) / _tile_size);
-    const int max_x_index = std::min(
-        _tile_cnt_x - 1, (_operated_rect->xMax() - _block_grid.xMin()) / _tile_size);
-    const int min_y_index
-        = std::max(0, (_operated_rect->yMin() - _block_grid.yMin()) / _tile_size);
-    const int max_y_index = std::min(
-        _tile_cnt_y - 1, (_operated_rect->yMax() - _block_grid.yMin()) / _tile_size);
+  void clearOverlay(RudyOverlay& overlay) const
+  {
+    for (auto const tile : overlay.tiles) {
+      overlay.offset[tile] = 0.0f;
+      overlay.touched[tile] = 0u;
+    }
+    overlay.tiles.clear();
+  }
 
-    for (int x = min_x_index; x <= max_x_index; ++x) {
-      for (int y = min_y_index; y <= max_y_index; ++y) {
-        Tile& tile = getGrid(x, y);
-        tile.clearRudy();
+  // The index of the committed map is built on the first query after a full
+  // RUDY computation and then kept up to date by every committed update
+  void buildIndex()
+  {
+    if (_index_valid)
+      return;
+
+    _index.build(_rudy, _tile_cnt_x, _tile_cnt_y);
+    _index_valid = true;
+  }
+
+ private:
+  static constexpr int kHotspotBlock = 8;  // fine tiles per coarse tile and axis
+
+  // Tiles [lo, hi] with the same covered fraction along one axis
+  struct Segment
+  {
+    int lo;
+    int hi;
+    double frac;
+  };
+
+  // Tiles covered by an interval along one axis; all tiles strictly between
+  // the first and the last one are covered completely
+  struct AxisSpan
+  {
+    int first;
+    int last;
+    double first_frac;
+    double last_frac;
+
+    int segments(Segment* segs) const
+    {
+      int num = 0;
+      segs[num++] = {first, first, first_frac};
+      if (last > first + 1)
+        segs[num++] = {first + 1, last - 1, 1.0};
+      if (last > first)
+        segs[num++] = {last, last, last_frac};
+      return num;
+    }
+  };
+
+  AxisSpan axisSpan(int lo, int hi, int origin, int cnt, int extent) const
+  {
+    AxisSpan span;
+    span.first = std::max(0, (lo - origin) / _tile_size);
+    span.last = std::min(cnt - 1, (hi - origin) / _tile_size);
+    span.first_frac = tileFraction(lo, hi, span.first, origin, cnt, extent);
+    span.last_frac = tileFraction(lo, hi, span.last, origin, cnt, extent);
+    return span;
+  }
+
+  // Fraction of tile i along one axis covered by [lo, hi]
+  double tileFraction(int lo, int hi, int i, int origin, int cnt, int extent) const
+  {
+    const int tile_lo = origin + i * _tile_size;
+    const int tile_hi = i == cnt - 1 ? origin + extent : tile_lo + _tile_size;
+    const int covered = std::min(hi, tile_hi) - std::max(lo, tile_lo);
+    return covered <= 0 ? 0.0 : static_cast<double>(covered) / (tile_hi - tile_lo);
+  }
+
+  // Calls fn(x, y, delta) for every tile changed by adding (sign > 0) or
+  // removing the contribution of a net rectangle
+  template <typename Fn>
+  void foreachRectTile(Rect const& net_rect, double sign, Fn&& fn) const
+  {
+    if (_rudy.empty())
+      return;
+    const double density = sign * netDensity(net_rect);
+    if (density == 0.0)
+      return;
+
+    AxisSpan const sx = axisSpan(net_rect.xMin(), net_rect.xMax(), _block_grid.xMin(), _tile_cnt_x, _block_grid.dx());
+    AxisSpan const sy = axisSpan(net_rect.yMin(), net_rect.yMax(), _block_grid.yMin(), _tile_cnt_y, _block_grid.dy());
+
+    for (int x = sx.first; x <= sx.last; ++x)
+    {
+      const double fx = x == sx.first ? sx.first_frac : (x == sx.last ? sx.last_frac : 1.0);
+      for (int y = sy.first; y <= sy.last; ++y)
+      {
+        const double fy = y == sy.first ? sy.first_frac : (y == sy.last ? sy.last_frac : 1.0);
+        const auto delta = static_cast<float>(density * fx * fy);
+        if (delta != 0.0f)
+          fn(x, y, delta);
       }
     }
-    _operated_rect = nullptr;
   }
 
- private:
   template <bool TEMP = false>
-  std::pair<float, float> maxAverRUDY(Rect const& net_rect) {
+  void accumulateRect(Rect const& net_rect, double sign)
+  {
+    if constexpr (TEMP) {
+      accumulateRect(_temp, net_rect, sign);
+    }
+    else {
+      const double h_share = net_rect.dx() + net_rect.dy() == 0
+                                 ? 0.5
+                                 : static_cast<double>(net_rect.dx()) / (net_rect.dx() + net_rect.dy());
+      foreachRectTile(net_rect, sign, [&](int x, int y, float delta) {
+        const size_t tile = tileIndex(x, y);
+        _rudy[tile] += delta;
+        _rudy_h[tile] += static_cast<float>(delta * h_share);
+        _rudy_v[tile] += static_cast<float>(delta * (1.0 - h_share));
+        if (_index_valid) {
+          _index.update(x, y, delta, _rudy[tile]);
+        }
+      });
+    }
+  }
+
+  void accumulateRect(RudyOverlay& overlay, Rect const& net_rect, double sign) const
+  {
+    foreachRectTile(net_rect, sign, [&](int x, int y, float delta) {
+      const size_t tile = tileIndex(x, y);
+      if (!overlay.touched[tile]) {
+        overlay.touched[tile] = 1u;
+        overlay.tiles.push_back(static_cast<uint32_t>(tile));
+      }
+      overlay.offset[tile] += delta;
+    });
+  }
+
+  // RUDY of a net per unit of covered tile fraction (in percent)
+  double netDensity(Rect const& net_rect) const
+  {
+    const auto [h, v] = netDemand(net_rect);
+    return h + v;
+  }
+
+  // Horizontal and vertical share of netDensity
+  std::pair<double, double> netDemand(Rect const& net_rect) const
+  {
+    const auto net_area = net_rect.area();
+    if (net_area == 0) {
+      std::cerr << "Error: Net area is zero" << std::endl;
+      return {0.0, 0.0};
+    }
+
+    const double scale = static_cast<double>(_wire_width) / net_area * 100;
+    return {net_rect.dx() * scale, net_rect.dy() * scale};
+  }
+
+  static void addBlock(double* diff, int stride, Segment const& sx, Segment const& sy, double value)
+  {
+    diff[sx.lo * stride + sy.lo] += value;
+    diff[(sx.hi + 1) * stride + sy.lo] -= value;
+    diff[sx.lo * stride + sy.hi + 1] -= value;
+    diff[(sx.hi + 1) * stride + sy.hi + 1] += value;
+  }
+
+  // Integrates a difference array along x, then along y, into grid
+  void integrate(std::vector<double>& diff, int stride, std::vector<float>& grid) const
+  {
+    for (int x = 1; x < _tile_cnt_x; ++x)
+    {
+      for (int y = 0; y < _tile_cnt_y; ++y)
+      {
+        diff[x * stride + y] += diff[(x - 1) * stride + y];
+      }
+    }
+    for (int x = 0; x < _tile_cnt_x; ++x)
+    {
+      double sum = 0.0;
+      for (int y = 0; y < _tile_cnt_y; ++y)
+      {
+        sum += diff[x * stride + y];
+        grid[tileIndex(x, y)] = static_cast<float>(sum);
+      }
+    }
+  }
+
+  // Pin coordinates as structure of arrays, gathered once for all nets
+  void gatherPins()
+  {
+    _pin_x.resize(_net_pins.size());
+    _pin_y.resize(_net_pins.size());
+    for (size_t i = 0; i < _net_pins.size(); ++i)
+    {
+      node_position const& np = (*_placement)[_net_pins[i]];
+      _pin_x[i] = static_cast<int>(np.x_coordinate);
+      _pin_y[i] = static_cast<int>(np.y_coordinate);
+    }
+  }
+
+  // Rect of a net with at least one pin, from the gathered pins
+  Rect netBox(size_t net) const
+  {
+    const uint32_t begin = _net_offsets[net];
+    const uint32_t end = _net_offsets[net + 1];
+    int xmin = _pin_x[begin], xmax = _pin_x[begin];
+    int ymin = _pin_y[begin], ymax = _pin_y[begin];
+    for (uint32_t i = begin + 1; i < end; ++i)
+    {
+      xmin = std::min(xmin, _pin_x[i]);
+      xmax = std::max(xmax, _pin_x[i]);
+      ymin = std::min(ymin, _pin_y[i]);
+      ymax = std::max(ymax, _pin_y[i]);
+    }
+    return netRect(xmin, ymin, xmax, ymax);
+  }
+
+  // Bounding box of a net, extended by half of the wire width
+  Rect netRect(int xlo, int ylo, int xhi, int yhi) const
+  {
+    return Rect(xlo - _wire_width / 2, ylo - _wire_width / 2,
+                xhi + _wire_width / 2, yhi + _wire_width / 2);
+  }
+
+  Rect pinsRect(std::vector<int> const& net_pins) const
+  {
+    int xmax = 0;
+    int ymax = 0;
+    int xmin = std::numeric_limits<int>::max();
+    int ymin = std::numeric_limits<int>::max();
+
+    for (auto pin : net_pins)
+    {
+      node_position const& fanout_np = (*_placement)[pin];
+      xmin = std::min(xmin, static_cast<int>(fanout_np.x_coordinate));
+      xmax = std::max(xmax, static_cast<int>(fanout_np.x_coordinate));
+      ymin = std::min(ymin, static_cast<int>(fanout_np.y_coordinate));
+      ymax = std::max(ymax, static_cast<int>(fanout_np.y_coordinate));
+    }
+    return netRect(xmin, ymin, xmax, ymax);
+  }
+
+  Rect boxRect(double x1, double y1, double x2, double y2) const
+  {
+    auto [xmin, xmax] = std::minmax(x1, x2);
+    auto [ymin, ymax] = std::minmax(y1, y2);
+    int xlo = static_cast<int>(xmin);
+    int ylo = static_cast<int>(ymin);
+    int xhi = static_cast<int>(xmax);
+    int yhi = static_cast<int>(ymax);
+    if (xmax != xhi)
+      ++xhi; // Consider the upper bound is 1 more than the actual value
+    if (ymax != yhi)
+      ++yhi; // Consider the upper bound is 1 more than the actual value
+    return netRect(xlo, ylo, xhi, yhi);
+  }
+
+  // Sums and maxima of the committed map come from the index. With
+  // temporary RUDY the tiles of the rect are scanned: adding a net to an
+  // overlay already visits every tile of its box, and the queried rects are
+  // those boxes, so keeping index copies per overlay only added a log^2
+  // factor to each touched tile.
+  std::pair<float, float> maxAverRUDY(Rect const& net_rect, RudyOverlay* overlay) const {
+    if (_rudy.empty())
+      return {0.0f, 0.0f};
+    assert(_index_valid);
     const int min_x_index
       = std::max(0, (net_rect.xMin() - _block_grid.xMin() ) / _tile_size);
     const int max_x_index = std::min(
@@ -610,19 +1002,29 @@ public:
     float max_rudy = 0.0;
     float aver_rudy = 0.0;
     int num_grids = (max_x_index - min_x_index + 1) * (max_y_index - min_y_index + 1);
-
-    for (int x = min_x_index; x <= max_x_index; ++x) {
-      for (int y = min_y_index; y <= max_y_index; ++y) {
-        auto cur_rudy = getRudy<TEMP>(x, y);
-        aver_rudy += cur_rudy;
-        if (cur_rudy > max_rudy)
-          max_rudy = cur_rudy;
+    if (max_x_index < min_x_index || max_y_index < min_y_index)
+      return {max_rudy, aver_rudy};
+
+    double sum = 0.0;
+    if (overlay != nullptr && !overlay->tiles.empty()) {
+      for (int x = min_x_index; x <= max_x_index; ++x) {
+        for (int y = min_y_index; y <= max_y_index; ++y) {
+          const size_t tile = tileIndex(x, y);
+          const float value = _rudy[tile] + overlay->offset[tile];
+          sum += value;
+          max_rudy = std::max(max_rudy, value);
+        }
       }
     }
-    aver_rudy /= num_grids;
+    else {
+      sum = _index.sum(min_x_index, min_y_index, max_x_index, max_y_index);
+      max_rudy = std::max(max_rudy, _index.max(min_x_index, min_y_index, max_x_index, max_y_index));
+    }
+    aver_rudy = static_cast<float>(sum / num_grids);
 
     return {max_rudy, aver_rudy};
   }
+
   // Compute the area that only contains cells
   void buildCoreOnlyCell()
   {
@@ -678,28 +1080,40 @@ public:
     _block_grid.init(min_x, min_y, max_x, max_y);
   }
 
-  // Extract the nets from the AIG network and its companion placement
+  // Extract the nets from the AIG network and its companion placement.
+  // Each net is named by its driver and stored as a range of _net_pins
   void extractNets()
   {
+    std::vector<uint32_t> counts(_ntk->size(), 0u);
+    _ntk->foreach_pi([&](auto const& n) {
+      ++counts[_ntk->node_to_index(n)];
+    });
+    _ntk->foreach_gate([&](auto const& n) {
+      ++counts[_ntk->node_to_index(n)];
+      _ntk->foreach_fanin(n, [&](auto f) {
+        ++counts[_ntk->node_to_index(_ntk->get_node(f))];
+      });
+    });
+
+    _net_offsets.assign(_ntk->size() + 1, 0u);
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+      _net_offsets[i + 1] = _net_offsets[i] + counts[i];
+    }
+
+    // The first pin of a net is its driver, the rest are the fanouts
+    std::vector<uint32_t> next(_net_offsets.begin(), _net_offsets.end() - 1);
+    _net_pins.resize(_net_offsets.back());
     _ntk->foreach_pi([&](auto const& n) {
       auto nindex = _ntk->node_to_index(n);
-      if (!_nets[nindex].empty()) {
-        std::cerr << "Error: Net already exists" << std::endl;
-      } else {
-       _nets[nindex].push_back(nindex);
-      }
+      _net_pins[next[nindex]++] = nindex;
     });
-    // Extract nets from the network, each key denotes a net, named by its drive
     _ntk->foreach_gate([&](auto const& n) {
       auto nindex = _ntk->node_to_index(n);
-      if (!_nets[nindex].empty()) {
-        std::cerr << "Error: Net already exists" << std::endl;
-      } else {
-       _nets[nindex].push_back(nindex);
-      }
+      _net_pins[next[nindex]++] = nindex;
       _ntk->foreach_fanin(n, [&](auto f) {
         auto index = _ntk->node_to_index(_ntk->get_node(f));
-        _nets[index].push_back(nindex);
+        _net_pins[next[index]++] = nindex;
       });
     });
   }
@@ -729,46 +1143,48 @@ public:
   
   void compute_tile_cnt()
   {
+    if (_tile_size <= 0) {
+      std::cerr << "Error: RUDY tile size must be positive, got " << _tile_size << std::endl;
+      _tile_cnt_x = _tile_cnt_y = 0;
+      return;
+    }
     int width_x = _block_grid.xMax() - _block_grid.xMin();
     int width_y = _block_grid.yMax() - _block_grid.yMin();
     _tile_cnt_x = width_x / _tile_size;
     _tile_cnt_y = width_y / _tile_size;
   }
 
+  // The grid starts at the lower left corner of the core, the last row and
+  // column of tiles extend up to its upper right corner
   void makeGrid()
   {
     compute_tile_cnt();
-    const int grid_lx = _block_grid.xMin();
-    const int grid_ly = _block_grid.yMin();
+    _rudy.assign(static_cast<size_t>(_tile_cnt_x) * _tile_cnt_y, 0.0f);
+    _rudy_h.assign(_rudy.size(), 0.0f);
+    _rudy_v.assign(_rudy.size(), 0.0f);
+    _temp = makeOverlay();
+    _index_valid = false;
+  }
 
-    int vertical_margin = _block_grid.xMax() - _tile_cnt_y * _tile_size;
-    int horizontal_margin = _block_grid.yMax() - _tile_cnt_x * _tile_size;
+  Rect tileRect(int x, int y) const
+  {
+    const int lx = _block_grid.xMin() + x * _tile_size;
+    const int ly = _block_grid.yMin() + y * _tile_size;
+    const int ux = x == _tile_cnt_x - 1 ? _block_grid.xMax() : lx + _tile_size;
+    const int uy = y == _tile_cnt_y - 1 ? _block_grid.yMax() : ly + _tile_size;
+    return Rect(lx, ly, ux, uy);
+  }
 
-    _grids.resize(_tile_cnt_x);
-    int cur_x = 0;
-    for (int x = 0; x < _tile_cnt_x; x++)
-    {
-      _grids[x].resize(_tile_cnt_y);
-      int cur_y = 0;
-      for (int y = 0; y < _tile_cnt_y; y++)
-      {
-        Tile& grid = _grids[x][y];
-        int x_ext = x == _grids.size() - 1 ? horizontal_margin : 0;
-        int y_ext = y == _grids[x].size() - 1 ? vertical_margin : 0;
-        grid.setRect(
-            cur_x, cur_y, cur_x + _tile_size + x_ext, cur_y + _tile_size + y_ext);
-        cur_y += _tile_size;
-      }
-      cur_x += _tile_size;
-    }
+  // Tiles are stored column by column
+  size_t tileIndex(int x, int y) const
+  {
+    return static_cast<size_t>(x) * _tile_cnt_y + y;
   }
 
   bool isInteger(double x) {
     return x == static_cast<double>(static_cast<int>(x));
   }
 
-  Tile& getGrid(int x, int y) { return _grids[x][y]; }
-
   // It corresponds to the vector match position in mapper
   const std::vector<node_position>* _placement;
   const Ntk* _ntk;
@@ -776,16 +1192,22 @@ public:
   int _num_po;
 
   Rect _block_grid;
-  std::vector<std::vector<Tile>> _grids;
-  std::vector<std::vector<int>> _nets;
+  std::vector<float> _rudy;      // committed RUDY per tile
+  std::vector<float> _rudy_h;    // horizontal share of _rudy
+  std::vector<float> _rudy_v;    // vertical share of _rudy
+  std::vector<uint32_t> _net_pins;     // pins of all nets, driver first
+  std::vector<uint32_t> _net_offsets;  // net i owns [_net_offsets[i], _net_offsets[i + 1])
+  std::vector<int> _pin_x;       // x coordinates of _net_pins
+  std::vector<int> _pin_y;       // y coordinates of _net_pins
+  rudy_params _ps;
   int _wire_width = 12;
   int _tile_cnt_x = 10;
   int _tile_cnt_y = 10;
-  int _tile_size = 600; // should we respectively set horizontal and vertical tile size? 600 by default
+  int _tile_size = 600;
 
-  std::vector<TemporaryRudy> _offset_grids;  
-  std::unique_ptr<Rect> _operated_rect;
-  std::vector<int> _operations;
+  RudyOverlay _temp;                    // temporary RUDY of the template API
+  RudyIndex _index;                     // sums and maxima of _rudy
+  bool _index_valid = false;
 };
 
 } // namespace phyLS
\ No newline at end of file
@@ -30,6 +30,8 @@
 #include <string>
 #include <vector>
 
+#include "../library_registry.hpp"
+
 using namespace percy;
 using namespace mockturtle;
 using kitty::dynamic_truth_table;
@@ -269,8 +271,10 @@ class dag_impl {
             pd_cegar_synthesize(spec, c, dag, solver, encoder);
         if (status == success) {
           target = true;
-          std::vector<mockturtle::gate> gates = ps.gates;
-          mockturtle::tech_library<5> lib(gates);
+          std::vector<mockturtle::gate> const& gates = ps.gates;
+          auto const lib_ptr =
+              phyLS::library_registry::instance().technology(gates);
+          auto const& lib = *lib_ptr;
           mockturtle::map_params pss;
           mockturtle::map_stats st;
           klut_network klut = create_network(c);
@@ -293,8 +297,10 @@ class dag_impl {
     store_bench();
     vector<bench> exact_synthesis_result;
     for (int i = 0; i < exact_synthesis_results.size(); i++) {
-      std::vector<mockturtle::gate> gates = ps.gates;
-      mockturtle::tech_library<5> lib(gates);
+      std::vector<mockturtle::gate> const& gates = ps.gates;
+      auto const lib_ptr =
+          phyLS::library_registry::instance().technology(gates);
+      auto const& lib = *lib_ptr;
       mockturtle::map_params ps;
       mockturtle::map_stats st;
       mockturtle::klut_network klut;
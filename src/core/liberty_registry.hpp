@@ -0,0 +1,34 @@
+/* phyLS: powerful heightened yielded Logic Synthesis
+ * Copyright (C) 2023 */
+
+/**
+ * @file liberty_registry.hpp
+ *
+ * @brief Process-wide cache of the Liberty timing model used by STA
+ *
+ * @author Homyoung
+ * @since  2023/11/16
+ */
+
+#pragma once
+
+#include <mutex>
+#include <string>
+
+#include "read_placement_file.hpp"
+
+namespace phyLS {
+
+/*! \brief Liberty timing model of `lib_file` installed in the ABC frame.
+ *
+ * The file is only read if it differs from the one installed last or was
+ * modified since, see `load_scl_library`.  Kept apart from `library_registry` so that users of
+ * the technology libraries do not depend on ABC.  May be called from
+ * several threads.
+ */
+inline SC_Lib* liberty_library(std::string const& lib_file) {
+  std::lock_guard<std::mutex> lock(abc_frame_mutex());
+  return load_scl_library(lib_file);
+}
+
+}  // namespace phyLS
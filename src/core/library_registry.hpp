@@ -0,0 +1,167 @@
+/* phyLS: powerful heightened yielded Logic Synthesis
+ * Copyright (C) 2023 */
+
+/**
+ * @file library_registry.hpp
+ *
+ * @brief Process-wide cache of the technology libraries used by mapping
+ *
+ * @author Homyoung
+ * @since  2023/11/16
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <kitty/dynamic_truth_table.hpp>
+#include <mockturtle/io/genlib_reader.hpp>
+#include <mockturtle/utils/tech_library.hpp>
+
+namespace phyLS {
+
+/*! \brief Libraries shared by all commands of a session.
+ *
+ * A `tech_library` computes the NPN classes and supergates of every gate,
+ * which dominates the setup of mapping commands.  The registry builds it
+ * once per distinct gate list and hands out shared read-only instances.
+ * Lists are looked up by a fingerprint of the names, functions, areas and
+ * pin delays of the gates and compared in full on a hit.  The Liberty
+ * timing model of the ABC frame is cached apart, see liberty_registry.hpp.
+ *
+ * All functions may be called from several threads.
+ */
+class library_registry {
+ public:
+  using library_t = mockturtle::tech_library<5>;
+
+  static library_registry& instance() {
+    static library_registry registry;
+    return registry;
+  }
+
+  /*! \brief Mapping library of `gates`. */
+  std::shared_ptr<library_t const> technology(
+      std::vector<mockturtle::gate> const& gates) {
+    return get(fingerprint(gates), gates);
+  }
+
+  /*! \brief Mapping library of the AND, NAND, inverter, buffer and constant
+   * gates of `gates`, used to complete partial covers. */
+  std::shared_ptr<library_t const> critical(
+      std::vector<mockturtle::gate> const& gates) {
+    std::vector<mockturtle::gate> small;
+    for (auto const& g : gates) {
+      if (is_critical(g.function)) small.push_back(g);
+    }
+    return get(fingerprint(gates) ^ critical_tag, small);
+  }
+
+  uint64_t num_built() const { return built; }
+  uint64_t num_reused() const { return reused; }
+
+ private:
+  library_registry() = default;
+
+  static constexpr uint64_t critical_tag = 0x6372697469636c6bull;
+
+  static void combine(uint64_t& seed, uint64_t value) {
+    seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+  }
+
+  static uint64_t fingerprint(std::vector<mockturtle::gate> const& gates) {
+    uint64_t seed = gates.size();
+    std::hash<std::string> hash_string;
+    std::hash<double> hash_double;
+    for (auto const& g : gates) {
+      combine(seed, hash_string(g.name));
+      combine(seed, hash_string(g.expression));
+      combine(seed, hash_double(g.area));
+      combine(seed, g.function.num_vars());
+      for (auto const word : g.function._bits) combine(seed, word);
+      for (auto const& p : g.pins) {
+        combine(seed, hash_string(p.name));
+        combine(seed, static_cast<uint64_t>(p.phase));
+        combine(seed, hash_double(p.input_load));
+        combine(seed, hash_double(p.rise_block_delay));
+        combine(seed, hash_double(p.rise_fanout_delay));
+        combine(seed, hash_double(p.fall_block_delay));
+        combine(seed, hash_double(p.fall_fanout_delay));
+      }
+    }
+    return seed;
+  }
+
+  /* functions whose hexadecimal form is 0, 1, 2, 7 or 8: constants,
+   * buffer and inverter, and the two-input AND, NAND, NOR and AND with one
+   * inverted input */
+  static bool is_critical(kitty::dynamic_truth_table const& function) {
+    if (function.num_vars() > 2u) return false;
+    auto const mask = (uint64_t(1) << function.num_bits()) - 1u;
+    auto const word = function._bits[0] & mask;
+    return word == 0x0 || word == 0x1 || word == 0x2 || word == 0x7 ||
+           word == 0x8;
+  }
+
+  static bool same_pins(mockturtle::pin const& a, mockturtle::pin const& b) {
+    return a.name == b.name && a.phase == b.phase &&
+           a.input_load == b.input_load && a.max_load == b.max_load &&
+           a.rise_block_delay == b.rise_block_delay &&
+           a.rise_fanout_delay == b.rise_fanout_delay &&
+           a.fall_block_delay == b.fall_block_delay &&
+           a.fall_fanout_delay == b.fall_fanout_delay;
+  }
+
+  static bool same_gates(std::vector<mockturtle::gate> const& a,
+                         std::vector<mockturtle::gate> const& b) {
+    return std::equal(
+        a.begin(), a.end(), b.begin(), b.end(), [](auto const& x, auto const& y) {
+          return x.name == y.name && x.expression == y.expression &&
+                 x.area == y.area && x.function == y.function &&
+                 std::equal(x.pins.begin(), x.pins.end(), y.pins.begin(),
+                            y.pins.end(), same_pins);
+        });
+  }
+
+  std::shared_ptr<library_t const> get(
+      uint64_t key, std::vector<mockturtle::gate> const& gates) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& bucket = libraries[key];
+    for (auto const& data : bucket) {
+      if (same_gates(data->gates, gates)) {
+        ++reused;
+        return std::shared_ptr<library_t const>(data, &data->library);
+      }
+    }
+    auto const data = std::make_shared<entry const>(gates);
+    bucket.push_back(data);
+    ++built;
+    return std::shared_ptr<library_t const>(data, &data->library);
+  }
+
+  /* a library may refer to its gates, they are kept next to it and
+   * identify it on a lookup */
+  struct entry {
+    explicit entry(std::vector<mockturtle::gate> g)
+        : gates(std::move(g)), library(gates) {}
+    std::vector<mockturtle::gate> gates;
+    library_t library;
+  };
+
+  std::mutex mutex;
+  /* entries by fingerprint, lists with equal fingerprints share a bucket */
+  std::unordered_map<uint64_t, std::vector<std::shared_ptr<entry const>>>
+      libraries;
+  uint64_t built{0u};
+  uint64_t reused{0u};
+};
+
+}  // namespace phyLS
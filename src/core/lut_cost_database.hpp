@@ -0,0 +1,156 @@
+/* phyLS: powerful heightened yielded Logic Synthesis
+ * Copyright (C) 2023 */
+
+/**
+ * @file lut_cost_database.hpp
+ *
+ * @brief NPN-keyed database of LUT costs that persists across mapping runs
+ *
+ * @author Homyoung
+ * @since  2023/11/16
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <kitty/constructors.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+#include <kitty/hash.hpp>
+#include <kitty/npn.hpp>
+#include <kitty/print.hpp>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+
+namespace phyLS {
+
+/*! \brief Id under which the costs of `CostFn` are stored.
+ *
+ * A cost function names itself with a static `id` member without
+ * whitespace; otherwise its type name is used, which is only stable for the
+ * same build.
+ */
+template <typename CostFn, typename = void>
+struct lut_cost_function_id {
+  static std::string get() { return typeid(CostFn).name(); }
+};
+
+template <typename CostFn>
+struct lut_cost_function_id<CostFn, std::void_t<decltype(CostFn::id)>> {
+  static std::string get() { return CostFn::id; }
+};
+
+/*! \brief Database of (area, delay) costs of LUT functions.
+ *
+ * Functions are keyed by an NPN representative, so the stored costs must be
+ * invariant under input negation, input permutation and output negation, as
+ * it is the case for decomposition based costs.  The representative is exact
+ * for up to 4 variables and computed by sifting for larger functions, which
+ * is deterministic but may store several entries for the same class.  The
+ * costs of different cost functions are kept apart by their id.
+ *
+ * The database is stored as text, one function per line:
+ * `<cost function id> <num_vars> <hex truth table> <area> <delay>`.
+ */
+class lut_cost_database {
+ public:
+  using cost_t = std::pair<uint32_t, uint32_t>;
+
+  /*! \brief Returns the cost of `tt` under the cost function `cost_id`,
+   * calling `cost_fn` only on a miss. */
+  template <typename CostFn>
+  cost_t lookup(std::string const& cost_id,
+                kitty::dynamic_truth_table const& tt, CostFn&& cost_fn) {
+    auto& table = costs[cost_id];
+    auto key = representative(tt);
+    if (auto it = table.find(key); it != table.end()) {
+      ++num_hits;
+      return it->second;
+    }
+
+    ++num_misses;
+    auto const cost = cost_fn(tt);
+    table.emplace(std::move(key), cost);
+    modified = true;
+    return cost;
+  }
+
+  /*! \brief Loads entries from `filename`, returns false if it cannot be
+   * opened.  Entries already in the database are kept. */
+  bool load(std::string const& filename) {
+    std::ifstream in(filename);
+    if (!in.is_open()) return false;
+
+    std::string line;
+    uint32_t line_number = 0u;
+    while (std::getline(in, line)) {
+      ++line_number;
+      if (line.empty() || line[0] == '#') continue;
+
+      std::istringstream iss(line);
+      uint32_t num_vars, area, delay;
+      std::string cost_id, hex;
+      if (!(iss >> cost_id >> num_vars >> hex >> area >> delay) ||
+          num_vars > 16u ||
+          hex.size() != (num_vars <= 2u ? 1u : (1u << (num_vars - 2u)))) {
+        std::cerr << "[w] skipping malformed line " << line_number << " in "
+                  << filename << "\n";
+        continue;
+      }
+
+      kitty::dynamic_truth_table tt(num_vars);
+      kitty::create_from_hex_string(tt, hex);
+      costs[cost_id].emplace(std::move(tt), cost_t{area, delay});
+    }
+    return true;
+  }
+
+  /*! \brief Writes all entries to `filename`. */
+  bool save(std::string const& filename) const {
+    std::ofstream out(filename);
+    if (!out.is_open()) return false;
+
+    for (auto const& [cost_id, table] : costs) {
+      for (auto const& [tt, cost] : table) {
+        out << cost_id << " " << tt.num_vars() << " " << kitty::to_hex(tt)
+            << " " << cost.first << " " << cost.second << "\n";
+      }
+    }
+    return true;
+  }
+
+  /*! \brief True if entries were added since construction. */
+  bool is_modified() const { return modified; }
+
+  uint64_t size() const {
+    uint64_t num_entries = 0u;
+    for (auto const& entry : costs) num_entries += entry.second.size();
+    return num_entries;
+  }
+  uint64_t hits() const { return num_hits; }
+  uint64_t misses() const { return num_misses; }
+
+ private:
+  static kitty::dynamic_truth_table representative(
+      kitty::dynamic_truth_table const& tt) {
+    if (tt.num_vars() <= 4u) {
+      return std::get<0>(kitty::exact_npn_canonization(tt));
+    }
+    return std::get<0>(kitty::sifting_npn_canonization(tt));
+  }
+
+  using table_t = std::unordered_map<kitty::dynamic_truth_table, cost_t,
+                                     kitty::hash<kitty::dynamic_truth_table>>;
+
+  std::unordered_map<std::string, table_t> costs; /* by cost function id */
+  uint64_t num_hits{0u};
+  uint64_t num_misses{0u};
+  bool modified{false};
+};
+
+}  // namespace phyLS
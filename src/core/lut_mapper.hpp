@@ -14,14 +14,19 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <kitty/dynamic_truth_table.hpp>
 #include <kitty/operations.hpp>
+#include <kitty/static_truth_table.hpp>
 #include <limits>
+#include <memory>
 #include <mockturtle/algorithms/cut_enumeration.hpp>
 #include <mockturtle/algorithms/simulation.hpp>
+#include <mockturtle/networks/events.hpp>
 #include <mockturtle/networks/klut.hpp>
 #include <mockturtle/utils/cost_functions.hpp>
 #include <mockturtle/utils/cuts.hpp>
@@ -33,6 +38,9 @@
 #include <sstream>
 #include <string>
 
+#include "lut_cost_database.hpp"
+#include "utils/parallel.hpp"
+
 namespace phyLS {
 
 /*! \brief Parameters for map.
@@ -88,6 +96,21 @@ struct lut_map_params {
   /*! \brief Maximum number variables for cost function caching */
   uint32_t cost_cache_vars{3u};
 
+  /*! \brief Persistent cost database consulted before `LUTCostFn`.
+   *
+   * Only used when `StoreFunction` is true.  New costs are added to the
+   * database, which the caller may save after mapping.
+   */
+  lut_cost_database* cost_database{nullptr};
+
+  /*! \brief Number of threads for cut enumeration (0 = all cores).
+   *
+   * Nodes of the same level are processed concurrently in the mapping
+   * passes that do not update reference counts.  The result is identical
+   * to the serial one.
+   */
+  uint32_t num_threads{1u};
+
   /*! \brief Be verbose. */
   bool verbose{false};
 };
@@ -418,6 +441,177 @@ class lut_cut_set {
   typename std::array<CutType*, MaxCuts>::const_iterator _pcend{_pcuts.begin()};
   typename std::array<CutType*, MaxCuts>::iterator _pend{_pcuts.begin()};
 };
+
+/* Packed cut sets of all nodes.  A cut is stored as its data, its number of
+ * leaves and its (sorted) leaves as LEB128-encoded deltas, so a node only
+ * pays for the cuts it keeps after `cut_limit` and not for the capacity of a
+ * `lut_cut_set`.  Sets are unpacked into a `lut_cut_set` for processing. */
+template <typename CutType>
+class lut_cut_store {
+ public:
+  using data_t = std::decay_t<decltype(std::declval<CutType const&>().data())>;
+
+  explicit lut_cut_store(uint32_t size) : sets(size) {}
+
+  template <typename CutSet>
+  void store(uint32_t index, CutSet const& set) {
+    auto& bytes = sets[index].bytes;
+    bytes.clear();
+    for (auto const* cut : set) {
+      auto const pos = bytes.size();
+      bytes.resize(pos + sizeof(data_t));
+      std::memcpy(bytes.data() + pos, &cut->data(), sizeof(data_t));
+      bytes.push_back(static_cast<uint8_t>(cut->size()));
+
+      uint32_t prev = 0u;
+      for (auto const leaf : *cut) {
+        put_varint(bytes, leaf - prev);
+        prev = leaf;
+      }
+    }
+    sets[index].num_cuts = static_cast<uint32_t>(set.size());
+  }
+
+  template <typename CutSet>
+  void load(uint32_t index, CutSet& set) const {
+    set.clear();
+
+    std::array<uint32_t, 32u> leaves;
+    auto const* ptr = sets[index].bytes.data();
+    for (auto i = 0u; i < sets[index].num_cuts; ++i) {
+      data_t data;
+      std::memcpy(&data, ptr, sizeof(data_t));
+      ptr += sizeof(data_t);
+
+      uint32_t const size = *ptr++;
+      uint32_t prev = 0u;
+      for (auto j = 0u; j < size; ++j) {
+        prev += get_varint(ptr);
+        leaves[j] = prev;
+      }
+
+      auto& cut = set.add_cut(leaves.begin(), leaves.begin() + size);
+      cut.data() = data;
+    }
+  }
+
+  void resize(uint32_t size) { sets.resize(size); }
+
+  /*! \brief Frees the cut set of a node. */
+  void release(uint32_t index) {
+    std::vector<uint8_t>().swap(sets[index].bytes);
+    sets[index].num_cuts = 0u;
+  }
+
+  /*! \brief Whether a node has a stored (non-released) cut set. */
+  bool has(uint32_t index) const { return sets[index].num_cuts != 0u; }
+
+ private:
+  static void put_varint(std::vector<uint8_t>& bytes, uint32_t value) {
+    while (value >= 0x80u) {
+      bytes.push_back(static_cast<uint8_t>(value | 0x80u));
+      value >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(value));
+  }
+
+  static uint32_t get_varint(uint8_t const*& ptr) {
+    uint32_t value = 0u;
+    for (uint32_t shift = 0u;; shift += 7u) {
+      uint8_t const byte = *ptr++;
+      value |= static_cast<uint32_t>(byte & 0x7fu) << shift;
+      if ((byte & 0x80u) == 0u) return value;
+    }
+  }
+
+  struct packed_set {
+    std::vector<uint8_t> bytes;
+    uint32_t num_cuts{0u};
+  };
+
+  std::vector<packed_set> sets;
+};
+#pragma endregion
+
+#pragma region small truth table cache
+/* Cache of functions with up to 6 variables using open addressing.  Truth
+ * tables are kept as 64-bit words replicated over the unused variables, the
+ * ids follow `truth_table_cache`: 2 * index + 1 if the stored function was
+ * complemented to make bit 0 zero. */
+class lut_small_tt_cache {
+ public:
+  explicit lut_small_tt_cache(uint32_t capacity = 1024u) {
+    uint32_t num_slots = 16u;
+    while (num_slots < 2u * capacity) num_slots <<= 1;
+    slots.assign(num_slots, empty);
+    entries.reserve(capacity);
+  }
+
+  uint32_t insert(uint64_t bits, uint32_t num_vars) {
+    uint32_t const is_compl = static_cast<uint32_t>(bits & 1u);
+    if (is_compl) bits = ~bits;
+
+    auto const mask = slots.size() - 1u;
+    for (auto pos = hash(bits, num_vars) & mask;; pos = (pos + 1u) & mask) {
+      auto const index = slots[pos];
+      if (index == empty) {
+        slots[pos] = static_cast<uint32_t>(entries.size());
+        entries.push_back({bits, num_vars});
+        if (2u * entries.size() > slots.size()) grow();
+        return 2u * static_cast<uint32_t>(entries.size() - 1u) + is_compl;
+      }
+      if (entries[index].bits == bits && entries[index].num_vars == num_vars) {
+        return 2u * index + is_compl;
+      }
+    }
+  }
+
+  uint64_t bits(uint32_t id) const {
+    auto const bits = entries[id >> 1].bits;
+    return (id & 1u) ? ~bits : bits;
+  }
+
+  uint32_t num_vars(uint32_t id) const { return entries[id >> 1].num_vars; }
+
+  /*! \brief Number of ids that may have been handed out. */
+  uint32_t num_ids() const { return 2u * static_cast<uint32_t>(entries.size()); }
+
+  kitty::dynamic_truth_table operator[](uint32_t id) const {
+    kitty::dynamic_truth_table tt(num_vars(id));
+    *tt.begin() = bits(id);
+    tt.mask_bits();
+    return tt;
+  }
+
+ private:
+  struct entry {
+    uint64_t bits;
+    uint32_t num_vars;
+  };
+
+  static uint64_t hash(uint64_t bits, uint32_t num_vars) {
+    uint64_t h = bits ^ (static_cast<uint64_t>(num_vars) << 58);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    return h ^ (h >> 33);
+  }
+
+  void grow() {
+    slots.assign(2u * slots.size(), empty);
+    auto const mask = slots.size() - 1u;
+    for (auto i = 0u; i < entries.size(); ++i) {
+      auto pos = hash(entries[i].bits, entries[i].num_vars) & mask;
+      while (slots[pos] != empty) pos = (pos + 1u) & mask;
+      slots[pos] = i;
+    }
+  }
+
+  static constexpr uint32_t empty = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> slots;
+  std::vector<entry> entries;
+};
 #pragma endregion
 
 #pragma region LUT mapper
@@ -439,25 +633,61 @@ class lut_map_impl {
   using node = typename Ntk::node;
   using cut_merge_t = typename std::array<cut_set_t*, Ntk::max_fanin_size + 1>;
   using TT = kitty::dynamic_truth_table;
+  using STT = kitty::static_truth_table<6>;
   using tt_cache = truth_table_cache<TT>;
   using cost_cache =
       std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>>;
 
+  /* gates ordered by the last use of their cut sets in a node order */
+  struct release_list {
+    std::vector<uint32_t> nodes;
+    std::vector<uint64_t> last_use;
+    uint64_t next{0u};
+  };
+
+  /* scratch space of a thread for merging cuts */
+  struct workspace_t {
+    cut_merge_t lcuts;
+    std::vector<uint32_t> cut_sizes;
+    std::vector<cut_t const*> vcuts;
+    /* unpacked cut sets, allocated once since they are large */
+    std::vector<std::unique_ptr<cut_set_t>> sets;
+
+    cut_set_t& set(uint32_t i) {
+      while (sets.size() <= i) sets.push_back(std::make_unique<cut_set_t>());
+      return *sets[i];
+    }
+  };
+
  public:
   explicit lut_map_impl(Ntk& ntk, lut_map_params const& ps, lut_map_stats& st)
-      : ntk(ntk), ps(ps), st(st), node_match(ntk.size()), cuts(ntk.size()) {
+      : ntk(ntk),
+        ps(ps),
+        st(st),
+        node_match(ntk.size()),
+        best_cuts(ntk.size()),
+        cuts(ntk.size()),
+        workspaces(resolve_num_threads(ps.num_threads)),
+        small_functions(StoreFunction &&
+                        ps.cut_enumeration_ps.cut_size <= 6u) {
     assert(ps.cut_enumeration_ps.cut_limit < max_cut_num &&
            "cut_limit exceeds the compile-time limit for the maximum number of "
            "cuts");
 
     if constexpr (StoreFunction) {
-      TT zero(0u), proj(1u);
-      kitty::create_nth_var(proj, 0u);
+      if (small_functions) {
+        /* same ids as below: 0 for constant zero, 2 for the projection */
+        small_truth_tables.insert(0u, 0u);
+        small_truth_tables.insert(0xaaaaaaaaaaaaaaaaull, 1u);
+      } else {
+        TT zero(0u), proj(1u);
+        kitty::create_nth_var(proj, 0u);
 
-      truth_tables.resize(20000);
+        truth_tables.resize(20000);
 
-      truth_tables.insert(zero);
-      truth_tables.insert(proj);
+        truth_tables.insert(zero);
+        truth_tables.insert(proj);
+      }
 
       if constexpr (!std::is_same<LUTCostFn, lut_unitary_cost>::value) {
         truth_tables_cost.reserve(1000);
@@ -473,6 +703,10 @@ class lut_map_impl {
     topo_view<Ntk>(ntk).foreach_node(
         [this](auto n) { top_order.push_back(n); });
 
+    if (workspaces.size() > 1u) {
+      compute_level_order(top_order);
+    }
+
     if (ps.collapse_mffcs) {
       compute_mffcs_mapping();
       return;
@@ -482,6 +716,82 @@ class lut_map_impl {
     init_nodes();
     init_cuts();
 
+    map_nodes();
+  }
+
+  /*! \brief Remaps the network after local changes.
+   *
+   * Requires a previous call of `run` with `keep_cut_sets` enabled.  Only
+   * the nodes in `changed`, new nodes and their transitive fanout are
+   * remapped, the cuts of all other nodes are reused.  References, required
+   * times and the resulting cover are updated globally.  Returns false,
+   * without a valid mapping, if a remapped node has more fanins than fit in
+   * a cut; the caller then maps the network from scratch.
+   */
+  bool run_incremental(std::vector<node> const& changed) {
+    stopwatch t(st.time_total);
+    assert(keep_cut_sets && "incremental mapping needs the cut sets");
+
+    auto const old_size = static_cast<uint32_t>(best_cuts.size());
+    node_match.resize(ntk.size());
+    best_cuts.resize(ntk.size());
+    cuts.resize(ntk.size());
+
+    top_order.clear();
+    topo_view<Ntk>(ntk).foreach_node(
+        [this](auto n) { top_order.push_back(n); });
+
+    /* mark the transitive fanout of changed and new nodes */
+    std::vector<bool> dirty(ntk.size(), false);
+    for (auto const& n : changed) {
+      dirty[ntk.node_to_index(n)] = true;
+    }
+    dirty_order.clear();
+    for (auto const& n : top_order) {
+      auto const index = ntk.node_to_index(n);
+      if (ntk.is_constant(n)) continue;
+      if (ntk.is_pi(n)) {
+        if (index >= old_size) {
+          auto& set = workspaces[0].set(0);
+          set.clear();
+          add_unit_cut(set, index);
+          store_cuts(index, set);
+        }
+        continue;
+      }
+
+      bool is_dirty = dirty[index] || index >= old_size;
+      ntk.foreach_fanin(n, [&](auto const& f) {
+        is_dirty = is_dirty || dirty[ntk.node_to_index(ntk.get_node(f))];
+      });
+      if (!is_dirty) continue;
+
+      dirty[index] = true;
+      dirty_order.push_back(n);
+      node_match[index].map_refs = ntk.fanout_size(n);
+      node_match[index].est_refs = static_cast<float>(ntk.fanout_size(n));
+      if (!seed_cut(n)) return false;
+    }
+
+    if (workspaces.size() > 1u) {
+      compute_level_order(dirty_order);
+    }
+
+    /* derive references and delay of the cover with the seeded cuts */
+    set_mapping_refs<false>();
+
+    incremental = true;
+    map_nodes();
+    incremental = false;
+    return true;
+  }
+
+  /*! \brief Keeps all cut sets alive between calls (see `run_incremental`). */
+  void set_keep_cut_sets(bool keep) { keep_cut_sets = keep; }
+
+ private:
+  /* mapping passes over `mapped_order()` */
+  void map_nodes() {
     /* compute mapping for depth or area */
     if (!ps.area_oriented_mapping) {
       compute_required_time();
@@ -538,6 +848,7 @@ class lut_map_impl {
     derive_mapping();
   }
 
+ public:
   void print() {
     std::stringstream stats;
     stats << fmt::format("Delay = {:5d}  Area = {:6d}  Edges = {:7d}\n", delay,
@@ -558,46 +869,137 @@ class lut_map_impl {
   }
 
   void init_cuts() {
+    auto& set = workspaces[0].set(0);
+
     /* init constant cut */
-    add_zero_cut(ntk.node_to_index(ntk.get_node(ntk.get_constant(false))));
+    auto const c0 = ntk.node_to_index(ntk.get_node(ntk.get_constant(false)));
+    set.clear();
+    add_zero_cut(set, c0);
+    store_cuts(c0, set);
     if (ntk.get_node(ntk.get_constant(false)) !=
-        ntk.get_node(ntk.get_constant(true)))
-      add_zero_cut(ntk.node_to_index(ntk.get_node(ntk.get_constant(true))));
+        ntk.get_node(ntk.get_constant(true))) {
+      auto const c1 = ntk.node_to_index(ntk.get_node(ntk.get_constant(true)));
+      set.clear();
+      add_zero_cut(set, c1);
+      store_cuts(c1, set);
+    }
 
     /* init PIs cuts */
-    ntk.foreach_pi([&](auto const& n) { add_unit_cut(ntk.node_to_index(n)); });
+    ntk.foreach_pi([&](auto const& n) {
+      auto const index = ntk.node_to_index(n);
+      set.clear();
+      add_unit_cut(set, index);
+      store_cuts(index, set);
+    });
+  }
+
+  std::vector<node> const& mapped_order() const {
+    return incremental ? dirty_order : top_order;
+  }
+
+  /* Gives a node whose fanins changed the cut made of its fanins as best
+   * cut, so that the incremental passes start from a valid cover.  Returns
+   * false if the fanins do not fit in a cut. */
+  bool seed_cut(node const& n) {
+    auto const index = ntk.node_to_index(n);
+
+    std::vector<uint32_t> leaves;
+    std::vector<cut_t> fanin_cuts;
+    ntk.foreach_fanin(n, [&](auto const& f) {
+      auto const leaf = ntk.node_to_index(ntk.get_node(f));
+      fanin_cuts.emplace_back();
+      if (ntk.is_constant(ntk.get_node(f))) {
+        add_zero_cut_data(fanin_cuts.back(), leaf);
+      } else {
+        add_unit_cut_data(fanin_cuts.back(), leaf);
+        leaves.push_back(leaf);
+      }
+    });
+    std::sort(leaves.begin(), leaves.end());
+    leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
+    if (leaves.size() > ps.cut_enumeration_ps.cut_size) return false;
+
+    cut_t cut;
+    cut.set_leaves(leaves.begin(), leaves.end());
+    if constexpr (StoreFunction) {
+      std::vector<cut_t const*> vcuts;
+      for (auto const& c : fanin_cuts) vcuts.push_back(&c);
+      cut->func_id = compute_truth_table(index, vcuts, cut);
+    }
+    compute_cut_data<false>(cut, n, true);
+
+    auto& set = workspaces[0].set(0);
+    set.clear();
+    set.simple_insert(cut);
+    add_unit_cut(set, index);
+    store_cuts(index, set);
+    return true;
+  }
+
+  /* stores the cut set of a node, its first cut is the best cut */
+  void store_cuts(uint32_t index, cut_set_t const& set) {
+    best_cuts[index] = set[0];
+    cuts.store(index, set);
+  }
+
+  void replace_best_cut(uint32_t index, cut_t const& cut,
+                        cut_set_t& scratch) {
+    best_cuts[index] = cut;
+    if (cuts.has(index)) {
+      cuts.load(index, scratch);
+      scratch.replace(0, cut);
+      cuts.store(index, scratch);
+    }
   }
 
   template <bool DO_AREA, bool ELA>
   void compute_mapping(lut_cut_sort_type const sort, bool preprocess,
                        bool recompute_cuts) {
     cuts_total = 0;
-    for (auto const& n : top_order) {
-      if constexpr (!ELA) {
-        auto const index = ntk.node_to_index(n);
-        if (!preprocess && iteration != 0) {
-          node_match[index].est_refs =
-              (2.0 * node_match[index].est_refs + node_match[index].map_refs) /
-              3.0;
-        } else {
-          node_match[index].est_refs =
-              static_cast<float>(node_match[index].map_refs);
+
+    /* when all passes recompute cuts, a cut set is dead once all its fanouts
+     * have been processed, only the best cut is needed afterwards */
+    bool const release = recompute_cuts && ps.recompute_cuts && !keep_cut_sets;
+
+    /* reference counts are only updated in area recovery after the first
+     * iteration, without them nodes of the same level are independent */
+    constexpr bool independent_nodes = !StoreFunction && !ELA;
+    if (independent_nodes && (!DO_AREA || iteration == 0) &&
+        workspaces.size() > 1u) {
+      std::vector<uint32_t> thread_cuts(workspaces.size(), 0u);
+      if (release && level_release.nodes.empty()) {
+        level_release = compute_release_list(level_order);
+      }
+      level_release.next = 0u;
+      for (auto l = 0u; l + 1 < level_offsets.size(); ++l) {
+        parallel_for(
+            static_cast<uint32_t>(workspaces.size()), level_offsets[l],
+            level_offsets[l + 1],
+            [&](auto i, auto thread_id) {
+              thread_cuts[thread_id] += compute_node<DO_AREA, ELA>(
+                  level_order[i], sort, preprocess, recompute_cuts,
+                  workspaces[thread_id]);
+            },
+            256u);
+        if (release) {
+          release_cuts(level_release, level_offsets[l + 1]);
         }
       }
-
-      if (ntk.is_constant(n) || ntk.is_pi(n)) {
-        continue;
+      for (auto const c : thread_cuts) {
+        cuts_total += c;
       }
-
-      if (recompute_cuts) {
-        if constexpr (Ntk::min_fanin_size == 2 && Ntk::max_fanin_size == 2) {
-          compute_best_cut2<DO_AREA, ELA>(n, sort, preprocess);
-        } else {
-          compute_best_cut<DO_AREA, ELA>(n, sort, preprocess);
+    } else {
+      if (release && topo_release.nodes.empty()) {
+        topo_release = compute_release_list(top_order);
+      }
+      topo_release.next = 0u;
+      auto const& order = mapped_order();
+      for (auto i = 0u; i < order.size(); ++i) {
+        cuts_total += compute_node<DO_AREA, ELA>(
+            order[i], sort, preprocess, recompute_cuts, workspaces[0]);
+        if (release) {
+          release_cuts(topo_release, i + 1u);
         }
-      } else {
-        /* update cost the function and move the best one first */
-        update_cut_data<DO_AREA, ELA>(n, sort);
       }
     }
 
@@ -636,6 +1038,104 @@ class lut_map_impl {
     }
   }
 
+  template <bool DO_AREA, bool ELA>
+  uint32_t compute_node(node const& n, lut_cut_sort_type const sort,
+                        bool preprocess, bool recompute_cuts,
+                        workspace_t& ws) {
+    if constexpr (!ELA) {
+      auto const index = ntk.node_to_index(n);
+      if (!preprocess && iteration != 0) {
+        node_match[index].est_refs =
+            (2.0 * node_match[index].est_refs + node_match[index].map_refs) /
+            3.0;
+      } else {
+        node_match[index].est_refs =
+            static_cast<float>(node_match[index].map_refs);
+      }
+    }
+
+    if (ntk.is_constant(n) || ntk.is_pi(n)) {
+      return 0u;
+    }
+
+    if (recompute_cuts) {
+      if constexpr (Ntk::min_fanin_size == 2 && Ntk::max_fanin_size == 2) {
+        return compute_best_cut2<DO_AREA, ELA>(n, sort, preprocess, ws);
+      } else {
+        return compute_best_cut<DO_AREA, ELA>(n, sort, preprocess, ws);
+      }
+    } else {
+      /* update cost the function and move the best one first */
+      update_cut_data<DO_AREA, ELA>(n, sort, ws);
+      return 0u;
+    }
+  }
+
+  /* gates of `order` sorted by the position of their last fanout */
+  release_list compute_release_list(std::vector<node> const& order) {
+    std::vector<uint64_t> last_use(ntk.size(), 0u);
+    for (auto i = 0u; i < order.size(); ++i) {
+      auto const& n = order[i];
+      last_use[ntk.node_to_index(n)] = i;
+      if (ntk.is_constant(n) || ntk.is_pi(n)) continue;
+
+      ntk.foreach_fanin(n, [&](auto const& f) {
+        auto& last = last_use[ntk.node_to_index(ntk.get_node(f))];
+        last = std::max<uint64_t>(last, i);
+      });
+    }
+
+    release_list list;
+    for (auto const& n : order) {
+      if (ntk.is_constant(n) || ntk.is_pi(n)) continue;
+      list.nodes.push_back(ntk.node_to_index(n));
+    }
+    std::stable_sort(list.nodes.begin(), list.nodes.end(),
+                     [&](auto a, auto b) { return last_use[a] < last_use[b]; });
+    list.last_use.reserve(list.nodes.size());
+    for (auto const index : list.nodes) {
+      list.last_use.push_back(last_use[index]);
+    }
+    return list;
+  }
+
+  /* frees the cut sets whose last use is before position `pos` */
+  void release_cuts(release_list& list, uint64_t pos) {
+    while (list.next < list.nodes.size() && list.last_use[list.next] < pos) {
+      cuts.release(list.nodes[list.next++]);
+    }
+  }
+
+  /* groups the nodes of `order` by level, keeping the relative order */
+  void compute_level_order(std::vector<node> const& order) {
+    std::vector<uint32_t> levels(ntk.size(), 0u);
+    uint32_t max_level = 0u;
+    for (auto const& n : top_order) {
+      if (ntk.is_constant(n) || ntk.is_pi(n)) continue;
+
+      uint32_t level = 0u;
+      ntk.foreach_fanin(n, [&](auto const& f) {
+        level = std::max(level, levels[ntk.node_to_index(ntk.get_node(f))]);
+      });
+      levels[ntk.node_to_index(n)] = level + 1u;
+      max_level = std::max(max_level, level + 1u);
+    }
+
+    level_offsets.assign(max_level + 2u, 0u);
+    for (auto const& n : order) {
+      ++level_offsets[levels[ntk.node_to_index(n)] + 1u];
+    }
+    for (auto l = 1u; l < level_offsets.size(); ++l) {
+      level_offsets[l] += level_offsets[l - 1];
+    }
+
+    level_order.resize(order.size());
+    std::vector<uint64_t> next(level_offsets.begin(), level_offsets.end() - 1);
+    for (auto const& n : order) {
+      level_order[next[levels[ntk.node_to_index(n)]]++] = n;
+    }
+  }
+
   template <bool ELA>
   void expand_cuts() {
     /* cut expansion is not yet compatible with truth table computation */
@@ -644,7 +1144,7 @@ class lut_map_impl {
     /* don't expand if cut recomputed cuts is off */
     if (!ps.recompute_cuts) return;
 
-    for (auto const& n : top_order) {
+    for (auto const& n : mapped_order()) {
       if (ntk.is_constant(n) || ntk.is_pi(n)) {
         continue;
       }
@@ -668,7 +1168,7 @@ class lut_map_impl {
     ntk.foreach_po([this](auto s) {
       const auto index = ntk.node_to_index(ntk.get_node(s));
 
-      delay = std::max(delay, cuts[index][0]->data.delay);
+      delay = std::max(delay, best_cuts[index]->data.delay);
 
       if constexpr (!ELA) {
         ++node_match[index].map_refs;
@@ -690,7 +1190,7 @@ class lut_map_impl {
       /* continue if not referenced in the cover */
       if (node_match[index].map_refs == 0u) continue;
 
-      auto& best_cut = cuts[index][0];
+      auto& best_cut = best_cuts[index];
 
       if constexpr (!ELA) {
         for (auto const leaf : best_cut) {
@@ -747,7 +1247,7 @@ class lut_map_impl {
 
       if (node_match[index].map_refs == 0) continue;
 
-      for (auto leaf : cuts[index][0]) {
+      for (auto leaf : best_cuts[index]) {
         node_match[leaf].required =
             std::min(node_match[leaf].required, node_match[index].required - 1);
       }
@@ -755,32 +1255,34 @@ class lut_map_impl {
   }
 
   template <bool DO_AREA, bool ELA>
-  void compute_best_cut2(node const& n, lut_cut_sort_type const sort,
-                         bool preprocess) {
+  uint32_t compute_best_cut2(node const& n, lut_cut_sort_type const sort,
+                             bool preprocess, workspace_t& ws) {
     auto index = ntk.node_to_index(n);
     auto& node_data = node_match[index];
+    auto& lcuts = ws.lcuts;
     cut_t best_cut;
 
     /* compute cuts */
     const auto fanin = 2;
     uint32_t pairs{1};
     ntk.foreach_fanin(
-        ntk.index_to_node(index), [this, &pairs](auto child, auto i) {
-          lcuts[i] = &cuts[ntk.node_to_index(ntk.get_node(child))];
+        ntk.index_to_node(index), [this, &ws, &lcuts, &pairs](auto child, auto i) {
+          lcuts[i] = &ws.set(i);
+          cuts.load(ntk.node_to_index(ntk.get_node(child)), *lcuts[i]);
           pairs *= static_cast<uint32_t>(lcuts[i]->size());
         });
-    lcuts[2] = &cuts[index];
+    lcuts[2] = &ws.set(2);
     auto& rcuts = *lcuts[fanin];
 
     if constexpr (DO_AREA) {
       if (iteration != 0 && node_data.map_refs > 0) {
-        cut_deref(rcuts[0]);
+        cut_deref(best_cuts[index]);
       }
     }
 
     /* recompute the data of the best cut */
     if (iteration != 0) {
-      best_cut = rcuts[0];
+      best_cut = best_cuts[index];
       compute_cut_data<ELA>(best_cut, n, true);
     }
 
@@ -793,7 +1295,8 @@ class lut_map_impl {
     }
 
     cut_t new_cut;
-    std::vector<cut_t const*> vcuts(fanin);
+    auto& vcuts = ws.vcuts;
+    vcuts.resize(fanin);
 
     for (auto const& c1 : *lcuts[0]) {
       for (auto const& c2 : *lcuts[1]) {
@@ -830,7 +1333,7 @@ class lut_map_impl {
       }
     }
 
-    cuts_total += rcuts.size();
+    const uint32_t num_cuts = rcuts.size();
 
     /* limit the maximum number of cuts */
     rcuts.limit(ps.cut_enumeration_ps.cut_limit);
@@ -841,7 +1344,7 @@ class lut_map_impl {
 
     /* add trivial cut */
     if (rcuts.size() > 1 || (*rcuts.begin())->size() > 1) {
-      add_unit_cut(index);
+      add_unit_cut(rcuts, index);
     }
 
     if constexpr (DO_AREA) {
@@ -849,37 +1352,44 @@ class lut_map_impl {
         cut_ref(rcuts[0]);
       }
     }
+
+    store_cuts(index, rcuts);
+    return num_cuts;
   }
 
   template <bool DO_AREA, bool ELA>
-  void compute_best_cut(node const& n, lut_cut_sort_type const sort,
-                        bool preprocess) {
+  uint32_t compute_best_cut(node const& n, lut_cut_sort_type const sort,
+                            bool preprocess, workspace_t& ws) {
     auto index = ntk.node_to_index(n);
     auto& node_data = node_match[index];
+    auto& lcuts = ws.lcuts;
     cut_t best_cut;
 
     /* compute cuts */
     uint32_t pairs{1};
-    std::vector<uint32_t> cut_sizes;
-    ntk.foreach_fanin(ntk.index_to_node(index), [this, &pairs, &cut_sizes](
-                                                    auto child, auto i) {
-      lcuts[i] = &cuts[ntk.node_to_index(ntk.get_node(child))];
+    auto& cut_sizes = ws.cut_sizes;
+    cut_sizes.clear();
+    ntk.foreach_fanin(ntk.index_to_node(index), [this, &ws, &lcuts, &pairs,
+                                                 &cut_sizes](auto child,
+                                                             auto i) {
+      lcuts[i] = &ws.set(i);
+      cuts.load(ntk.node_to_index(ntk.get_node(child)), *lcuts[i]);
       cut_sizes.push_back(static_cast<uint32_t>(lcuts[i]->size()));
       pairs *= cut_sizes.back();
     });
     const auto fanin = cut_sizes.size();
-    lcuts[fanin] = &cuts[index];
+    lcuts[fanin] = &ws.set(static_cast<uint32_t>(fanin));
     auto& rcuts = *lcuts[fanin];
 
     if constexpr (DO_AREA) {
       if (iteration != 0 && node_data.map_refs > 0) {
-        cut_deref(rcuts[0]);
+        cut_deref(best_cuts[index]);
       }
     }
 
     /* recompute the data of the best cut */
     if (iteration != 0) {
-      best_cut = rcuts[0];
+      best_cut = best_cuts[index];
       compute_cut_data<ELA>(best_cut, n, true);
     }
 
@@ -894,7 +1404,8 @@ class lut_map_impl {
     if (fanin > 1 && fanin <= ps.cut_enumeration_ps.fanin_limit) {
       cut_t new_cut, tmp_cut;
 
-      std::vector<cut_t const*> vcuts(fanin);
+      auto& vcuts = ws.vcuts;
+      vcuts.resize(fanin);
 
       foreach_mixed_radix_tuple(
           cut_sizes.begin(), cut_sizes.end(), [&](auto begin, auto end) {
@@ -976,26 +1487,31 @@ class lut_map_impl {
       rcuts.limit(ps.cut_enumeration_ps.cut_limit);
     }
 
-    cuts_total += rcuts.size();
+    const uint32_t num_cuts = rcuts.size();
 
     /* replace the new best cut with previous one */
     if (preprocess && rcuts[0]->data.delay > node_data.required)
       rcuts.replace(0, best_cut);
 
-    add_unit_cut(index);
+    add_unit_cut(rcuts, index);
 
     if constexpr (DO_AREA) {
       if (iteration != 0 && node_data.map_refs > 0) {
         cut_ref(rcuts[0]);
       }
     }
+
+    store_cuts(index, rcuts);
+    return num_cuts;
   }
 
   template <bool DO_AREA, bool ELA>
-  void update_cut_data(node const& n, lut_cut_sort_type const sort) {
+  void update_cut_data(node const& n, lut_cut_sort_type const sort,
+                       workspace_t& ws) {
     auto index = ntk.node_to_index(n);
     auto& node_data = node_match[index];
-    auto& node_cut_set = cuts[index];
+    auto& node_cut_set = ws.set(0);
+    cuts.load(index, node_cut_set);
     uint32_t best_cut_index = 0;
     uint32_t cut_index = 0;
 
@@ -1043,19 +1559,20 @@ class lut_map_impl {
 
     /* update the best cut */
     node_cut_set.update_best(best_cut_index);
+    store_cuts(index, node_cut_set);
   }
 
   void expand_cuts_node(node const& n) {
     auto index = ntk.node_to_index(n);
     auto& node_data = node_match[index];
-    cut_t best_cut = cuts[index][0];
+    cut_t best_cut = best_cuts[index];
 
     if (node_data.map_refs == 0) return;
 
     /* update delay */
     uint32_t delay_update = 0;
     for (auto const leaf : best_cut) {
-      delay_update = std::max(delay_update, cuts[leaf][0]->data.delay + 1);
+      delay_update = std::max(delay_update, best_cuts[leaf]->data.delay + 1);
     }
     best_cut->data.delay = delay_update;
 
@@ -1096,7 +1613,7 @@ class lut_map_impl {
 
     uint32_t delay_after = 0;
     for (auto const leaf : leaves) {
-      delay_after = std::max(delay_after, cuts[leaf][0]->data.delay + 1);
+      delay_after = std::max(delay_after, best_cuts[leaf]->data.delay + 1);
     }
     new_cut->data.delay = delay_after;
 
@@ -1105,7 +1622,7 @@ class lut_map_impl {
     /* new cut is better */
     if (area_after <= area_before &&
         new_cut->data.delay <= node_data.required) {
-      cuts[index].replace(0, new_cut);
+      replace_best_cut(index, new_cut, workspaces[0].set(0));
     } else {
       /* restore */
       cut_deref(new_cut);
@@ -1227,7 +1744,7 @@ class lut_map_impl {
 
       /* Recursive referencing if leaf was not referenced */
       if (node_match[leaf].map_refs++ == 0u) {
-        count += cut_ref(cuts[leaf][0]);
+        count += cut_ref(best_cuts[leaf]);
       }
     }
     return count;
@@ -1244,7 +1761,7 @@ class lut_map_impl {
 
       /* Recursive referencing if leaf was not referenced */
       if (--node_match[leaf].map_refs == 0u) {
-        count += cut_deref(cuts[leaf][0]);
+        count += cut_deref(best_cuts[leaf]);
       }
     }
     return count;
@@ -1261,7 +1778,7 @@ class lut_map_impl {
 
       /* Recursive referencing if leaf was not referenced */
       if (node_match[leaf].map_refs++ == 0u) {
-        count += cut_edge_ref(cuts[leaf][0]);
+        count += cut_edge_ref(best_cuts[leaf]);
       }
     }
     return count;
@@ -1278,7 +1795,7 @@ class lut_map_impl {
 
       /* Recursive referencing if leaf was not referenced */
       if (--node_match[leaf].map_refs == 0u) {
-        count += cut_edge_deref(cuts[leaf][0]);
+        count += cut_edge_deref(best_cuts[leaf]);
       }
     }
     return count;
@@ -1294,7 +1811,7 @@ class lut_map_impl {
       if (node_match[index].map_refs == 0) continue;
 
       std::vector<node> nodes;
-      auto const& best_cut = cuts[index][0];
+      auto const& best_cut = best_cuts[index];
 
       for (auto const& l : best_cut) {
         nodes.push_back(ntk.index_to_node(l));
@@ -1302,7 +1819,7 @@ class lut_map_impl {
       ntk.add_to_mapping(n, nodes.begin(), nodes.end());
 
       if constexpr (StoreFunction) {
-        ntk.set_cell_function(n, truth_tables[best_cut->func_id]);
+        ntk.set_cell_function(n, cut_function(best_cut->func_id));
       }
     }
 
@@ -1350,12 +1867,15 @@ class lut_map_impl {
 
     if (recompute_cut_cost) {
       if constexpr (StoreFunction) {
-        if constexpr (!std::is_same<LUTCostFn, lut_unitary_cost>::value) {
+        if (small_functions) {
+          std::tie(lut_area, lut_delay) = small_function_cost(cut->func_id);
+        } else if constexpr (!std::is_same<LUTCostFn,
+                                           lut_unitary_cost>::value) {
           if (auto it = truth_tables_cost.find(cut->func_id);
               it != truth_tables_cost.end()) {
             std::tie(lut_area, lut_delay) = it->second;
           } else {
-            auto cost = lut_cost(truth_tables[cut->func_id]);
+            auto cost = function_cost(truth_tables[cut->func_id]);
             if (truth_tables[cut->func_id].num_vars() <= ps.cost_cache_vars) {
               /* cache it */
               truth_tables_cost[cut->func_id] = cost;
@@ -1377,7 +1897,7 @@ class lut_map_impl {
     if constexpr (ELA) {
       uint32_t delay{0};
       for (auto leaf : cut) {
-        const auto& best_leaf_cut = cuts[leaf][0];
+        const auto& best_leaf_cut = best_cuts[leaf];
         delay = std::max(delay, best_leaf_cut->data.delay);
       }
 
@@ -1398,7 +1918,7 @@ class lut_map_impl {
       float edge_flow = cut.size();
 
       for (auto leaf : cut) {
-        const auto& best_leaf_cut = cuts[leaf][0];
+        const auto& best_leaf_cut = best_cuts[leaf];
         delay = std::max(delay, best_leaf_cut->data.delay);
         if (node_match[leaf].map_refs > 0 && leaf != 0) {
           area_flow +=
@@ -1419,24 +1939,63 @@ class lut_map_impl {
     }
   }
 
-  void add_zero_cut(uint32_t index) {
-    auto& cut =
-        cuts[index].add_cut(&index, &index); /* fake iterator for emptyness */
+  void add_zero_cut(cut_set_t& set, uint32_t index) {
+    add_zero_cut_data(set.add_cut(&index, &index), index);
+  }
+
+  void add_zero_cut_data(cut_t& cut, uint32_t index) {
+    cut.set_leaves(&index, &index); /* fake iterator for emptyness */
 
     if constexpr (StoreFunction) {
       cut->func_id = 0;
     }
   }
 
-  void add_unit_cut(uint32_t index) {
-    auto& cut = cuts[index].add_cut(&index, &index + 1);
+  void add_unit_cut(cut_set_t& set, uint32_t index) {
+    add_unit_cut_data(set.add_cut(&index, &index + 1), index);
+  }
+
+  void add_unit_cut_data(cut_t& cut, uint32_t index) {
+    cut.set_leaves(&index, &index + 1);
 
     if constexpr (StoreFunction) {
       cut->func_id = 2;
     }
   }
 
-  inline bool fast_support_minimization(TT const& tt, cut_t& res) {
+  TT cut_function(uint32_t func_id) const {
+    return small_functions ? small_truth_tables[func_id]
+                           : truth_tables[func_id];
+  }
+
+  std::pair<uint32_t, uint32_t> function_cost(TT const& tt) {
+    if (ps.cost_database != nullptr) {
+      static std::string const cost_id =
+          lut_cost_function_id<LUTCostFn>::get();
+      return ps.cost_database->lookup(cost_id, tt, lut_cost);
+    }
+    return lut_cost(tt);
+  }
+
+  /* costs of small functions are cached densely by function id; as for
+   * larger cuts, only those with at most `cost_cache_vars` variables */
+  std::pair<uint32_t, uint32_t> small_function_cost(uint32_t func_id) {
+    if (small_truth_tables.num_vars(func_id) > ps.cost_cache_vars) {
+      return function_cost(small_truth_tables[func_id]);
+    }
+    if (small_costs.size() < small_truth_tables.num_ids()) {
+      small_costs.resize(small_truth_tables.num_ids(),
+                         {std::numeric_limits<uint32_t>::max(), 0u});
+    }
+    auto& cost = small_costs[func_id];
+    if (cost.first == std::numeric_limits<uint32_t>::max()) {
+      cost = function_cost(small_truth_tables[func_id]);
+    }
+    return cost;
+  }
+
+  template <typename TTc>
+  inline bool fast_support_minimization(TTc const& tt, cut_t& res) {
     uint32_t support = 0u;
     uint32_t support_size = 0u;
     for (uint32_t i = 0u; i < tt.num_vars(); ++i) {
@@ -1466,6 +2025,10 @@ class lut_map_impl {
     // stopwatch t( st.cut_enumeration_st.time_truth_table ); /* runtime
     // optimized */
 
+    if (small_functions) {
+      return compute_truth_table_small(index, vcuts, res);
+    }
+
     std::vector<TT> tt(vcuts.size());
     auto i = 0;
     for (auto const& cut : vcuts) {
@@ -1498,6 +2061,53 @@ class lut_map_impl {
     return truth_tables.insert(tt_res);
   }
 
+  /* Same as `compute_truth_table` for cuts with at most 6 leaves, on
+   * replicated 64-bit truth tables which need no extension and no heap
+   * allocation.  The stored number of variables matches the one of the
+   * generic version, so costs and function ids are identical. */
+  uint32_t compute_truth_table_small(uint32_t index,
+                                     std::vector<cut_t const*> const& vcuts,
+                                     cut_t& res) {
+    small_tts.resize(vcuts.size());
+    auto i = 0u;
+    for (auto const& cut : vcuts) {
+      auto& tt = small_tts[i++];
+      tt._bits = small_truth_tables.bits((*cut)->func_id);
+
+      /* move the variables to the positions of the leaves in `res` */
+      std::array<uint8_t, 6u> support;
+      uint32_t j = 0u;
+      auto itp = res.begin();
+      for (auto l : *cut) {
+        itp = std::find(itp, res.end(), l);
+        support[j++] = static_cast<uint8_t>(std::distance(res.begin(), itp));
+      }
+      for (int k = static_cast<int>(j) - 1; k >= 0; --k) {
+        kitty::swap_inplace(tt, k, support[k]);
+      }
+    }
+
+    auto tt_res =
+        ntk.compute(ntk.index_to_node(index), small_tts.begin(), small_tts.end());
+    uint32_t num_vars = res.size();
+
+    if (ps.cut_enumeration_ps.minimize_truth_table &&
+        !fast_support_minimization(tt_res, res)) {
+      const auto support = kitty::min_base_inplace(tt_res);
+      if (support.size() != res.size()) {
+        std::array<uint32_t, 6u> leaves_after;
+        for (auto k = 0u; k < support.size(); ++k) {
+          leaves_after[k] = *(res.begin() + support[k]);
+        }
+        res.set_leaves(leaves_after.begin(),
+                       leaves_after.begin() + support.size());
+        num_vars = static_cast<uint32_t>(support.size());
+      }
+    }
+
+    return small_truth_tables.insert(tt_res._bits, num_vars);
+  }
+
   void compute_mffcs_mapping() {
     ntk.clear_mapping();
 
@@ -1638,12 +2248,25 @@ class lut_map_impl {
   LUTCostFn lut_cost{};
 
   std::vector<node> top_order;
+  std::vector<node> level_order;      /* top_order grouped by level */
+  std::vector<uint64_t> level_offsets; /* level bounds in level_order */
   std::vector<node_lut> node_match;
 
-  std::vector<cut_set_t> cuts;  /* compressed representation of cuts */
-  cut_merge_t lcuts;            /* cut merger container */
+  std::vector<cut_t> best_cuts;         /* best cut of each node */
+  lut_cut_store<cut_t> cuts;            /* packed cut sets */
+  release_list topo_release;            /* cut set lifetimes in top_order */
+  release_list level_release;           /* cut set lifetimes in level_order */
+  bool keep_cut_sets{false};            /* never release cut sets */
+  bool incremental{false};              /* map only `dirty_order` */
+  std::vector<node> dirty_order;        /* nodes remapped incrementally */
+  std::vector<workspace_t> workspaces; /* cut merger containers per thread */
   tt_cache truth_tables;        /* cut truth tables */
   cost_cache truth_tables_cost; /* truth tables cost */
+
+  bool small_functions;                   /* cut functions fit in 64 bits */
+  lut_small_tt_cache small_truth_tables;  /* cut truth tables up to 6 vars */
+  std::vector<std::pair<uint32_t, uint32_t>> small_costs; /* cost by id */
+  std::vector<STT> small_tts;             /* scratch for cut merging */
 };
 #pragma endregion
 
@@ -1727,4 +2350,79 @@ void lut_map(Ntk& ntk, lut_map_params const& ps = {},
   }
 }
 
+/*! \brief LUT mapper that remaps only the edited part of a network.
+ *
+ * The first call of `run` maps the whole network like `lut_map` and keeps
+ * all cut sets.  Nodes added or modified afterwards are collected through
+ * the network events (nodes changed otherwise can be reported with
+ * `mark_changed`), and the next call of `run` recomputes cuts and reruns
+ * the area recovery rounds only on their transitive fanout.  Required
+ * times, references and the mapping itself are still derived globally.
+ *
+ * The object must not outlive the network.  With `collapse_mffcs`, or when
+ * a remapped node has more fanins than fit in a cut, the call maps the
+ * whole network.
+ */
+template <class Ntk, bool StoreFunction = false,
+          class LUTCostFn = lut_unitary_cost>
+class lut_map_incremental {
+ public:
+  using node = typename Ntk::node;
+
+  explicit lut_map_incremental(Ntk& ntk, lut_map_params const& ps = {})
+      : ntk(ntk), ps(ps) {
+    add_event = ntk.events().register_add_event(
+        [this](auto const& n) { changed.push_back(n); });
+    modified_event = ntk.events().register_modified_event(
+        [this](auto const& n, auto const& previous) {
+          (void)previous;
+          changed.push_back(n);
+        });
+  }
+
+  ~lut_map_incremental() {
+    ntk.events().release_add_event(add_event);
+    ntk.events().release_modified_event(modified_event);
+  }
+
+  lut_map_incremental(lut_map_incremental const&) = delete;
+  lut_map_incremental& operator=(lut_map_incremental const&) = delete;
+
+  /*! \brief Reports a node whose function changed outside of the events. */
+  void mark_changed(node const& n) { changed.push_back(n); }
+
+  /*! \brief Maps the network, incrementally after the first call. */
+  void run(lut_map_stats* pst = nullptr) {
+    st = {};
+    if (!p || ps.collapse_mffcs || !p->run_incremental(changed)) {
+      st = {};
+      p = std::make_unique<impl_t>(ntk, ps, st);
+      p->set_keep_cut_sets(true);
+      p->run();
+    }
+    changed.clear();
+    p->print();
+
+    if (ps.verbose) {
+      st.report();
+    }
+
+    if (pst != nullptr) {
+      *pst = st;
+    }
+  }
+
+ private:
+  using impl_t = detail::lut_map_impl<Ntk, StoreFunction, LUTCostFn>;
+
+  Ntk& ntk;
+  lut_map_params const ps;
+  lut_map_stats st;
+  std::unique_ptr<impl_t> p;
+  std::vector<node> changed;
+  std::shared_ptr<typename network_events<Ntk>::add_event_type> add_event;
+  std::shared_ptr<typename network_events<Ntk>::modified_event_type>
+      modified_event;
+};
+
 }  // namespace phyLS
@@ -32,9 +32,18 @@
 
 #pragma once
 
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
 #include <mockturtle/algorithms/mapper.hpp>
 #include "MCTS.hpp"
+#include "../core/read_placement_file.hpp"
 #include "../core/utils/data_structure.hpp"
+#include "../core/utils/async_writer.hpp"
+#include "../core/utils/incremental_timing.hpp"
+#include "../core/utils/parallel.hpp"
 
 namespace mockturtle {
 
@@ -327,8 +336,13 @@ public:
     {
       std::cout<<"size of np : "<<np.size()<<" ntk size is : "<<ntk.size()<<"\n";
       // auto [delay, area] = phyLS::_stime(lib_file, ps.baseline_v, ps.baseline_def);
-      auto [delay, area] = phyLS::stime(lib_file, ps.baseline_v);
-      std::cout<<"Baseline : Delay reward = "<<delay<<"\tArea reward = "<<area<<"\n";
+      if (!baseline)
+      {
+        /* stime runs on the global ABC frame */
+        std::lock_guard<std::mutex> lock(phyLS::abc_frame_mutex());
+        baseline = phyLS::stime(lib_file, ps.baseline_v);
+      }
+      std::cout<<"Baseline : Delay reward = "<<baseline->first<<"\tArea reward = "<<baseline->second<<"\n";
     }
 
     return delay;
@@ -537,6 +551,7 @@ public:
     std::cout<<"compute_statistic\n";
     // clear all elements in queue;
     clear_queue();
+    vec_ics.clear();
 
     for (uint8_t phase = 0; phase < 2; phase++) {
       ntk.foreach_gate([&](auto const& n) {
@@ -590,11 +605,8 @@ public:
             ics.wirelength = wirelength;
             ics.totalwirelength = totalwirelength;
             
-            // insert available match into queues
-            area_queue.insert(ics);
-            delay_queue.insert(ics);
-            wirelength_queue.insert(ics);
-            totalwirelength_queue.insert(ics);
+            // record available match, the queues are built at once
+            vec_ics.push_back(ics);
             // std::cout << "delay = " << ics.delay << ", area = " << ics.area
             //           << ", wirelength = " << ics.wirelength
             //           << ", totalwirelength = " << ics.totalwirelength
@@ -605,16 +617,8 @@ public:
         return;
       });
     }
-    if((area_queue.size() != delay_queue.size()) || (wirelength_queue.size() != area_queue.size()))
-    {
-      std::cerr << "queue size differs\n";
-    }
-    queue_size = area_queue.size();
-
-    std::cout << "area_queue size = "<<area_queue.size()<<"\n";
-    std::cout << "delay_queue size = "<<delay_queue.size()<<"\n";
-    std::cout << "wirelength_queue = "<<wirelength_queue.size()<<"\n";
-    std::cout << "totalwirelength_queue size = "<<totalwirelength_queue.size()<<"\n";
+    sort_queues();
+    build_queues();
     // for (auto x : area_queue)
     //   std::cout << "index(" << x.index << ")-area(" << x.area << "), ";
     // std::cout << std::endl << std::endl;
@@ -635,11 +639,37 @@ public:
     // std::cout << std::endl << std::endl;
   }
 
+  // sort the recorded matches into the four queues, once per network
+  void sort_queues()
+  {
+    area_queue.assign(vec_ics);
+    delay_queue.assign(vec_ics);
+    wirelength_queue.assign(vec_ics);
+    totalwirelength_queue.assign(vec_ics);
+    queue_size = area_queue.size();
+  }
+
+  // put back all matches popped since the queues were sorted
+  void build_queues()
+  {
+    area_queue.rewind();
+    delay_queue.rewind();
+    wirelength_queue.rewind();
+    totalwirelength_queue.rewind();
+    queue_size = area_queue.size();
+
+    std::cout << "area_queue size = "<<area_queue.size()<<"\n";
+    std::cout << "delay_queue size = "<<delay_queue.size()<<"\n";
+    std::cout << "wirelength_queue = "<<wirelength_queue.size()<<"\n";
+    std::cout << "totalwirelength_queue size = "<<totalwirelength_queue.size()<<"\n";
+  }
+
   void compute_statistic_rough() 
   {
     std::cout<<"compute_statistic\n";
     // clear all elements in queue;
     clear_queue();
+    std::vector<index_cut_supergate> area_ics, delay_ics, wirelength_ics, totalwirelength_ics;
 
     for (uint8_t phase = 0; phase < 2; phase++) {
       ntk.foreach_gate([&](auto const& n) {
@@ -712,14 +742,18 @@ public:
           }
           ++cut_index;
         }
-        area_queue.insert(delay_best_ics);
-        delay_queue.insert(area_best_ics);
-        wirelength_queue.insert(wirelength_best_ics);
-        totalwirelength_queue.insert(totalwirelength_best_ics);
+        area_ics.push_back(delay_best_ics);
+        delay_ics.push_back(area_best_ics);
+        wirelength_ics.push_back(wirelength_best_ics);
+        totalwirelength_ics.push_back(totalwirelength_best_ics);
 
         return;
       });
     }
+    area_queue.assign(area_ics);
+    delay_queue.assign(delay_ics);
+    wirelength_queue.assign(wirelength_ics);
+    totalwirelength_queue.assign(totalwirelength_ics);
     if((area_queue.size() != delay_queue.size()) || (wirelength_queue.size() != area_queue.size()))
     {
       std::cerr << "queue size differs\n";
@@ -816,20 +850,9 @@ private:
   {
     if ( _terminal ) return _terminal;
 
-    _terminal = true;
-    int unset = 0;
-    set_nodes = 0;
-    ntk.foreach_gate([&](auto const& n){
-     auto index = ntk.node_to_index(n);
-     auto const& node_data = node_match[index];
-     if ( !node_data.set_flag[0] && !node_data.set_flag[1] )
-     {
-      _terminal = false;
-      unset++;
-     }
-     else set_nodes++;
-    });
-    std::cout<<"Set nodes = "<<set_nodes<<" Unset nodes = "<<unset<<"\n"; 
+    /* set_nodes is counted as matches are committed */
+    _terminal = set_nodes >= ntk.num_gates();
+    std::cout<<"Set nodes = "<<set_nodes<<" Unset nodes = "<<ntk.num_gates() - set_nodes<<"\n"; 
     return _terminal;
   }
 
@@ -850,7 +873,11 @@ public:
     set_nodes = 0;
     _reward = 0;
     _terminal = false;
-    compute_statistic();
+    commits.clear();
+    timing_valid = false;
+    /* the gains only depend on the cuts and the placement */
+    if (vec_ics.empty()) compute_statistic();
+    else build_queues();
     init_nodes();
   }
 
@@ -879,26 +906,13 @@ public:
   }
 
   template<typename Comparator>
-  double forward(std::multiset<index_cut_supergate, Comparator>* queue, int const& depth = 0)
+  double forward(shared_sorted_queue<index_cut_supergate, Comparator>* queue, int const& depth = 0)
   {
     if (queue == nullptr) {
       std::cerr << "queue is null\n";
       exit(0);
     }
 
-
-    bool suc = !compute_mapping<false>();
-    if ( suc )
-    {
-      std::cerr<<"delay mapping flow failed\n";
-    }
-   
-    // compute_required_time();
-    // if ( !compute_mapping<true>() )
-    // {
-    //   std::cerr<<"global area mapping flow failed\n";
-    // }
-
     // in top_x, there are top x% elements of chosen queue
     std::vector<index_cut_supergate> top_x;
     get_top_percent(*queue, 0.1, top_x);
@@ -906,27 +920,158 @@ public:
     std::cout<<"taken "<<top_x.size()<<" supergates to conduct match\n";
 
     // implement selected matches to node
+    std::vector<uint32_t> changed;
     for (index_cut_supergate const& ics : top_x) {
-      auto& node_data = node_match[ics.index];
       // if the target node has set, skip all other supergates of the node
-      if (node_data.set_flag[ics.phase])
+      auto& set_flag = node_match[ics.index].set_flag;
+      if (set_flag[ics.phase])
         continue;
-      else
+      if (!set_flag[ics.phase ^ 1]) ++set_nodes;
+      set_flag[ics.phase] = true;
+      commit_match(ics);
+      commits.push_back(ics);
+      changed.push_back(ics.index);
+    }
+
+    terminated();
+
+    if (timing_valid && !_terminal)
+    {
+      /* only the cones of the changed gates are re-timed, the exact STA of
+       * the finalized netlist is deferred until it is needed */
+      auto const evaluations = timing.num_evaluations();
+      for (auto const index : changed)
+        sync_timing_node(index);
+      timing.update();
+      cover_stale = true;
+
+      double const est_delay = timing.delay() * delay_scale;
+      double const est_area = timing.area() * area_scale;
+      std::cout << fmt::format("Estimated delay = {:>12.2f}  Estimated area = {:>12.2f}  ({} vertices re-timed)\n",
+                               est_delay, est_area, timing.num_evaluations() - evaluations);
+      _reward = est_delay;
+      _mulReward = est_delay * est_area;
+    }
+    else
+    {
+      materialize();
+    }
+
+    std::cout << "area_queue size = "<<area_queue.size()<<"\n";
+    std::cout << "delay_queue size = "<<delay_queue.size()<<"\n";
+    std::cout << "wirelength_queue = "<<wirelength_queue.size()<<"\n";
+    std::cout << "totalwirelength_queue size = "<<totalwirelength_queue.size()<<"\n";
+
+    if (ps.strategy == map_params::amd) return _mulReward;
+    return _reward;
+  }
+
+  /* maps the current state to a netlist and times it exactly */
+  void finalize()
+  {
+    if (cover_stale) materialize();
+  }
+
+  /* saves the search state; pages of node_match that are unchanged since
+   * the last saved or restored snapshot are shared with it, and the queues
+   * share their sorted matches, so only their read positions are copied */
+  std::shared_ptr<const void> snapshot()
+  {
+    auto snap = std::make_shared<mapper_snapshot>();
+    auto const num_pages = (node_match.size() + snapshot_page_size - 1) / snapshot_page_size;
+    snap->pages.reserve(num_pages);
+    for (auto p = 0u; p < num_pages; ++p)
+    {
+      auto const first = node_match.begin() + p * snapshot_page_size;
+      auto const last = node_match.begin() + std::min<size_t>((p + 1) * snapshot_page_size, node_match.size());
+      if constexpr (std::is_trivially_copyable_v<node_match_tech<NInputs>>)
       {
-        node_data.set_flag[ics.phase] = true;
+        if (snapshot_base && p < snapshot_base->pages.size())
+        {
+          auto const& page = *snapshot_base->pages[p];
+          if (page.size() == static_cast<size_t>(last - first) &&
+              std::memcmp(page.data(), &*first, page.size() * sizeof(node_match_tech<NInputs>)) == 0)
+          {
+            snap->pages.push_back(snapshot_base->pages[p]);
+            continue;
+          }
+        }
       }
-      auto const& cut = cuts.cuts(ics.index)[ics.cut_index];
-      auto const& supergates = matches[ics.index][cut->data.match_index].supergates[ics.phase];
-      auto const& gate = (*supergates)[ics.supergate_index];
-      auto const negation = matches[ics.index][cut->data.match_index].negations[ics.phase];
-      node_data.best_supergate[ics.phase] = &gate;
-      node_data.phase[ics.phase] = gate.polarity ^ negation;
-      node_data.best_cut[ics.phase] = ics.cut_index;
+      snap->pages.push_back(std::make_shared<const std::vector<node_match_tech<NInputs>>>(first, last));
     }
 
+    snap->area_queue = area_queue;
+    snap->delay_queue = delay_queue;
+    snap->wirelength_queue = wirelength_queue;
+    snap->totalwirelength_queue = totalwirelength_queue;
+    snap->commits = commits;
+    snap->eventual_res = eventual_res;
+    snap->reward = _reward;
+    snap->mulReward = _mulReward;
+    snap->delay_scale = delay_scale;
+    snap->area_scale = area_scale;
+    snap->set_nodes = set_nodes;
+    snap->terminal = _terminal;
+    snap->timing_valid = timing_valid;
+    snap->cover_stale = cover_stale;
 
+    snapshot_base = snap;
+    return snap;
+  }
 
-    terminated();
+  /* resumes the search from a state saved by `snapshot` */
+  void restore(std::shared_ptr<const void> const& data)
+  {
+    auto snap = std::static_pointer_cast<const mapper_snapshot>(data);
+    auto it = node_match.begin();
+    for (auto const& page : snap->pages)
+      it = std::copy(page->begin(), page->end(), it);
+
+    area_queue = snap->area_queue;
+    delay_queue = snap->delay_queue;
+    wirelength_queue = snap->wirelength_queue;
+    totalwirelength_queue = snap->totalwirelength_queue;
+    commits = snap->commits;
+    eventual_res = snap->eventual_res;
+    _reward = snap->reward;
+    _mulReward = snap->mulReward;
+    delay_scale = snap->delay_scale;
+    area_scale = snap->area_scale;
+    set_nodes = snap->set_nodes;
+    _terminal = snap->terminal;
+    timing_valid = snap->timing_valid;
+    cover_stale = snap->cover_stale;
+
+    /* the timing graph is derived from node_match, rebuilding it is cheaper
+     * than keeping a copy per snapshot */
+    if (timing_valid) build_timing();
+    snapshot_base = std::move(snap);
+  }
+
+private:
+  void commit_match(index_cut_supergate const& ics)
+  {
+    auto& node_data = node_match[ics.index];
+    auto const& cut = cuts.cuts(ics.index)[ics.cut_index];
+    auto const& supergates = matches[ics.index][cut->data.match_index].supergates[ics.phase];
+    auto const& gate = (*supergates)[ics.supergate_index];
+    auto const negation = matches[ics.index][cut->data.match_index].negations[ics.phase];
+    node_data.best_supergate[ics.phase] = &gate;
+    node_data.phase[ics.phase] = gate.polarity ^ negation;
+    node_data.best_cut[ics.phase] = ics.cut_index;
+  }
+
+  /* full flow: delay mapping under the committed matches, mapping of the
+   * rest, netlist finalization and STA */
+  void materialize()
+  {
+    bool suc = !compute_mapping<false>();
+    if ( suc )
+    {
+      std::cerr<<"delay mapping flow failed\n";
+    }
+    for (auto const& ics : commits)
+      commit_match(ics);
 
     // finalize the netlist with lib with only AND, NAND, INV gates
     compute_rest_mapping<false>();
@@ -937,7 +1082,7 @@ public:
       {
         std::cout<<"netlist repaired\n";
       }
-    }   
+    }
 
     // get timing evaluation by STA;
     auto [res, old2new] = initialize_map_network();
@@ -946,18 +1091,84 @@ public:
     auto [delay, area] = compute_reward(res);
     _reward = delay;
     _mulReward = delay * area;
+    eventual_res = res;
 
-    std::cout << "area_queue size = "<<area_queue.size()<<"\n";
-    std::cout << "delay_queue size = "<<delay_queue.size()<<"\n";
-    std::cout << "wirelength_queue = "<<wirelength_queue.size()<<"\n";
-    std::cout << "totalwirelength_queue size = "<<totalwirelength_queue.size()<<"\n";
+    /* restart incremental timing from the cover, scaled to the STA result */
+    build_timing();
+    delay_scale = timing.delay() > 0 ? delay / timing.delay() : 1.0;
+    area_scale = timing.area() > 0 ? area / timing.area() : 1.0;
+    timing_valid = true;
+    cover_stale = false;
+  }
 
-    eventual_res = res;
-    
-    if (ps.strategy == map_params::amd) return _mulReward;
-    return _reward;
+  void build_timing()
+  {
+    if (topo_rank.empty())
+    {
+      topo_rank.resize(ntk.size());
+      for (auto i = 0u; i < top_order.size(); ++i)
+        topo_rank[ntk.node_to_index(top_order[i])] = i;
+    }
+
+    timing.reset(2u * ntk.size());
+    for (auto const& n : top_order)
+      sync_timing_node(ntk.node_to_index(n));
+    ntk.foreach_po([&](auto const& f) {
+      timing.add_output(2u * ntk.node_to_index(ntk.get_node(f)) +
+                        (ntk.is_complemented(f) ? 1u : 0u));
+    });
+    timing.update();
+  }
+
+  /* drivers of both phases of a node, from its current match; a phase
+   * without a gate is implemented by an inverter on the other phase */
+  void sync_timing_node(uint32_t index)
+  {
+    auto const& node_data = node_match[index];
+    auto const n = ntk.index_to_node(index);
+    auto const rank = 2u * topo_rank[index];
+
+    if (ntk.is_ci(n))
+    {
+      timing.set_driver(2u * index, rank, 0.0, {});
+      timing.set_driver(2u * index + 1u, rank + 1u, lib_inv_area,
+                        {timing_arc{2u * index, lib_inv_delay}});
+      return;
+    }
+
+    for (uint8_t phase = 0; phase < 2; ++phase)
+    {
+      auto const* gate = node_data.best_supergate[phase];
+      if (gate == nullptr) continue;
+
+      std::vector<timing_arc> fanins;
+      if (!ntk.is_constant(n))
+      {
+        auto const& cut = cuts.cuts(index)[node_data.best_cut[phase]];
+        auto ctr = 0u;
+        for (auto l : cut)
+        {
+          fanins.push_back({2u * l + ((node_data.phase[phase] >> ctr) & 1u),
+                            gate->tdelay[ctr]});
+          ++ctr;
+        }
+      }
+      timing.set_driver(2u * index + phase, rank, gate->area, std::move(fanins));
+    }
+
+    for (uint8_t phase = 0; phase < 2; ++phase)
+    {
+      if (node_data.best_supergate[phase] != nullptr) continue;
+
+      if (node_data.best_supergate[phase ^ 1] != nullptr)
+        timing.set_driver(2u * index + phase, rank + 1u, lib_inv_area,
+                          {timing_arc{2u * index + (phase ^ 1u), lib_inv_delay}});
+      else
+        timing.set_driver(2u * index + phase, rank, 0.0, {});
+    }
   }
 
+public:
   /* repair the mapped netlist */
   bool repair()
   {
@@ -966,10 +1177,11 @@ public:
     return true;
   }
 
-  // extract top x elements from a queue (actually it is a "set" type)
-  template <typename SetType>
-  void get_top_percent(SetType& queue, double const& per,
-                       std::vector<typename SetType::value_type>& topElements) {
+  // extract top x elements from a queue, matches of already set node phases
+  // are dropped as they are popped
+  template <typename QueueType>
+  void get_top_percent(QueueType& queue, double const& per,
+                       std::vector<index_cut_supergate>& topElements) {
     std::cout<<"queue size = "<<queue_size<<"\t";
     size_t topCount = static_cast<size_t>(queue_size * per);  // number of elements should be taken
     if (topCount > queue.size() ) {
@@ -978,15 +1190,9 @@ public:
     std::cout<<"top count = "<<topCount<<"\n";
 
     topElements.reserve(topCount);
-
-    // copy top elements
-    auto it = std::next(
-        queue.begin(),
-        static_cast<typename SetType::difference_type>(queue.size() - topCount));
-    std::copy(it, queue.end(), std::back_inserter(topElements));
-
-    // these code should be revised to be more flexible
-    queue.erase(it, queue.end());
+    queue.pop_top(topCount, [&](index_cut_supergate const& ics) {
+      return !node_match[ics.index].set_flag[ics.phase];
+    }, topElements);
   }
 
   template <bool DO_AREA>
@@ -1202,14 +1408,66 @@ public:
     return netlist_position;
   }
 
+  /* placement of the cells of res by node index, followed by the output
+   * pins: gates sit at the centroid of their cut, inverters and buffers
+   * next to their fanin */
+  std::vector<node_position> netlist_positions(map_ntk_t const& res)
+  {
+    std::vector<node_position> positions(res.size() + res.num_pos());
+    res.foreach_node([&](auto const& n) {
+      auto const index = res.node_to_index(n);
+      if (res.is_constant(n)) return;
+
+      auto const it = res2ntk.find(res.make_signal(n));
+      if (res.is_pi(n))
+      {
+        if (it != res2ntk.end())
+          positions[index] = np[it->second.node_index];
+        return;
+      }
+      if (it == res2ntk.end() || !res.has_binding(n) ||
+          res.get_binding_index(n) == lib_inv_id || res.get_binding_index(n) == lib_buf_id)
+      {
+        res.foreach_fanin(n, [&](auto const& f) {
+          positions[index] = positions[res.node_to_index(res.get_node(f))];
+          return false;
+        });
+        return;
+      }
+      auto const& ipp = it->second;
+      auto const& node_data = node_match[ipp.node_index];
+      positions[index] = compute_gate_position(cuts.cuts(ipp.node_index)[node_data.best_cut[ipp.node_phase]]);
+    });
+    res.foreach_po([&](auto const&, auto i) {
+      if (ntk.size() + i < np.size())
+        positions[res.size() + i] = np[ntk.size() + i];
+    });
+    return positions;
+  }
+
   std::pair<double, double> compute_reward(map_ntk_t const& res) 
   {
-    std::string filename = ps.result_dir + "/" + "temp.v";
-    write_verilog_with_binding(res, filename);
-    auto netlist_position = get_mappedNtk_position(res);
-    // double reward_delay, reward_area;
-    // phyLS::stime_of_res(lib_file, filename, netlist_position, reward_delay, reward_area);
-    auto [reward_delay, reward_area] = phyLS::stime(lib_file, filename);
+    double reward_delay, reward_area;
+    if (search_ps.native_sta)
+    {
+      /* no ABC state involved, parallel searches time concurrently */
+      auto const positions = netlist_positions(res);
+      phyLS::static_timing<map_ntk_t> sta(res, positions, sta_ps);
+      sta.run();
+      reward_delay = sta.delay();
+      reward_area = sta.area();
+    }
+    else
+    {
+      std::lock_guard<std::mutex> lock(phyLS::abc_frame_mutex());
+      if (!phyLS::stime_of_network(lib_file, res, reward_delay, reward_area))
+      {
+        /* gates unknown to ABC, time the netlist through a Verilog file */
+        std::string filename = ps.result_dir + "/" + worker_tag + "temp.v";
+        write_verilog_with_binding(res, filename);
+        std::tie(reward_delay, reward_area) = phyLS::stime(lib_file, filename);
+      }
+    }
     std::stringstream state;
     state << fmt::format("Delay reward = {:>12.2f}  Area reward = {:>12.2f}\n", reward_delay, reward_area);
     std::cout<<state.str();
@@ -1222,27 +1480,83 @@ public:
   void record_bestResult()
   {
     if (ps.strategy == map_params::d_only){
+      finalize();
       auto const& file_path = ps.best_result_file;
       std::cout<<"recording best reward result at "<<file_path<<"\n";
-      write_verilog_with_binding(eventual_res, file_path);
+      write_result(file_path, false);
     }   
   }
 
   void record_result(std::string filename)
   {
+    /* estimated states have no netlist, only exactly timed ones are kept */
+    if (cover_stale || ps.result_dir.empty()) return;
+    if (search_ps.record_every > 1 && ++record_steps % search_ps.record_every != 0) return;
+    if (search_ps.record_improvements)
+    {
+      if (_reward >= best_recorded) return;
+      best_recorded = _reward;
+    }
     std::cout<<"recording "<<filename<<"\n";
-    auto file_path = ps.result_dir + "/" + filename + ".v";
-    write_verilog_with_binding(eventual_res, file_path);
+    auto file_path = ps.result_dir + "/" + worker_tag + filename + ".v";
+    write_result(file_path, true);
   }
 
   void record_mulResult()
   {
     if (ps.strategy == map_params::amd){
+      finalize();
       auto const& file_path = ps.best_mulResult_file;
       std::cout<<"recording best reward result at "<<file_path<<"\n";
-      write_verilog_with_binding(eventual_res, file_path);
+      write_result(file_path, false);
     }
   }
+
+  void set_search_params(MCTS_params const& mcts_ps)
+  {
+    search_ps = mcts_ps;
+    phyLS::parse_wire_model(mcts_ps.wire_model, sta_ps.wires);
+    sta_ps.resistance = mcts_ps.wire_resistance;
+    sta_ps.capacitance = mcts_ps.wire_capacitance;
+  }
+
+  /* writes results through a writer shared with other searches instead of
+   * an own one, so that files written by several searches, such as the
+   * best result files, are written by one thread in the order recorded */
+  void set_writer(phyLS::async_writer* shared_writer)
+  {
+    external_writer = shared_writer;
+  }
+
+  /* delay and area of the baseline netlist, computed once by the caller
+   * for all parallel searches instead of by each one in initialize() */
+  void set_baseline(std::pair<double, double> const& delay_area)
+  {
+    baseline = delay_area;
+  }
+
+  /* waits for the pending result files */
+  void flush_results()
+  {
+    if (external_writer) external_writer->flush();
+    if (writer) writer->flush();
+  }
+
+private:
+  /* the netlist is printed on the writer thread, eventual_res is replaced
+   * by a new network on every materialization, so the copied handle stays
+   * unchanged; intermediate results may be dropped when the writer lags */
+  void write_result(std::string const& file_path, bool droppable)
+  {
+    if (!external_writer && !writer)
+      writer = std::make_unique<phyLS::async_writer>(search_ps.writer_capacity, search_ps.compress_results);
+    auto& target = external_writer ? *external_writer : *writer;
+    target.write(file_path, [res = eventual_res](std::ostream& os) {
+      write_verilog_with_binding(res, os);
+    }, droppable);
+  }
+
+public:
 #pragma endregion
 
   template <bool DO_AREA>
@@ -3168,7 +3482,7 @@ public:
   double wirelength{0.0f};       /* current wirelength of the mapping */
   double total_wirelength{0.0f}; /* current total wirelength of the mapping */
   const float epsilon{0.005f};   /* epsilon */
-  size_t queue_size{0};             /* size of multiset */
+  size_t queue_size{0};             /* number of matches in a queue */
   uint32_t set_nodes{0};         /* current amount of set nodes */
 
   /* lib inverter info */
@@ -3197,18 +3511,56 @@ public:
   map_ntk_t eventual_res;
   bool _terminal { false };
 
+  /* state saved per MCTS tree node */
+  struct mapper_snapshot
+  {
+    std::vector<std::shared_ptr<const std::vector<node_match_tech<NInputs>>>> pages;
+    shared_sorted_queue<index_cut_supergate, index_cut_supergate::CompareArea> area_queue;
+    shared_sorted_queue<index_cut_supergate, index_cut_supergate::CompareDelay> delay_queue;
+    shared_sorted_queue<index_cut_supergate, index_cut_supergate::CompareWirelength> wirelength_queue;
+    shared_sorted_queue<index_cut_supergate, index_cut_supergate::CompareTotalWirelength> totalwirelength_queue;
+    std::vector<index_cut_supergate> commits;
+    map_ntk_t eventual_res;
+    double reward{0};
+    double mulReward{0};
+    double delay_scale{1.0};
+    double area_scale{1.0};
+    uint32_t set_nodes{0};
+    bool terminal{false};
+    bool timing_valid{false};
+    bool cover_stale{false};
+  };
+  static constexpr size_t snapshot_page_size = 1024u;
+  std::shared_ptr<const mapper_snapshot> snapshot_base;
+
+  /* incremental timing of the cover between two exact STA runs */
+  incremental_timing timing;
+  std::vector<uint32_t> topo_rank;
+  std::vector<index_cut_supergate> commits; /* matches set since reinit */
+  bool timing_valid{false};
+  bool cover_stale{false};
+  double delay_scale{1.0};
+  double area_scale{1.0};
+
   /* file for saving result */
+  std::string worker_tag; /* prefix of the files of a parallel search */
+  MCTS_params search_ps;  /* recording policy and timing engine */
+  phyLS::sta_params sta_ps; /* wires of the built-in STA */
+  uint32_t record_steps{0};
+  double best_recorded{std::numeric_limits<double>::max()};
+  std::unique_ptr<phyLS::async_writer> writer;
+  phyLS::async_writer* external_writer{nullptr}; /* shared by parallel searches */
+  std::optional<std::pair<double, double>> baseline; /* delay and area of ps.baseline_v */
   std::string best_result_file;
   std::string best_mylResult_file;
   std::string result_file = "";
 
   // statistic queue
   std::vector<index_cut_supergate> vec_ics;
-  std::multiset<index_cut_supergate, index_cut_supergate::CompareArea> area_queue;
-  std::multiset<index_cut_supergate, index_cut_supergate::CompareDelay> delay_queue;
-  std::multiset<index_cut_supergate, index_cut_supergate::CompareWirelength> wirelength_queue;
-  std::multiset<index_cut_supergate,
-                index_cut_supergate::CompareTotalWirelength>
+  shared_sorted_queue<index_cut_supergate, index_cut_supergate::CompareArea> area_queue;
+  shared_sorted_queue<index_cut_supergate, index_cut_supergate::CompareDelay> delay_queue;
+  shared_sorted_queue<index_cut_supergate, index_cut_supergate::CompareWirelength> wirelength_queue;
+  shared_sorted_queue<index_cut_supergate, index_cut_supergate::CompareTotalWirelength>
       totalwirelength_queue;
 };
 
@@ -3263,6 +3615,27 @@ public:
  */
 using namespace MCTS;
 
+namespace detail {
+template <typename Search>
+void load_search_statistics(Search& search, MCTS_params const& mcts_ps) {
+  if (mcts_ps.load_statistics.empty()) return;
+  if (search.load(mcts_ps.load_statistics))
+    std::cout << "warm-started the search with " << search.num_states()
+              << " states from " << mcts_ps.load_statistics << "\n";
+  else
+    std::cerr << "[w] cannot load search statistics from "
+              << mcts_ps.load_statistics << ", starting from scratch\n";
+}
+
+template <typename Search>
+void save_search_statistics(Search const& search, MCTS_params const& mcts_ps) {
+  if (mcts_ps.save_statistics.empty()) return;
+  if (!search.save(mcts_ps.save_statistics))
+    std::cerr << "[w] cannot save search statistics to "
+              << mcts_ps.save_statistics << "\n";
+}
+}  // namespace detail
+
 template <class Ntk, unsigned CutSize = 5u,
           typename CutData = cut_enumeration_tech_map_cut, unsigned NInputs,
           classification_type Configuration>
@@ -3271,7 +3644,7 @@ void map_mcts(
     tech_library<NInputs, Configuration> const& library,
     tech_library<NInputs, Configuration> const& cri_lib,
     std::vector<node_position> const& np, map_params const& ps = {},
-    map_stats* pst = nullptr) {
+    map_stats* pst = nullptr, MCTS_params const& mcts_ps = {}) {
   static_assert(is_network_type_v<Ntk>, "Ntk is not a network type");
   static_assert(has_size_v<Ntk>, "Ntk does not implement the size method");
   static_assert(has_is_ci_v<Ntk>, "Ntk does not implement the is_ci method");
@@ -3292,18 +3665,80 @@ void map_mcts(
   static_assert(has_fanout_size_v<Ntk>,
                 "Ntk does not implement the fanout_size method");
 
+  using impl_t = detail::tech_incre_map_impl<Ntk, CutSize, CutData, NInputs, Configuration>;
+
   map_stats st;
-  std::cout<<"tech_incre_map_impl<Ntk, CutSize, CutData, NInputs, Configuration>\n";
-  detail::tech_incre_map_impl<Ntk, CutSize, CutData, NInputs, Configuration> p(
-      ntk, lib_file, library, cri_lib, np, ps, st);
-  // auto res = p.run();
+  auto const num_workers = phyLS::resolve_num_threads(mcts_ps.num_threads);
+  if (num_workers <= 1u)
+  {
+    std::cout<<"tech_incre_map_impl<Ntk, CutSize, CutData, NInputs, Configuration>\n";
+    impl_t p(ntk, lib_file, library, cri_lib, np, ps, st);
+    p.set_search_params(mcts_ps);
+    // auto res = p.run();
 
-  MCTS_params mcts_param;
-  MCTS_impl mct(p, mcts_param);
-  mct.run();
-  auto impl_prt = mct.get();
+    MCTS_impl mct(p, mcts_ps);
+    detail::load_search_statistics(mct, mcts_ps);
+    mct.run();
+    auto impl_prt = mct.get();
+    impl_prt->finalize();
+    detail::save_search_statistics(mct, mcts_ps);
 
-  std::cout<<"the result's binding networks size = "<<impl_prt->eventual_res.size()<<"\n";
+    std::cout<<"the result's binding networks size = "<<impl_prt->eventual_res.size()<<"\n";
+  }
+  else
+  {
+    /* root parallelism: independent searches, each with its own mapper, whose
+     * root statistics are merged at the end */
+    std::cout<<"running "<<num_workers<<" parallel searches\n";
+    /* one writer thread for all searches: the best result files are shared,
+     * so their writes must not run concurrently or out of order; it is
+     * declared first to outlive the workers */
+    phyLS::async_writer writer(mcts_ps.writer_capacity, mcts_ps.compress_results);
+    std::vector<std::unique_ptr<impl_t>> workers(num_workers);
+    std::vector<std::unique_ptr<MCTS_impl<impl_t>>> searches(num_workers);
+    std::vector<map_stats> worker_st(num_workers);
+    std::vector<std::vector<ActionStatistic>> roots(num_workers);
+    SharedBest shared;
+    std::optional<std::pair<double, double>> baseline;
+    if (ps.baseline_v != "")
+    {
+      std::lock_guard<std::mutex> lock(phyLS::abc_frame_mutex());
+      baseline = phyLS::stime(lib_file, ps.baseline_v);
+    }
+
+    phyLS::parallel_for(num_workers, 0u, num_workers, [&](uint64_t i, uint32_t) {
+      workers[i] = std::make_unique<impl_t>(ntk, lib_file, library, cri_lib, np, ps, worker_st[i]);
+      workers[i]->worker_tag = "w" + std::to_string(i) + "_";
+      workers[i]->set_search_params(mcts_ps);
+      workers[i]->set_writer(&writer);
+      if (baseline) workers[i]->set_baseline(*baseline);
+      searches[i] = std::make_unique<MCTS_impl<impl_t>>(*workers[i], mcts_ps, &shared);
+      detail::load_search_statistics(*searches[i], mcts_ps);
+      searches[i]->run();
+      searches[i]->get()->finalize();
+      roots[i] = searches[i]->root_statistics();
+    }, 1u);
+
+    auto const merged = merge_root_statistics(roots);
+    for (size_t a = 0; a < merged.size(); a++)
+    {
+      std::cout << fmt::format("action {} : visited = {:>6}  Q = {:>10.4f}  best reward = {:>12.2f}\n",
+                               a, merged[a].visited, merged[a].Q, merged[a].reward);
+    }
+
+    auto const score = [&](impl_t& p) {
+      return ps.strategy == map_params::amd ? p.get_mulReward() : p.get_reward();
+    };
+    uint32_t best = 0u;
+    for (auto i = 1u; i < num_workers; i++)
+    {
+      if (score(*workers[i]) < score(*workers[best])) best = i;
+    }
+    st = worker_st[best];
+    detail::save_search_statistics(*searches[best], mcts_ps);
+    std::cout<<"best search is "<<best<<", the result's binding networks size = "
+             <<workers[best]->eventual_res.size()<<"\n";
+  }
 
   st.time_total = st.time_mapping + st.cut_enumeration_st.time_total;
   if (ps.verbose && !st.mapping_error) st.report();
@@ -4,9 +4,21 @@
 #include <mockturtle/algorithms/mapper.hpp>
 
 #include "../core/RUDY.hpp"
+#include "../core/sta.hpp"
 #include "../core/utils/data_structure.hpp"
+#include "../core/utils/parallel.hpp"
+#include "../core/utils/placement_index.hpp"
 
 namespace mockturtle {
+
+/* parameters of placement-aware mapping beyond map_params */
+struct phy_map_params {
+  uint32_t num_threads{1u}; /* 0 uses all cores */
+  phyLS::rudy_params rudy;  /* grid and capacities of the congestion map */
+  bool report_timing{false}; /* built-in STA of the mapped netlist */
+  phyLS::sta_params sta;     /* wires of the built-in STA */
+};
+
 namespace detail {
 template<class Ntk, unsigned CutSize, typename CutData, unsigned NInputs, classification_type Configuration>
 class phy_map_impl
@@ -66,12 +78,19 @@ public:
         matches(),
         switch_activity( ps.eswp_rounds ? switching_activity(ntk, ps.switching_activity_patterns) : std::vector<float>(0)),
         cuts(fast_cut_enumeration<Ntk, CutSize, true, CutData>( ntk, ps.cut_enumeration_ps, &st.cut_enumeration_st)),
-        _binding_roots(ntk.size())
+        _binding_roots(ntk.size()),
+        placement(np)
   {
     std::tie(lib_inv_area, lib_inv_delay, lib_inv_id) = library.get_inverter_info();
     std::tie(lib_buf_area, lib_buf_delay, lib_buf_id) = library.get_buffer_info();
   }
 
+  /* matches the gates of a level on several threads in the wirelength and
+   * congestion passes */
+  void set_num_threads(uint32_t threads) { num_threads = threads; }
+
+  void set_rudy_params(phyLS::rudy_params const& params) { rudy_ps = params; }
+
   map_ntk_t rudy_map_test() {
     auto [res, old2new] = initialize_map_network();
 
@@ -139,13 +158,50 @@ public:
 
     /* generate the output network */
     finalize_cover<map_ntk_t>(res, old2new);
+    res_position = netlist_positions(res, old2new);
 
     return res;
   }
 
+  /* times the netlist returned by rudy_map_test at the cell positions of
+   * the cover and prints slacks and the critical path */
+  void report_timing(map_ntk_t const& res, phyLS::sta_params const& sta_ps) const {
+    phyLS::static_timing<map_ntk_t> sta(res, res_position, sta_ps);
+    sta.run();
+    sta.report();
+  }
+
 protected:
+  /* positions of the cells of res by node index, followed by the output
+   * pins; cells not in old2new (inner gates of supergates, output buffers)
+   * sit at their first fanin */
+  std::vector<node_position> netlist_positions(map_ntk_t const& res, klut_map const& old2new) const {
+    std::vector<node_position> positions(res.size() + res.num_pos());
+    std::vector<bool> placed(res.size(), false);
+    for (auto const& [index, signals] : old2new) {
+      for (auto phase = 0u; phase < 2u; ++phase) {
+        auto const n = res.get_node(signals[phase]);
+        if (res.is_constant(n)) continue;
+        positions[res.node_to_index(n)] = node_match[index].position[phase];
+        placed[res.node_to_index(n)] = true;
+      }
+    }
+    res.foreach_gate([&](auto const& n) {
+      auto const index = res.node_to_index(n);
+      if (placed[index]) return;
+      res.foreach_fanin(n, [&](auto const& f) {
+        positions[index] = positions[res.node_to_index(res.get_node(f))];
+        return false;
+      });
+    });
+    res.foreach_po([&](auto const&, auto i) {
+      if (ntk.size() + i < np.size()) positions[res.size() + i] = np[ntk.size() + i];
+    });
+    return positions;
+  }
+
   void set_RUDY_map(std::vector<node_position>* placement_p, map_ntk_t* binding_network_p, uint32_t num_pis, uint32_t num_pos) {
-    rudy_map = std::make_unique<phyLS::RUDY<map_ntk_t>>(placement_p, binding_network_p, static_cast<int>(num_pis), static_cast<int>(num_pos));
+    rudy_map = std::make_unique<phyLS::RUDY<map_ntk_t>>(placement_p, binding_network_p, static_cast<int>(num_pis), static_cast<int>(num_pos), rudy_ps);
   }
 
   void calculateRUDY() {
@@ -296,6 +352,8 @@ protected:
       std::vector<cut_match_tech<NInputs>> node_matches;
 
       auto i = 0u;
+      if ( !np.empty() )
+        placement.begin_node( index );
       for ( auto& cut : cuts.cuts( index ) )
       {
         /* ignore unit cut */
@@ -352,6 +410,8 @@ protected:
           ( *cut )->data.ignore = true;
         }
         search_nodes_pins(index, cut);
+        if ( !np.empty() && !( *cut )->data.ignore )
+          placement.add_cut( *cut );
       }
 
       matches[index] = node_matches;
@@ -455,16 +515,15 @@ protected:
 
   std::pair<double, double> wireCongestCompute(
       node<Ntk> const& n, cut_t const& cut, node_position const& gate_position,
-      uint8_t best_phase) {
+      uint8_t best_phase, phyLS::RudyOverlay& overlay) {
     double wire_congest = 0.0f;
     double congest_flow = 0.0f;
     auto index = ntk.node_to_index(n);
 
-    const bool is_temporary = true;
     int ctr = 0;
     for (auto& c : cut) {
-      rudy_map->addRectRudy<is_temporary>(
-          gate_position.x_coordinate, gate_position.y_coordinate,
+      rudy_map->addRectRudy(
+          overlay, gate_position.x_coordinate, gate_position.y_coordinate,
           node_match[c].position[(best_phase >> ctr) & 1].x_coordinate,
           node_match[c].position[(best_phase >> ctr) & 1].y_coordinate);
       ++ctr;
@@ -473,7 +532,7 @@ protected:
     ctr = 0;
     for (auto& c : cut) {
       double congestion = rudy_map->hpwlCongestCompute(
-          gate_position.x_coordinate, gate_position.y_coordinate,
+          overlay, gate_position.x_coordinate, gate_position.y_coordinate,
           node_match[c].position[(best_phase >> ctr) & 1].x_coordinate,
           node_match[c].position[(best_phase >> ctr) & 1].y_coordinate);
       wire_congest += congestion;
@@ -483,8 +542,8 @@ protected:
     }
     ctr = 0;
     for (auto& c : cut) {
-      rudy_map->removeRectRudy<is_temporary>(
-          gate_position.x_coordinate, gate_position.y_coordinate,
+      rudy_map->removeRectRudy(
+          overlay, gate_position.x_coordinate, gate_position.y_coordinate,
           node_match[c].position[(best_phase >> ctr) & 1].x_coordinate,
           node_match[c].position[(best_phase >> ctr) & 1].y_coordinate);
       ++ctr;
@@ -493,7 +552,8 @@ protected:
     return {wire_congest, congest_flow};
   }
 
-  void match_wireCongest(node<Ntk> const& n, uint8_t phase) {
+  void match_wireCongest(node<Ntk> const& n, uint8_t phase,
+                         phyLS::RudyOverlay& overlay) {
     double best_arrival = std::numeric_limits<double>::max();
     double best_area_flow = std::numeric_limits<double>::max();
     float best_area = std::numeric_limits<float>::max();
@@ -511,13 +571,13 @@ protected:
     auto index = ntk.node_to_index(n);
 
     auto& node_data = node_match[index];
-    auto& cut_matches = matches[index];
+    auto& cut_matches = matches.at(index);
     supergate<NInputs> const* best_supergate = node_data.best_supergate[phase];
 
     // Remove RUDY induced by the binding root of this node
-    auto binding_roots = get_binding_roots(n);
+    auto const& binding_roots = get_binding_roots(n);
     for (auto& root : binding_roots) {
-      rudy_map->nodeRUDYRemove(index);
+      rudy_map->nodeRUDYRemove(overlay, static_cast<int>(root));
     }
 
     /* recompute best match info */
@@ -539,7 +599,7 @@ protected:
       }
 
       if (cut.size() != 1)
-        best_gate_position = compute_gate_position(cut);
+        best_gate_position = compute_gate_position(index, cut);
       else {
         std::cerr << "Error: This cut has only one leaf" << std::endl;
         best_gate_position = node_data.position[phase];
@@ -549,7 +609,8 @@ protected:
       best_total_wirelength =
           compute_match_total_wirelength(cut, best_gate_position, best_phase);
       best_congest_flow =
-          (wireCongestCompute(n, cut, best_gate_position, best_phase)).second;
+          (wireCongestCompute(n, cut, best_gate_position, best_phase, overlay))
+              .second;
     }
 
     for (auto const& cut : cuts.cuts(index)) {
@@ -572,7 +633,7 @@ protected:
 
       node_position gate_position;
       if ((*cut).size() != 1)
-        gate_position = compute_gate_position(*cut);
+        gate_position = compute_gate_position(index, *cut);
       else
         continue;
 
@@ -586,8 +647,8 @@ protected:
             compute_match_wirelength(*cut, gate_position, gate_polarity);
         double worst_total_wirelength =
             compute_match_total_wirelength(*cut, gate_position, gate_polarity);
-        auto [worst_wire_congest, worst_congest_flow] =
-            wireCongestCompute(n, *cut, gate_position, gate_polarity);
+        auto [worst_wire_congest, worst_congest_flow] = wireCongestCompute(
+            n, *cut, gate_position, gate_polarity, overlay);
 
         auto ctr = 0u;
         for (auto l : *cut) {
@@ -627,7 +688,7 @@ protected:
       ++cut_index;
     }
     // Restore RUDY induced by the binding root of this node
-    rudy_map->clearTempRUDY();
+    rudy_map->clearOverlay(overlay);
 
     node_data.wirelength[phase] = best_wirelength;
     node_data.total_wirelength[phase] = best_total_wirelength;
@@ -642,20 +703,77 @@ protected:
     node_data.congest_flow[phase] = best_congest_flow;
   }
 
-  bool compute_wireCongest() {
+  /* Calls fn(n, thread_id) for all gates. With several threads, the gates
+   * of a level are matched concurrently: a match only reads the data of its
+   * cut leaves, which lie on lower levels, so the result is the same as in
+   * topological order. */
+  template <typename Fn>
+  void foreach_gate_by_level(Fn&& fn) {
+    if (phyLS::resolve_num_threads(num_threads) <= 1u) {
+      for (auto const& n : top_order) {
+        if (ntk.is_constant(n) || ntk.is_ci(n)) continue;
+        fn(n, 0u);
+      }
+      return;
+    }
+
+    if (level_offsets.empty()) compute_level_order();
+    for (auto l = 0u; l + 1 < level_offsets.size(); ++l) {
+      phyLS::parallel_for(
+          num_threads, level_offsets[l], level_offsets[l + 1],
+          [&](uint64_t i, uint32_t thread_id) { fn(level_order[i], thread_id); },
+          16u);
+    }
+  }
+
+  /* groups the gates of top_order by level, keeping the relative order */
+  void compute_level_order() {
+    std::vector<uint32_t> levels(ntk.size(), 0u);
+    uint32_t max_level = 0u;
     for (auto const& n : top_order) {
       if (ntk.is_constant(n) || ntk.is_ci(n)) continue;
-      auto index = ntk.node_to_index(n);
-      auto& node_data = node_match[index];
+      uint32_t level = 0u;
+      ntk.foreach_fanin(n, [&](auto const& f) {
+        level = std::max(level, levels[ntk.node_to_index(ntk.get_node(f))]);
+      });
+      levels[ntk.node_to_index(n)] = level + 1u;
+      max_level = std::max(max_level, level + 1u);
+    }
+
+    level_offsets.assign(max_level + 1u, 0u);
+    for (auto const& n : top_order) {
+      if (ntk.is_constant(n) || ntk.is_ci(n)) continue;
+      ++level_offsets[levels[ntk.node_to_index(n)]];
+    }
+    for (auto l = 1u; l < level_offsets.size(); ++l) {
+      level_offsets[l] += level_offsets[l - 1];
+    }
+
+    level_order.resize(level_offsets.back());
+    std::vector<uint64_t> next(level_offsets.begin(), level_offsets.end() - 1);
+    for (auto const& n : top_order) {
+      if (ntk.is_constant(n) || ntk.is_ci(n)) continue;
+      level_order[next[levels[ntk.node_to_index(n)] - 1u]++] = n;
+    }
+  }
+
+  bool compute_wireCongest() {
+    /* the committed RUDY is read-only while matching, each thread keeps the
+     * temporary RUDY of its candidates in its own overlay */
+    rudy_map->buildIndex();
+    rudy_overlays.clear();
+    for (auto i = 0u; i < phyLS::resolve_num_threads(num_threads); ++i)
+      rudy_overlays.push_back(rudy_map->makeOverlay());
 
-      match_wireCongest(n, 0u);
+    foreach_gate_by_level([&](auto const& n, uint32_t thread_id) {
+      match_wireCongest(n, 0u, rudy_overlays[thread_id]);
 
       /* match negative wire&delay phase */
-      match_wireCongest(n, 1u);
+      match_wireCongest(n, 1u, rudy_overlays[thread_id]);
 
       /* try to drop one delay phase */
       match_wirelength_drop_phase<false, true>(n);
-    }
+    });
 
     bool success = set_mapping_refs_wirelength<false>();
 
@@ -674,10 +792,7 @@ protected:
 
   template <bool DO_TOTALWIRE, bool DO_TRADE>
   bool compute_mapping_wirelength() {
-    for (auto const& n : top_order) {
-      uint32_t idx = ntk.node_to_index(n);
-      if (ntk.is_constant(n) || ntk.is_ci(n)) continue;
-
+    foreach_gate_by_level([&](auto const& n, uint32_t) {
       /* match positive wire&delay phase */
       match_wirelength<DO_TOTALWIRE, DO_TRADE>(n, 0u);
 
@@ -686,7 +801,7 @@ protected:
 
       /* try to drop one delay phase */
       match_wirelength_drop_phase<DO_TOTALWIRE, DO_TRADE>(n);
-    }
+    });
 
     bool success = set_mapping_refs_wirelength<false>();
 
@@ -1329,18 +1444,11 @@ protected:
     }
   }
 
-  node_position compute_gate_position(cut_t const& cut) 
+  /* the gate is placed at the centroid of the pins of its cut */
+  node_position compute_gate_position(uint32_t index, cut_t const& cut) 
   {
-    node_position gate_position {0, 0};
-    int crt = 0;
-    for (auto& c : cut.pins) {
-      gate_position.x_coordinate += np[c].x_coordinate;
-      gate_position.y_coordinate += np[c].y_coordinate;
-      crt++;
-    }
-    gate_position.x_coordinate = gate_position.x_coordinate / crt;
-    gate_position.y_coordinate = gate_position.y_coordinate / crt;
-    return gate_position;
+    if (cut->data.ignore) return placement.compute(cut.pins).centroid;
+    return placement.cut(index, cut).centroid;
   }
 
   template <bool DO_TOTALWIRE, bool DO_TRADE>
@@ -1358,10 +1466,10 @@ protected:
     auto index = ntk.node_to_index(n);
 
     auto& node_data = node_match[index];
-    auto& cut_matches = matches[index];
+    auto& cut_matches = matches.at(index);
     supergate<NInputs> const* best_supergate = node_data.best_supergate[phase];
     auto const& cur_best_cut = cuts.cuts(index)[node_data.best_cut[phase]];
-    node_position best_gate_position = compute_gate_position(cur_best_cut);
+    node_position best_gate_position = compute_gate_position(index, cur_best_cut);
 
     /* recompute best match info */
     if (best_supergate != nullptr) {
@@ -1382,7 +1490,7 @@ protected:
       }
 
       if (cut.size() != 1) {
-        best_gate_position = compute_gate_position(cut);
+        best_gate_position = compute_gate_position(index, cut);
       } else {
         std::cerr << "Error: This cut has only one leaf" << std::endl;
         best_gate_position = np[index];
@@ -1412,7 +1520,7 @@ protected:
 
       node_position gate_position;
       if ((*cut).size() != 1) {
-        gate_position = compute_gate_position(*cut);
+        gate_position = compute_gate_position(index, *cut);
       } else {
         std::cerr << "Error: This cut has only one leaf" << std::endl;
         gate_position = np[index];
@@ -1512,7 +1620,7 @@ protected:
       }
 
       if (cut.size() != 1)
-        best_gate_position = compute_gate_position(cut);
+        best_gate_position = compute_gate_position(index, cut);
       else {
         std::cerr << "Error: This cut has only one leaf" << std::endl;
         best_gate_position = np[index];
@@ -1551,7 +1659,7 @@ protected:
 
       node_position gate_position;
       if ((*cut).size() != 1)
-        gate_position = compute_gate_position(*cut);
+        gate_position = compute_gate_position(index, *cut);
       else {
         std::cerr << "Error: This cut has only one leaf" << std::endl;
         gate_position = np[index];
@@ -2679,30 +2787,6 @@ protected:
     return worst_wl;
   }
 
-  double compute_wirelength(cut_t const& cut) {
-    node_position roots, leafs;
-    int count_l = 0, count_r = 0;
-    for (auto r : cut.pins) {
-      roots.x_coordinate += np[r].x_coordinate;
-      roots.y_coordinate += np[r].y_coordinate;
-      count_r++;
-    }
-    for (auto l : cut) {
-      leafs.x_coordinate += np[l].x_coordinate;
-      leafs.y_coordinate += np[l].y_coordinate;
-      count_l++;
-    }
-    roots.x_coordinate = roots.x_coordinate / count_r;
-    roots.y_coordinate = roots.y_coordinate / count_r;
-    leafs.x_coordinate = leafs.x_coordinate / count_l;
-    leafs.y_coordinate = leafs.y_coordinate / count_l;
-
-    /* wirelength_pin computation */
-    double distance = std::abs(roots.x_coordinate - leafs.x_coordinate) +
-                      std::abs(roots.y_coordinate - leafs.y_coordinate);
-    return distance;
-  }
-
   double weight_w_d(double wirelength_t, double total_wirelength_t,
                     double delay_t) {
     double wires = ((1 - ps.trade_off) * wirelength_t) +
@@ -2776,9 +2860,17 @@ protected:
   std::unordered_map<signal<klut_network>, index_phase_pair> res2ntk;
   std::vector<std::vector<signal<klut_network>>> _binding_roots;
   std::vector<node_position> match_position;
+  std::vector<node_position> res_position; /* cells of the final netlist */
+  placement_index placement; /* placement of np with cached cut geometry */
 
   // Map for congestion awareness
   std::unique_ptr<phyLS::RUDY<map_ntk_t>> rudy_map;
+  std::vector<phyLS::RudyOverlay> rudy_overlays; /* one per thread */
+  phyLS::rudy_params rudy_ps;
+
+  uint32_t num_threads{1u};            /* 0 uses all cores */
+  std::vector<node<Ntk>> level_order;  /* gates grouped by level */
+  std::vector<uint64_t> level_offsets; /* level bounds in level_order */
 };
 } // namespace detail
 
@@ -2788,7 +2880,7 @@ template <class Ntk, unsigned CutSize = 5u,
 binding_view<klut_network> phymap(
     Ntk const& ntk, tech_library<NInputs, Configuration> const& library,
     std::vector<node_position> const& np, map_params const& ps = {},
-    map_stats* pst = nullptr) {
+    map_stats* pst = nullptr, phy_map_params const& pps = {}) {
   static_assert(is_network_type_v<Ntk>, "Ntk is not a network type");
   static_assert(has_size_v<Ntk>, "Ntk does not implement the size method");
   static_assert(has_is_ci_v<Ntk>, "Ntk does not implement the is_ci method");
@@ -2811,7 +2903,10 @@ binding_view<klut_network> phymap(
 
   map_stats st;
   detail::phy_map_impl<Ntk, CutSize, CutData, NInputs, Configuration> p{ntk, library, np, ps, st};
+  p.set_num_threads(pps.num_threads);
+  p.set_rudy_params(pps.rudy);
   auto res = p.rudy_map_test();
+  if (pps.report_timing && !st.mapping_error) p.report_timing(res, pps.sta);
 
   st.time_total = st.time_mapping + st.cut_enumeration_st.time_total;
   if (ps.verbose && !st.mapping_error) st.report();
@@ -2,18 +2,23 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <mockturtle/algorithms/mapper.hpp>
+#include <mutex>
 #include <sstream>
+#include <sys/stat.h>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include "assert.h"
 #include "../core/MCTS.hpp"
-#include "assert.h"
+#include "../core/sta.hpp"
+#include "../core/utils/def_reader.hpp"
 #include "base/abc/abc.h"
 #include "base/main/mainFrame.c"
 #include "map/scl/scl.c"
@@ -23,312 +28,214 @@ using namespace pabc;
 
 namespace phyLS {
 
-void read_mcts_ps(std::string file_path, MCTS::MCTS_params &ps) {
+/* Reads MCTS parameters from a file of `key = value` lines, `#` starts a
+ * comment.  Keys are the fields of MCTS::MCTS_params, missing keys keep their
+ * current value.  Returns false if the file cannot be opened or a value is
+ * malformed, unknown keys are only reported. */
+inline bool read_mcts_ps(std::string const &file_path, MCTS::MCTS_params &ps) {
   std::ifstream ifs(file_path, std::ifstream::in);
-  assert(ifs.is_open());
+  if (!ifs.is_open()) {
+    std::cerr << "[e] cannot open MCTS parameter file " << file_path << "\n";
+    return false;
+  }
+
+  auto const trim = [](std::string const &str) {
+    auto const first = str.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return std::string();
+    auto const last = str.find_last_not_of(" \t\r");
+    return str.substr(first, last - first + 1);
+  };
+  auto const parse = [](std::string const &text, auto &value) {
+    std::istringstream iss(text);
+    std::decay_t<decltype(value)> parsed;
+    if (!(iss >> parsed) || !(iss >> std::ws).eof()) return false;
+    if constexpr (std::is_unsigned_v<std::decay_t<decltype(value)>>) {
+      if (text.find('-') != std::string::npos) return false;
+    }
+    value = parsed;
+    return true;
+  };
+
+  std::string line;
+  uint32_t line_number = 0u;
+  bool ok = true;
+  while (std::getline(ifs, line)) {
+    ++line_number;
+    line = trim(line.substr(0, line.find('#')));
+    if (line.empty()) continue;
+
+    auto const eq = line.find('=');
+    if (eq == std::string::npos) {
+      std::cerr << "[e] expected key = value at line " << line_number
+                << " of " << file_path << "\n";
+      ok = false;
+      continue;
+    }
+    auto const key = trim(line.substr(0, eq));
+    auto const value = trim(line.substr(eq + 1));
+
+    bool parsed = true;
+    if (key == "search_iteration") {
+      parsed = parse(value, ps.search_iteration);
+    } else if (key == "level_search") {
+      parsed = parse(value, ps.level_search);
+    } else if (key == "sequence_length") {
+      parsed = parse(value, ps.sequence_length);
+    } else if (key == "action_size") {
+      parsed = parse(value, ps.action_size) && ps.action_size >= 1u &&
+               ps.action_size <= 4u;
+    } else if (key == "PUCT") {
+      parsed = parse(value, ps.PUCT);
+    } else if (key == "lambda") {
+      parsed = parse(value, ps.lambda);
+    } else if (key == "num_threads") {
+      parsed = parse(value, ps.num_threads);
+    } else if (key == "max_snapshots") {
+      parsed = parse(value, ps.max_snapshots);
+    } else if (key == "time_budget") {
+      parsed = parse(value, ps.time_budget) && ps.time_budget >= 0.0;
+    } else if (key == "early_stop") {
+      parsed = parse(value, ps.early_stop);
+    } else if (key == "load_statistics") {
+      ps.load_statistics = value;
+    } else if (key == "save_statistics") {
+      ps.save_statistics = value;
+    } else if (key == "record_every") {
+      parsed = parse(value, ps.record_every);
+    } else if (key == "record_improvements") {
+      parsed = parse(value, ps.record_improvements);
+    } else if (key == "compress_results") {
+      parsed = parse(value, ps.compress_results);
+    } else if (key == "writer_capacity") {
+      parsed = parse(value, ps.writer_capacity);
+    } else if (key == "native_sta") {
+      parsed = parse(value, ps.native_sta);
+    } else if (key == "wire_model") {
+      wire_model model;
+      parsed = parse_wire_model(value, model);
+      if (parsed) ps.wire_model = value;
+    } else if (key == "wire_resistance") {
+      parsed = parse(value, ps.wire_resistance) && ps.wire_resistance >= 0.0;
+    } else if (key == "wire_capacitance") {
+      parsed = parse(value, ps.wire_capacitance) && ps.wire_capacitance >= 0.0;
+    } else {
+      std::cerr << "[w] unknown MCTS parameter " << key << " at line "
+                << line_number << " of " << file_path << "\n";
+    }
+    if (!parsed) {
+      std::cerr << "[e] invalid value " << value << " for " << key
+                << " at line " << line_number << " of " << file_path << "\n";
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+namespace detail {
+
+/* writes a DEF location to `np[index]`, counting indices outside `np` */
+inline void place_node(std::vector<mockturtle::node_position> &np,
+                       int64_t index, int32_t x, int32_t y,
+                       uint32_t &num_ignored) {
+  if (index < 0 || index >= static_cast<int64_t>(np.size())) {
+    ++num_ignored;
+    return;
+  }
+  np[index].x_coordinate = x;
+  np[index].y_coordinate = y;
 }
 
+inline void report_ignored(std::string const &file_path,
+                           uint32_t num_ignored) {
+  if (num_ignored)
+    std::cerr << "[w] " << num_ignored << " placements in " << file_path
+              << " do not match a node and are ignored\n";
+}
+
+}  // namespace detail
+
+/* Reads the placement of an AIG mapped by ABC (gates `g<i>`, positioned
+ * after the PIs) or of the subject graph itself (gates `and_<i>_`,
+ * positioned at their node index).  Inputs are placed at their PI index
+ * and outputs after all gates. */
 void read_def_file(std::string file_path,
                    std::vector<node_position> &Vec_position, int input_size = 0) {
-  std::ifstream ifs(file_path, std::ifstream::in);
-  assert(ifs.is_open());
-  std::string line;
+  def_reader def;
+  if (!def.read(file_path)) {
+    std::cerr << "[e] cannot open DEF file " << file_path << "\n";
+    return;
+  }
+
+  uint32_t num_ignored = 0u;
   int cell_size = 0;
   bool gift = false;
-  while (std::getline(ifs, line)) {
-    if (line.substr(0, 4) == "COMP") {
-      while (std::getline(ifs, line)) {
-        if (line.substr(0, 3) == "END") {
-          break;
-        } else {
-          std::string substr;
-          // std::cout<<line<<"\n";
-          std::string::size_type found_s = line.find_first_of("-");
-          if (found_s != std::string::npos) {
-            substr = line.substr(found_s);
-          } else {
-            continue;
-          }
-          if (substr[2] == 'g') {
-            int index;
-            std::string res;
-            std::string::size_type found_b = line.find_first_of("g");
-            std::string::size_type found_e = line.find_first_of("A");
-            while (found_b != found_e - 1) {
-              res += line[found_b + 1];
-              found_b++;
-            }
-            index = std::stoi(res);
-            cell_size++;
-
-            // read next line
-            while (line.find("PLACED") == std::string::npos)
-              std::getline(ifs, line);
-            // get position of AIG node
-            assert(line.find("PLACED") != std::string::npos);
-            std::string position;
-            std::string::size_type found_1 = line.find_first_of("(");
-            std::string::size_type found_2 = line.find_first_of(")");
-            while (found_1 != found_2 - 1) {
-              position += line[found_1 + 1];
-              found_1++;
-            }
-            std::regex pattern(R"((\d+)\s+(\d+))");
-            std::smatch match;
-            std::regex_search(position, match, pattern);
-            if (!match.empty()) {
-              // std::cout << match[1] << " " << match[2] << "\n";
-              Vec_position[index + input_size + 1].x_coordinate = std::stoi(match[1]);
-              Vec_position[index + input_size + 1].y_coordinate = std::stoi(match[2]);
-            }
-            else {
-              std::cerr << "Error at : " << line <<"\n";
-            }
-          }
-          else if (substr.substr(2, 3) == "and") {
-            // get index of AIG node
-            int index;
-            gift = true;
-            std::string res;
-            std::string::size_type found_b = line.find_first_of("_");
-            std::string::size_type found_e = line.find_last_of("_");
-            while (found_b != found_e - 1) {
-              res += line[found_b + 1];
-              found_b++;
-            }
-            index = std::stoi(res);
-            cell_size = index;
-            // read next line
-            std::getline(ifs, line);
-            // get position of AIG node
-            bool is_x = true;
-            std::string position = "";
-            for (char c : line) {
-              if (std::isdigit(c)) {
-                position += c;
-              } else if (!position.empty()) {
-                if (is_x) {
-                  Vec_position[index].x_coordinate = std::stoi(position);
-                  position.clear();
-                  is_x = false;
-                } else {
-                  Vec_position[index].y_coordinate = std::stoi(position);
-                  position.clear();
-                }
-              } else {
-                continue;
-              }
-            }
-          }
-          else {
-            continue;
-          }
-        }
-      }
-    } else if (line.substr(0, 4) == "PINS") {
-      while (std::getline(ifs, line)) {
-        if (line.substr(0, 3) == "END") {
-          break;
-        } else {
-          std::string::size_type fidx = line.find_first_not_of(" ");
-          if (line[fidx] != '-')
-          {
-            // std::cerr << "Error at : " << line <<"\n";
-            continue;
-          }
-          std::string et_line = line;
-          std::getline(ifs, line);
-          et_line += line;
-          // get input position
-          if (et_line.find("INPUT") != std::string::npos) 
-          {
-            std::regex pattern(R"((\d+))");
-            std::smatch match;
-            std::regex_search(et_line, match, pattern);
-            int index = 0;
-            if (!match.empty()) {
-              index = std::stoi(match[1]);
-            }
-            else {
-              std::cout<<"error\n";
-              continue;
-            }
-            
-            while (line.find("PLACED") == std::string::npos) 
-              std::getline(ifs, line);
-
-            std::string position = "";
-            std::string::size_type found_1 = line.find_first_of("(");
-            std::string::size_type found_2 = line.find_first_of(")");
-            while (found_1 != found_2 - 1) {
-              position += line[found_1 + 1];
-              found_1++;
-            }
-            std::regex pattern2(R"((\d+)\s+(\d+))");
-            std::smatch match2;
-            std::regex_search(position, match2, pattern2);
-            // std::cout<<"input\n";
-            Vec_position[index + 1].x_coordinate = std::stoi(match2[1]);
-            Vec_position[index + 1].y_coordinate = std::stoi(match2[2]);
-            continue;
-          }
-          else if (et_line.find("OUTPUT") != std::string::npos)
-          {
-            std::regex pattern(R"((\d+))");
-            std::smatch match;
-            std::regex_search(et_line, match, pattern);
-            int index = 0;
-            if (!match.empty()) {
-              index = std::stoi(match[1]);
-            }
-            else {
-              std::cout<<"error\n";
-              continue;
-            }
-            
-            while (line.find("PLACED") == std::string::npos) 
-              std::getline(ifs, line);
-            
-            std::string position = "";
-            std::string::size_type found_1 = line.find_first_of("(");
-            std::string::size_type found_2 = line.find_first_of(")");
-            while (found_1 != found_2 - 1) {
-              position += line[found_1 + 1];
-              found_1++;
-            }
-            std::regex pattern2(R"((\d+)\s+(\d+))");
-            std::smatch match2;
-            std::regex_search(position, match2, pattern2);
-            int sa;
-            if (gift) 
-            {
-              sa = index + cell_size + 1;
-            } else {
-              sa = index + cell_size + input_size + 1;
-            }
-            Vec_position[sa].x_coordinate = std::stoi(match2[1]);
-            Vec_position[sa].y_coordinate = std::stoi(match2[2]);
-            continue;
-          }
-        }
-      }
-    } else {
-      continue;
+  for (auto const &c : def.components()) {
+    if (!c.placed || c.name.empty()) continue;
+    if (c.name[0] == 'g') {
+      auto const index = def_name_index(c.name);
+      if (index < 0) continue;
+      ++cell_size;
+      detail::place_node(Vec_position, index + input_size + 1, c.x, c.y,
+                         num_ignored);
+    } else if (c.name.rfind("and", 0) == 0) {
+      auto const index = def_name_index(c.name, c.name.find('_'));
+      if (index < 0) continue;
+      gift = true;
+      cell_size = index;
+      detail::place_node(Vec_position, index, c.x, c.y, num_ignored);
+    }
+  }
+
+  for (auto const &p : def.pins()) {
+    auto const index = def_name_index(p.name);
+    if (!p.placed || index < 0) continue;
+    if (p.direction == def_direction::input) {
+      detail::place_node(Vec_position, index + 1, p.x, p.y, num_ignored);
+    } else if (p.direction == def_direction::output) {
+      auto const sa = gift ? index + cell_size + 1
+                           : index + cell_size + input_size + 1;
+      detail::place_node(Vec_position, sa, p.x, p.y, num_ignored);
     }
   }
+  detail::report_ignored(file_path, num_ignored);
 }
 
+/* Reads the placement written by OpenROAD for a netlist with gates `g<i>`,
+ * inputs `x<i>` and outputs `y<i>`. */
 void read_def_file_openroad(
     std::string file_path, std::vector<mockturtle::node_position> &Vec_position,
     int input_size) {
   std::cout << "reading def file from " << file_path << "\n";
-  std::ifstream ifs(file_path, std::ifstream::in);
-  assert(ifs.is_open());
-  std::string line;
+  def_reader def;
+  if (!def.read(file_path)) {
+    std::cerr << "[e] cannot open DEF file " << file_path << "\n";
+    return;
+  }
+
+  uint32_t num_ignored = 0u;
   int cell_size = 0;
-  while (std::getline(ifs, line)) {
-    if (line.substr(0, 10) == "COMPONENTS") {
-      while (std::getline(ifs, line)) {
-        if (line.substr(0, 3) == "END") {
-          break;
-        } else {
-          if (line.find("PLACED") != std::string::npos) {
-            // get index of AIG node
-            int index;
-            std::string res;
-            std::string::size_type found_b = line.find_first_of("g");
-            std::string::size_type found_e = line.find_first_of("A");
-            while (found_b != found_e - 1) {
-              res += line[found_b + 1];
-              found_b++;
-            }
-            index = std::stoi(res);
-            cell_size = index;
-            std::string position;
-            std::string::size_type found_1 = line.find_first_of("(");
-            std::string::size_type found_2 = line.find_first_of(")");
-            while (found_1 != found_2 - 1) {
-              position += line[found_1 + 1];
-              found_1++;
-            }
-            std::regex pattern(R"((\d+)\s+(\d+))");
-            std::smatch match;
-            std::regex_search(position, match, pattern);
-            Vec_position[index + input_size + 1].x_coordinate =
-                std::stoi(match[1]);
-            Vec_position[index + input_size + 1].y_coordinate =
-                std::stoi(match[2]);
-          } else {
-            continue;
-          }
-        }
-      }
-    } else if (line.substr(0, 4) == "PINS") {
-      while (std::getline(ifs, line)) {
-        if (line.substr(0, 3) == "END") {
-          break;
-        } else {
-          if (line.find("INPUT") != std::string::npos) {
-            int index;
-            std::string res;
-            std::string::size_type found_b = line.find_first_of("x");
-            std::string::size_type found_e = line.find_first_of("+");
-            while (found_b != found_e - 1) {
-              res += line[found_b + 1];
-              found_b++;
-            }
-            index = std::stoi(res);
-            std::getline(ifs, line);
-            std::getline(ifs, line);
-            std::getline(ifs, line);
-            std::string position;
-            std::string::size_type found_1 = line.find_first_of("(");
-            std::string::size_type found_2 = line.find_first_of(")");
-            while (found_1 != found_2 - 1) {
-              position += line[found_1 + 1];
-              found_1++;
-            }
-            std::regex pattern(R"((\d+)\s+(\d+))");
-            std::smatch match;
-            std::regex_search(position, match, pattern);
-            Vec_position[index + 1].x_coordinate = std::stoi(match[1]);
-            Vec_position[index + 1].y_coordinate = std::stoi(match[2]);
-          } else if (line.find("OUTPUT") != std::string::npos) {
-            int index;
-            std::string res;
-            std::string::size_type found_b = line.find_first_of("y");
-            std::string::size_type found_e = line.find_first_of("+");
-            while (found_b != found_e - 1) {
-              res += line[found_b + 1];
-              found_b++;
-            }
-            index = std::stoi(res);
-            std::getline(ifs, line);
-            std::getline(ifs, line);
-            std::getline(ifs, line);
-            std::string position;
-            std::string::size_type found_1 = line.find_first_of("(");
-            std::string::size_type found_2 = line.find_first_of(")");
-            while (found_1 != found_2 - 1) {
-              position += line[found_1 + 1];
-              found_1++;
-            }
-            std::regex pattern(R"((\d+)\s+(\d+))");
-            std::smatch match;
-            std::regex_search(position, match, pattern);
-            Vec_position[index + cell_size + input_size + 2].x_coordinate =
-                std::stoi(match[1]);
-            Vec_position[index + cell_size + input_size + 2].y_coordinate =
-                std::stoi(match[2]);
-          } else {
-            continue;
-          }
-        }
-      }
-    } else {
-      continue;
+  for (auto const &c : def.components()) {
+    auto const index = def_name_index(c.name, c.name.find('g'));
+    if (!c.placed || index < 0) continue;
+    cell_size = index;
+    detail::place_node(Vec_position, index + input_size + 1, c.x, c.y,
+                       num_ignored);
+  }
+
+  for (auto const &p : def.pins()) {
+    if (!p.placed) continue;
+    if (p.direction == def_direction::input) {
+      auto const index = def_name_index(p.name, p.name.find('x'));
+      if (index >= 0)
+        detail::place_node(Vec_position, index + 1, p.x, p.y, num_ignored);
+    } else if (p.direction == def_direction::output) {
+      auto const index = def_name_index(p.name, p.name.find('y'));
+      if (index >= 0)
+        detail::place_node(Vec_position, index + cell_size + input_size + 2,
+                           p.x, p.y, num_ignored);
     }
   }
+  detail::report_ignored(file_path, num_ignored);
 }
 
 // void read_def_file(std::string file_path,
@@ -467,141 +374,85 @@ void read_pl_file(std::string file_path,
   ifs.close();
 }
 
-void read_def_file_abc(std::string file_path, Vec_Int_t **VecNP) {
-  std::ifstream ifs(file_path, std::ifstream::in);
-  assert(ifs.is_open());
-  std::string line;
+/* Reads the placement of a netlist with gates `<prefix>_<i>_`, inputs
+ * `input_<i>_` and outputs `output_<i>_` into ABC position vectors, `VecNP`
+ * has `np_size` entries. */
+void read_def_file_abc(std::string file_path, Vec_Int_t **VecNP,
+                       int np_size = std::numeric_limits<int>::max()) {
+  def_reader def;
+  if (!def.read(file_path)) {
+    std::cerr << "[e] cannot open DEF file " << file_path << "\n";
+    return;
+  }
+
+  uint32_t num_ignored = 0u;
+  auto const push = [&](int64_t index, int32_t x, int32_t y) {
+    if (index < 0 || index >= np_size) {
+      ++num_ignored;
+      return;
+    }
+    pabc::Vec_IntPush(VecNP[index], x);
+    pabc::Vec_IntPush(VecNP[index], y);
+  };
+
   int cell_size = 0;
-  while (std::getline(ifs, line)) {
-    if (line.substr(0, 4) == "COMP") {
-      while (std::getline(ifs, line)) {
-        if (line.substr(0, 3) == "END") {
-          break;
-        } else {
-          // get index of AIG node
-          int index;
-          std::string res;
-          std::string::size_type found_b = line.find_first_of("_");
-          std::string::size_type found_e = line.find_last_of("_");
-          while (found_b != found_e - 1) {
-            res += line[found_b + 1];
-            found_b++;
-          }
-          index = std::stoi(res);
-          cell_size = index;
-          // read next line
-          std::getline(ifs, line);
-          // get position of AIG node
-          bool is_x = true;
-          std::string position = "";
-          for (char c : line) {
-            if (std::isdigit(c)) {
-              position += c;
-            } else if (!position.empty()) {
-              if (is_x) {
-                pabc::Vec_IntPush(VecNP[index - 1], std::stoi(position));
-                position.clear();
-                is_x = false;
-              } else {
-                pabc::Vec_IntPush(VecNP[index - 1], std::stoi(position));
-                position.clear();
-              }
-            } else {
-              continue;
-            }
-          }
-        }
-      }
-    } else if (line.substr(0, 4) == "PINS") {
-      while (std::getline(ifs, line)) {
-        if (line.substr(0, 3) == "END") {
-          break;
-        } else if (line.find("input") != std::string::npos &&
-                   line.find("clk") == std::string::npos) {
-          // get input position
-          std::string::size_type found_1 = line.find("_");
-          std::string::size_type found_2 = line.find("+");
-          int index;
-          std::string res;
-          while (found_1 != found_2 - 2) {
-            res += line[found_1 + 1];
-            found_1++;
-          }
-          index = std::stoi(res);
-          std::getline(ifs, line);
-          std::getline(ifs, line);
-          bool is_x = true;
-          std::string position_input = "";
-          for (char c : line) {
-            if (std::isdigit(c)) {
-              position_input += c;
-            } else if (!position_input.empty()) {
-              if (is_x) {
-                pabc::Vec_IntPush(VecNP[index], std::stoi(position_input));
-                position_input.clear();
-                is_x = false;
-              } else {
-                pabc::Vec_IntPush(VecNP[index], std::stoi(position_input));
-                position_input.clear();
-              }
-            } else {
-              continue;
-            }
-          }
-        } else if (line.find("output") != std::string::npos) {
-          // get input position
-          std::string::size_type found_1 = line.find("_");
-          std::string::size_type found_2 = line.find("+");
-          int index;
-          std::string res;
-          while (found_1 != found_2 - 2) {
-            res += line[found_1 + 1];
-            found_1++;
-          }
-          index = std::stoi(res);
-          std::getline(ifs, line);
-          std::getline(ifs, line);
-          bool is_x = true;
-          std::string position_output = "";
-          for (char c : line) {
-            if (std::isdigit(c)) {
-              position_output += c;
-            } else if (!position_output.empty()) {
-              if (is_x) {
-                pabc::Vec_IntPush(VecNP[index + cell_size],
-                                  std::stoi(position_output));
-                position_output.clear();
-                is_x = false;
-              } else {
-                pabc::Vec_IntPush(VecNP[index + cell_size],
-                                  std::stoi(position_output));
-                position_output.clear();
-              }
-            } else {
-              continue;
-            }
-          }
-        } else {
-          continue;
-        }
-      }
-    } else {
-      continue;
+  for (auto const &c : def.components()) {
+    auto const index = def_name_index(c.name, c.name.find('_'));
+    if (!c.placed || index < 0) continue;
+    cell_size = index;
+    push(index - 1, c.x, c.y);
+  }
+
+  for (auto const &p : def.pins()) {
+    auto const index = def_name_index(p.name, p.name.find('_'));
+    if (!p.placed || index < 0) continue;
+    if (p.name.find("input") != std::string_view::npos &&
+        p.name.find("clk") == std::string_view::npos) {
+      push(index, p.x, p.y);
+    } else if (p.name.find("output") != std::string_view::npos) {
+      push(index + cell_size, p.x, p.y);
     }
   }
+  detail::report_ignored(file_path, num_ignored);
 }
 
-void npTrans(std::vector<mockturtle::node_position> np, Vec_Int_t **VecNP) {
+void npTrans(std::vector<mockturtle::node_position> const &np,
+             Vec_Int_t **VecNP) {
   for (int i = 0; i < np.size(); i++) {
     pabc::Vec_IntPush(VecNP[i], np[i].x_coordinate);
     pabc::Vec_IntPush(VecNP[i], np[i].y_coordinate);
   }
 }
 
-std::pair<double, double> stime(std::string lib_file,
-                                std::string netlist_file) {
-  Abc_Ntk_t *pNtk;
+/* ABC keeps the library and the networks in a global frame, callers running
+ * STA from several threads hold this mutex around the calls. */
+inline std::mutex &abc_frame_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+/* Liberty library installed in the ABC frame.  The library is read once and
+ * reused as long as the frame still holds it and the file keeps its
+ * modification time and size, so repeated STA calls on the same file (e.g.,
+ * one per MCTS step) do not parse the Liberty file again. */
+inline SC_Lib *load_scl_library(std::string const &lib_file) {
+  static std::string loaded_file;
+  static std::pair<int64_t, int64_t> loaded_version{-1, -1};
+  static SC_Lib *loaded = nullptr;
+  static void *loaded_genlib = nullptr;
+
+  struct stat st;
+  auto const version = ::stat(lib_file.c_str(), &st) == 0
+                           ? std::pair<int64_t, int64_t>{static_cast<int64_t>(st.st_mtime),
+                                                         static_cast<int64_t>(st.st_size)}
+                           : std::pair<int64_t, int64_t>{-1, -1};
+
   pabc::Abc_Frame_t *pAbc = pabc::Abc_FrameGetGlobalFrame();
+  if (loaded != nullptr && loaded_file == lib_file &&
+      loaded_version == version && pAbc->pLibScl == loaded &&
+      Abc_FrameReadLibGen() == loaded_genlib)
+    return loaded;
+
   SC_DontUse dont_use = {0};
   SC_Lib *pLib =
       Scl_ReadLibraryFile(pAbc, (char *)(lib_file.c_str()), 1, 0, dont_use);
@@ -612,6 +463,18 @@ std::pair<double, double> stime(std::string lib_file,
     Mio_LibraryTransferCellIds();
   }
 
+  loaded = pLib;
+  loaded_genlib = Abc_FrameReadLibGen();
+  loaded_file = pLib ? lib_file : std::string();
+  loaded_version = version;
+  return pLib;
+}
+
+std::pair<double, double> stime(std::string lib_file,
+                                std::string netlist_file) {
+  Abc_Ntk_t *pNtk;
+  SC_Lib *pLib = load_scl_library(lib_file);
+
   if (Abc_FrameReadLibGen() == NULL) {
     Abc_Print(-1, "Cannot read mapped design when the library is not given.\n");
   }
@@ -634,16 +497,7 @@ std::pair<double, double> stime(std::string lib_file,
 std::pair<double, double> _stime(std::string lib_file, std::string netlist_file,
                                  std::string def_file) {
   Abc_Ntk_t *pNtk;
-  pabc::Abc_Frame_t *pAbc = pabc::Abc_FrameGetGlobalFrame();
-  SC_DontUse dont_use = {0};
-  SC_Lib *pLib =
-      Scl_ReadLibraryFile(pAbc, (char *)(lib_file.c_str()), 1, 0, dont_use);
-  ABC_FREE(dont_use.dont_use_list);
-  Abc_SclLoad(pLib, (SC_Lib **)&pAbc->pLibScl);
-  if (pAbc->pLibScl) {
-    Abc_SclInstallGenlib(pAbc->pLibScl, 0, 0, 0);
-    Mio_LibraryTransferCellIds();
-  }
+  SC_Lib *pLib = load_scl_library(lib_file);
 
   if (Abc_FrameReadLibGen() == NULL) {
     Abc_Print(-1, "Cannot read mapped design when the library is not given.\n");
@@ -696,7 +550,8 @@ std::pair<double, double> _stime(std::string lib_file, std::string netlist_file,
 }
 
 void stime_of_res(std::string lib_file, std::string netlist_file,
-                  std::vector<mockturtle::node_position> np, double &maxDelay,
+                  std::vector<mockturtle::node_position> const &np,
+                  double &maxDelay,
                   double &area) {
   /* compute baseline */
   // auto pair = _stime(lib_file,
@@ -706,16 +561,7 @@ void stime_of_res(std::string lib_file, std::string netlist_file,
   // "<<pair.second<<" Reward : "<<(pair.first * pair.second)<<"\n";
 
   Abc_Ntk_t *pNtk;
-  pabc::Abc_Frame_t *pAbc = pabc::Abc_FrameGetGlobalFrame();
-  SC_DontUse dont_use = {0};
-  SC_Lib *pLib =
-      Scl_ReadLibraryFile(pAbc, (char *)(lib_file.c_str()), 1, 0, dont_use);
-  ABC_FREE(dont_use.dont_use_list);
-  Abc_SclLoad(pLib, (SC_Lib **)&pAbc->pLibScl);
-  if (pAbc->pLibScl) {
-    Abc_SclInstallGenlib(pAbc->pLibScl, 0, 0, 0);
-    Mio_LibraryTransferCellIds();
-  }
+  SC_Lib *pLib = load_scl_library(lib_file);
 
   if (Abc_FrameReadLibGen() == NULL) {
     Abc_Print(-1, "Cannot read mapped design when the library is not given.\n");
@@ -791,187 +637,109 @@ void stime_of_res(std::string lib_file, std::string netlist_file,
 }
 
 
-void read_deffile(std::string file_path,
-                   std::vector<node_position> &Vec_position,
-                   int input_size = 0) {
-  std::ifstream ifs(file_path, std::ifstream::in);
-  assert(ifs.is_open());
-  std::string line;
-  int cell_size = 0;
-  bool gift = false;
-  while (std::getline(ifs, line)) {
-    if (line.substr(0, 4) == "COMP") {
-      while (std::getline(ifs, line)) {
-        if (line.substr(0, 3) == "END") {
-          break;
-        } else {
-          std::string substr;
-          // std::cout<<line<<"\n";
-          std::string::size_type found_s = line.find_first_of("-");
-          if (found_s != std::string::npos) {
-            substr = line.substr(found_s);
-          } else {
-            continue;
-          }
-          if (substr[2] == 'g') {
-            int index;
-            std::string res;
-            std::string::size_type found_b = line.find_first_of("g");
-            std::string::size_type found_e = line.find_first_of("A");
-            while (found_b != found_e - 1) {
-              res += line[found_b + 1];
-              found_b++;
-            }
-            index = std::stoi(res);
-            cell_size++;
-
-            // read next line
-            while (line.find("PLACED") == std::string::npos)
-              std::getline(ifs, line);
-            // get position of AIG node
-            assert(line.find("PLACED") != std::string::npos);
-            std::string position;
-            std::string::size_type found_1 = line.find_first_of("(");
-            std::string::size_type found_2 = line.find_first_of(")");
-            while (found_1 != found_2 - 1) {
-              position += line[found_1 + 1];
-              found_1++;
-            }
-            std::regex pattern(R"((\d+)\s+(\d+))");
-            std::smatch match;
-            std::regex_search(position, match, pattern);
-            if (!match.empty()) {
-              // std::cout << match[1] << " " << match[2] << "\n";
-              Vec_position[index + input_size + 1].x_coordinate =
-                  std::stoi(match[1]);
-              Vec_position[index + input_size + 1].y_coordinate =
-                  std::stoi(match[2]);
-            } else {
-              std::cerr << "Error at : " << line << "\n";
-            }
-          } else if (substr.substr(2, 3) == "and") {
-            // get index of AIG node
-            int index;
-            gift = true;
-            std::string res;
-            std::string::size_type found_b = line.find_first_of("_");
-            std::string::size_type found_e = line.find_last_of("_");
-            while (found_b != found_e - 1) {
-              res += line[found_b + 1];
-              found_b++;
-            }
-            index = std::stoi(res);
-            cell_size = index;
-            // read next line
-            std::getline(ifs, line);
-            // get position of AIG node
-            bool is_x = true;
-            std::string position = "";
-            for (char c : line) {
-              if (std::isdigit(c)) {
-                position += c;
-              } else if (!position.empty()) {
-                if (is_x) {
-                  Vec_position[index].x_coordinate = std::stoi(position);
-                  position.clear();
-                  is_x = false;
-                } else {
-                  Vec_position[index].y_coordinate = std::stoi(position);
-                  position.clear();
-                }
-              } else {
-                continue;
-              }
-            }
-          } else {
-            continue;
-          }
-        }
-      }
-    } else if (line.substr(0, 4) == "PINS") {
-      while (std::getline(ifs, line)) {
-        if (line.substr(0, 3) == "END") {
-          break;
-        } else {
-          std::string::size_type fidx = line.find_first_not_of(" ");
-          if (line[fidx] != '-') {
-            // std::cerr << "Error at : " << line <<"\n";
-            continue;
-          }
-          std::string et_line = line;
-          std::getline(ifs, line);
-          et_line += line;
-          // get input position
-          if (et_line.find("INPUT") != std::string::npos) {
-            std::regex pattern(R"((\d+))");
-            std::smatch match;
-            std::regex_search(et_line, match, pattern);
-            int index = 0;
-            if (!match.empty()) {
-              index = std::stoi(match[1]);
-            } else {
-              std::cout << "error\n";
-              continue;
-            }
-
-            while (line.find("PLACED") == std::string::npos)
-              std::getline(ifs, line);
-
-            std::string position = "";
-            std::string::size_type found_1 = line.find_first_of("(");
-            std::string::size_type found_2 = line.find_first_of(")");
-            while (found_1 != found_2 - 1) {
-              position += line[found_1 + 1];
-              found_1++;
-            }
-            std::regex pattern2(R"((\d+)\s+(\d+))");
-            std::smatch match2;
-            std::regex_search(position, match2, pattern2);
-            // std::cout<<"input\n";
-            Vec_position[index + 1].x_coordinate = std::stoi(match2[1]);
-            Vec_position[index + 1].y_coordinate = std::stoi(match2[2]);
-            continue;
-          } else if (et_line.find("OUTPUT") != std::string::npos) {
-            std::regex pattern(R"((\d+))");
-            std::smatch match;
-            std::regex_search(et_line, match, pattern);
-            int index = 0;
-            if (!match.empty()) {
-              index = std::stoi(match[1]);
-            } else {
-              std::cout << "error\n";
-              continue;
-            }
+/* STA of a mapped network without writing and re-reading Verilog.  The
+ * network is converted into an ABC mapped network, binding each gate to the
+ * genlib gate of the same name that ABC derived from `lib_file`, and timed
+ * like `stime`.  Returns false if a gate or pin has no counterpart in ABC, in
+ * which case the caller should fall back to `stime`. */
+bool stime_of_network(
+    std::string const &lib_file,
+    mockturtle::binding_view<mockturtle::klut_network> const &res,
+    double &maxDelay, double &area) {
+  SC_Lib *pLib = load_scl_library(lib_file);
+  auto *pGenlib = (Mio_Library_t *)Abc_FrameReadLibGen();
+  if (pLib == NULL || pGenlib == NULL) return false;
+
+  auto const &gates = res.get_library();
+
+  /* ABC gate of every used library gate and, for each ABC pin, the fanin of
+   * the mockturtle gate with the same name */
+  std::vector<Mio_Gate_t *> abc_gates(gates.size(), nullptr);
+  std::vector<std::vector<uint32_t>> pin_order(gates.size());
+  auto const match_gate = [&](uint32_t id) {
+    if (abc_gates[id] != nullptr) return true;
+    auto const &gate = gates[id];
+    Mio_Gate_t *pGate = Mio_LibraryReadGateByName(
+        pGenlib, (char *)gate.name.c_str(), NULL);
+    if (pGate == NULL) return false;
+    if (static_cast<size_t>(Mio_GateReadPinNum(pGate)) != gate.pins.size())
+      return false;
+    for (Mio_Pin_t *pPin = Mio_GateReadPins(pGate); pPin;
+         pPin = Mio_PinReadNext(pPin)) {
+      auto const it = std::find_if(
+          gate.pins.begin(), gate.pins.end(),
+          [&](auto const &pin) { return pin.name == Mio_PinReadName(pPin); });
+      if (it == gate.pins.end()) return false;
+      pin_order[id].push_back(
+          static_cast<uint32_t>(std::distance(gate.pins.begin(), it)));
+    }
+    abc_gates[id] = pGate;
+    return true;
+  };
+
+  Abc_Ntk_t *pNtk = Abc_NtkAlloc(ABC_NTK_LOGIC, ABC_FUNC_MAP, 1);
+  pNtk->pName = Extra_UtilStrsav((char *)"top");
+
+  std::vector<Abc_Obj_t *> objs(res.size(), nullptr);
+  auto const obj = [&](auto const &n) {
+    auto &o = objs[res.node_to_index(n)];
+    if (o == nullptr && res.is_constant(n))
+      o = res.constant_value(n) ? Abc_NtkCreateNodeConst1(pNtk)
+                                : Abc_NtkCreateNodeConst0(pNtk);
+    return o;
+  };
+
+  res.foreach_pi(
+      [&](auto const &n) { objs[res.node_to_index(n)] = Abc_NtkCreatePi(pNtk); });
+
+  bool success = true;
+  std::vector<Abc_Obj_t *> fanins;
+  res.foreach_gate([&](auto const &n) {
+    if (!res.has_binding(n) || !match_gate(res.get_binding_index(n))) {
+      success = false;
+      return false;
+    }
+    auto const id = res.get_binding_index(n);
+
+    fanins.clear();
+    res.foreach_fanin(n, [&](auto const &f) {
+      fanins.push_back(obj(res.get_node(f)));
+    });
+    if (fanins.size() != pin_order[id].size()) {
+      success = false;
+      return false;
+    }
 
-            while (line.find("PLACED") == std::string::npos)
-              std::getline(ifs, line);
+    Abc_Obj_t *pNode = Abc_NtkCreateNode(pNtk);
+    for (auto const i : pin_order[id]) Abc_ObjAddFanin(pNode, fanins[i]);
+    pNode->pData = abc_gates[id];
+    objs[res.node_to_index(n)] = pNode;
+    return true;
+  });
+
+  if (success) {
+    res.foreach_po([&](auto const &f) {
+      Abc_ObjAddFanin(Abc_NtkCreatePo(pNtk), obj(res.get_node(f)));
+    });
+    Abc_NtkAddDummyPiNames(pNtk);
+    Abc_NtkAddDummyPoNames(pNtk);
+    success = Abc_NtkCheck(pNtk);
+  }
 
-            std::string position = "";
-            std::string::size_type found_1 = line.find_first_of("(");
-            std::string::size_type found_2 = line.find_first_of(")");
-            while (found_1 != found_2 - 1) {
-              position += line[found_1 + 1];
-              found_1++;
-            }
-            std::regex pattern2(R"((\d+)\s+(\d+))");
-            std::smatch match2;
-            std::regex_search(position, match2, pattern2);
-            int sa;
-            if (gift) {
-              sa = index + cell_size + 1;
-            } else {
-              sa = index + cell_size + input_size + 1;
-            }
-            Vec_position[sa].x_coordinate = std::stoi(match2[1]);
-            Vec_position[sa].y_coordinate = std::stoi(match2[2]);
-            continue;
-          }
-        }
-      }
-    } else {
-      continue;
-    }
+  if (success) {
+    int fUseWireLoads = 1;
+    int fPrintPath = 0;
+    Abc_SclTimePerformdelay(pLib, pNtk, 0, fUseWireLoads, 0, fPrintPath, 0,
+                            maxDelay, area);
   }
+  Abc_NtkDelete(pNtk);
+  return success;
+}
+
+void read_deffile(std::string file_path,
+                   std::vector<node_position> &Vec_position,
+                   int input_size = 0) {
+  read_def_file(file_path, Vec_position, input_size);
 }
 
 }  // NAMESPACE phyLS
@@ -18,6 +18,8 @@
 #include <mockturtle/mockturtle.hpp>
 #include <string>
 #include <vector>
+
+#include "rm_spectrum.hpp"
 using namespace std;
 
 namespace mockturtle {
@@ -38,6 +40,9 @@ struct rm_rewriting_params {
 
   /*! \brief minimum multiplicative complexity in XAG. */
   bool multiplicative_complexity{false};
+
+  /*! \brief Maximum number of cut (or MFFC) inputs. */
+  uint32_t cut_size{6u};
 };
 
 namespace detail {
@@ -72,337 +77,21 @@ class rm_mixed_polarity_impl {
         [&](auto const& n) { ntk1.set_value(n, ntk1.fanout_size(n)); });
   }
   /**************************************************************************************************************/
-  /* Count the number of and gates. */
-  int count_node_num(vector<string>& minterm, int variate_num,
-                     string polarity) {
-    int count = 0;
-    if (variate_num > 1) {
-      for (int i = 0; i < minterm.size(); i++) {
-        int count1 = 0;
-        for (int j = 0; j < variate_num; j++) {
-          if (minterm[i][j] == '1' || polarity[j] == '2') count1++;
-        }
-        if (count1 > 0) count = count + count1 - 1;
-      }
-    }
-
-    return count;
-  }
-  /**************************************************************************************************************/
-  /* Convert ternary to decimal. */
-  int atoint(string s, int radix) {
-    int ans = 0;
-    for (int i = 0; i < s.size(); i++) {
-      char t = s[i];
-      if (t >= '0' && t <= '9')
-        ans = ans * radix + t - '0';
-      else
-        ans = ans * radix + t - 'a' + 10;
-    }
-    return ans;
-  }
-  /**************************************************************************************************************/
-  /* Convert decimal to ternary. */
-  string intToA(int n, int radix) {
-    string ans = "";
-    do {
-      int t = n % radix;
-      if (t >= 0 && t <= 9)
-        ans += t + '0';
-      else
-        ans += t - 10 + 'a';
-      n /= radix;
-    } while (n != 0);
-    reverse(ans.begin(), ans.end());
-    return ans;
-  }
-  /**************************************************************************************************************/
-  /* create signal by expression. */
-  signal_t create_ntk_from_str(std::string const& s,
-                               std::vector<node_t> const& leaves) {
+  /* create signal from the RM product terms. */
+  signal_t create_ntk_from_terms(std::vector<rm_term> const& terms,
+                                 std::vector<node_t> const& leaves) {
     std::vector<signal_t> pis;
-    pis.clear();
+    pis.reserve(leaves.size());
     for (const auto& l : leaves) {
       pis.push_back(ntk.make_signal(l));
     }
-
-    std::stack<signal_t> inputs;
-    int flag = 0;
-    int flag1 = 0;
-
-    for (auto i = 0; i < s.size(); i++) {
-      if (s[i] == '[') {
-        continue;
-      } else if (s[i] == '(') {
-        continue;
-      } else if (s[i] == '1') {
-        flag1 = 1;
-        continue;
-      } else if (s[i] >= 'a') {
-        if (flag == 1) {
-          inputs.push(ntk.create_not(pis[s[i] - 'a']));
-          flag = 0;
-        } else
-          inputs.push(pis[s[i] - 'a']);
-      } else if (s[i] == ')') {
-        auto x1 = inputs.top();
-        inputs.pop();
-
-        auto x2 = inputs.top();
-        inputs.pop();
-
-        inputs.push(ntk.create_and(x1, x2));
-      } else if (s[i] == ']') {
-        if (flag1 == 1) {
-          auto x1 = inputs.top();
-          inputs.pop();
-          inputs.push(ntk.create_not(x1));
-          flag1 = 0;
-        } else {
-          auto x1 = inputs.top();
-          inputs.pop();
-
-          auto x2 = inputs.top();
-          inputs.pop();
-          inputs.push(ntk.create_xor(x1, x2));
-        }
-      } else if (s[i] == '!') {
-        flag = 1;
-      }
-    }
-    return inputs.top();
-  }
-  /**************************************************************************************************************/
-  /* List all possible variable values/List truth table. */
-  vector<string> list_truth_table(int& variate_num) {
-    int a = pow(2, variate_num);
-    vector<int> b;
-    for (int i = 0; i < a; i++) {
-      b.push_back(i);
-    }
-    vector<string> binary;
-    for (int i = 0; i < a; i++) {
-      string binary1;
-      for (int j = variate_num - 1; j >= 0; j--) {
-        int d = ((b[i] >> j) & 1);
-        binary1 += d + 48;
-      }
-      binary.push_back(binary1);
-    }
-    return binary;
-  }
-  /**************************************************************************************************************/
-  /* List all possible polarity values. */
-  vector<string> list_all_polarities(int& variate_num) {
-    int a_1 = pow(2, variate_num);
-    vector<int> c;
-    for (int i = 0; i < a_1; i++) {
-      c.push_back(i);
-    }
-    vector<string> polarity1;
-    for (int i = 0; i < a_1; i++) {
-      string polarity2;
-      for (int j = variate_num - 1; j >= 0; j--) {
-        int d = ((c[i] >> j) & 1);
-        polarity2 += d + 48;
-      }
-      polarity1.push_back(polarity2);
-    }
-
-    /* Store all polarities. */
-    vector<string> polarity;
-    polarity.push_back(polarity1[0]);
-    int a2 = pow(3, variate_num);
-    string str1 = polarity1[0];
-    string str2 = polarity1[1];
-    for (int i = 0; i < a2 - 1; i++) {
-      int num1 = atoint(str1, 3);
-      int num2 = atoint(str2, 3);
-
-      int sum = num1 + num2;
-      string str3 = intToA(sum, 3);
-
-      str1 = "0";
-      if (str3.size() < variate_num) {
-        for (int i = 0; i < variate_num - str3.size() - 1; i++) str1 += '0';
-
-        str1 += str3;
-      } else
-        str1 = str3;
-
-      polarity.push_back(str1);
-    }
-    return polarity;
-  }
-  /**************************************************************************************************************/
-  /* Mixed polarity conversion algorithm based on list technique. */
-  vector<string> polarity_conversion(int& variate_num, vector<string>& minterm,
-                                     string& polarity) {
-    vector<string> RM_product = minterm;
-    string str;
-    for (int i = 0; i < variate_num; i++) {
-      for (int j = 0; j < RM_product.size(); j++) {
-        if (polarity[i] == '0') {
-          if (RM_product[j][i] == '0') {
-            str = RM_product[j];
-            str[i] = '1';
-            RM_product.push_back(str);
-          }
-        } else if (polarity[i] == '1') {
-          if (RM_product[j][i] == '1') {
-            str = RM_product[j];
-            str[i] = '0';
-            RM_product.push_back(str);
-          }
-        }
-      }
-      if (polarity[i] == '0') {
-        /* Delete the minimum number of even items. */
-        if (RM_product.size() > 0) {
-          sort(RM_product.begin(), RM_product.end());
-          for (int m = 0; m < RM_product.size() - 1; m++) {
-            if (RM_product[m] == RM_product[m + 1]) {
-              RM_product[m] = "0";
-              RM_product[m + 1] = "0";
-            }
-          }
-        }
-        /* Delete item with '0' in array. */
-        vector<string> final_term;
-        final_term.clear();
-        for (int m = 0; m < RM_product.size(); m++) {
-          if (RM_product[m] != "0") final_term.push_back(RM_product[m]);
-        }
-        RM_product.clear();
-        RM_product = final_term;
-      } else if (polarity[i] == '1') {
-        /* Delete the minimum number of even items. */
-        if (RM_product.size() > 0) {
-          sort(RM_product.begin(), RM_product.end());
-          for (int m = 0; m < RM_product.size() - 1; m++) {
-            if (RM_product[m] == RM_product[m + 1]) {
-              RM_product[m] = "0";
-              RM_product[m + 1] = "0";
-            }
-          }
-        }
-        /* Delete item with '0' in array. */
-        vector<string> final_term;
-        final_term.clear();
-        for (int m = 0; m < RM_product.size(); m++) {
-          if (RM_product[m] != "0") {
-            if (RM_product[m][i] == '0')
-              RM_product[m][i] = '1';
-            else if (RM_product[m][i] == '1')
-              RM_product[m][i] = '0';
-            final_term.push_back(RM_product[m]);
-          }
-        }
-        RM_product.clear();
-        RM_product = final_term;
-      }
-    }
-    return RM_product;
-  }
-  /**************************************************************************************************************/
-  /* Search for the optimal polarity and the corresponding product term. */
-  void search_for_optimal_polarity(vector<string>& minterm,
-                                   vector<string>& polarity, int& variate_num,
-                                   vector<string>& RM_product,
-                                   string& optimal_polarity) {
-    vector<string> RM_product_initial;
-    for (int l = 0; l < polarity.size(); l++) {
-      RM_product_initial =
-          polarity_conversion(variate_num, minterm, polarity[l]);
-
-      int count1, count2;
-      count1 = count_the_number_of_nodes(variate_num, RM_product_initial,
-                                         polarity[l]);
-      count2 =
-          count_the_number_of_nodes(variate_num, RM_product, optimal_polarity);
-      if (count1 < count2) {
-        optimal_polarity = polarity[l];
-        RM_product.clear();
-        RM_product = RM_product_initial;
-        RM_product_initial.clear();
-      } else {
-        RM_product_initial.clear();
-      }
-    }
-  }
-  /**************************************************************************************************************/
-  /* Count the number of nodes in the new network. */
-  int count_the_number_of_nodes(int& variate_num, vector<string>& RM_product,
-                                string& optimal_polarity) {
-    /* Count the number of nodes. */
-    int node_num = 0;
-    if (RM_product.size() > 1) node_num = RM_product.size() - 1;
-
-    if (variate_num > 1) {
-      for (int i = 0; i < RM_product.size(); i++) {
-        int n = 0;
-        for (int j = variate_num - 1; j >= 0; j--) {
-          if (RM_product[i][j] == '1' || optimal_polarity[j] == '2') n++;
-        }
-        if (n > 0) node_num = node_num + n - 1;
-      }
-    }
-    return node_num;
-  }
-  /**************************************************************************************************************/
-  /* Create expression. */
-  string create_expression(vector<string>& RM_product, int& variate_num,
-                           string& optimal_polarity, vector<string>& binary) {
-    string st = "abcdefghijklmnopqrstuvwxyz";
-    string expression = "";
-    if (RM_product.size() > 1)
-      for (int i = 0; i < RM_product.size() - 1; i++) expression += '[';
-    for (int i = 0; i < RM_product.size(); i++) {
-      int k = 0;
-      int l = 0;
-      int m = 0;
-      for (int j = variate_num - 1; j >= 0; j--) {
-        if (RM_product[i][j] == '1' || optimal_polarity[j] == '2') l++;
-      }
-      for (int j = 0; j < l - 1; j++) expression += '(';
-      for (int j = variate_num - 1; j >= 0; j--) {
-        if (optimal_polarity[j] == '0' && RM_product[i][j] == '1') {
-          expression += st[k];
-          m++;
-        } else if (optimal_polarity[j] == '1' && RM_product[i][j] == '1') {
-          expression += '!';
-          expression += st[k];
-          m++;
-        } else if (optimal_polarity[j] == '2' && RM_product[i][j] == '1') {
-          expression += st[k];
-          m++;
-        } else if (optimal_polarity[j] == '2' && RM_product[i][j] == '0') {
-          expression += '!';
-          expression += st[k];
-          m++;
-        }
-
-        if ((m > 1 && RM_product[i][j] == '1') ||
-            (m > 1 && optimal_polarity[j] == '2'))
-          expression += ')';
-        k++;
-      }
-      if (RM_product[i] == binary[0]) {
-        int flag = 0;
-        for (int m = variate_num - 1; m >= 0; m--) {
-          if (optimal_polarity[m] == '2') flag = 1;
-        }
-        if (flag == 0) expression += '1';
-      }
-      if (i > 0 && RM_product.size() > 1) expression += ']';
-    }
-    return expression;
+    return rm_create_signal(ntk, terms, pis);
   }
   /**************************************************************************************************************/
   /* Replace network. */
-  void substitute_network_mffc(string& expression, std::vector<node_t>& leaves,
-                               node_t n) {
-    auto opt = create_ntk_from_str(expression, leaves);
+  void substitute_network_mffc(std::vector<rm_term> const& terms,
+                               std::vector<node_t>& leaves, node_t n) {
+    auto opt = create_ntk_from_terms(terms, leaves);
     ntk.substitute_node(n, opt);
     ntk.set_value(n, 0);
     ntk.set_value(ntk.get_node(opt), ntk.fanout_size(ntk.get_node(opt)));
@@ -413,9 +102,9 @@ class rm_mixed_polarity_impl {
   }
   /**************************************************************************************************************/
   /* Replace network. */
-  void substitute_network_cut(string& expression, std::vector<node_t>& leaves,
-                              node_t n) {
-    auto opt = create_ntk_from_str(expression, leaves);
+  void substitute_network_cut(std::vector<rm_term> const& terms,
+                              std::vector<node_t>& leaves, node_t n) {
+    auto opt = create_ntk_from_terms(terms, leaves);
     ntk.substitute_node(n, opt);
     ntk.update_levels();
   }
@@ -497,7 +186,7 @@ class rm_mixed_polarity_impl {
 
     /* enumerate cuts */
     cut_enumeration_params ps;
-    ps.cut_size = 6;
+    ps.cut_size = ps_ntk.cut_size;
     ps.cut_limit = 8;
     ps.minimize_truth_table = true;
     /* true enables truth table computation */
@@ -532,53 +221,15 @@ class rm_mixed_polarity_impl {
         int mffc_num_nodes = mffc_size(dcut, n);
         if (mffc_num_nodes == 1) continue;
 
-        string tt = to_binary(cuts.truth_table(*cut));
-        string str = "1";
-
-        int index1 = tt.find(str);
-        if (index1 >= tt.length()) continue;
-
-        int len = tt.length();
-        /* Stores the number of input variables. */
-        int variate_num = log(len) / log(2);
-
-        /* List all possible variable values/List truth table. */
-        vector<string> binary = list_truth_table(variate_num);
-
-        /* Stores the output of the truth table. */
-        vector<char> c_out;
-        for (int i = len - 1; i >= 0; i--) {
-          c_out.push_back(tt[i]);
-        }
-
-        vector<char> c_out1;
-        /* Minimum item for storing binary. */
-        vector<string> minterm;
-        for (int i = 0; i < binary.size(); i++) {
-          if (c_out[i] != '0') {
-            minterm.push_back(binary[i]);
-            c_out1.push_back(c_out[i]);
-          }
-        }
-
-        /* Store all polarities. */
-        vector<string> polarity = list_all_polarities(variate_num);
-
-        /* Count the initial cost. */
-        /* Storage optimal polarity. */
-        string optimal_polarity = polarity[0];
-        /* Mixed polarity conversion algorithm based on list technique. */
-        vector<string> RM_product =
-            polarity_conversion(variate_num, minterm, optimal_polarity);
+        const auto func = cuts.truth_table(*cut);
+        if (kitty::is_const0(func)) continue;
 
         /* Search for the optimal polarity and the corresponding product term.
          */
-        search_for_optimal_polarity(minterm, polarity, variate_num, RM_product,
-                                    optimal_polarity);
+        const auto form = rm_optimal_polarity(func);
 
         /* Count the number of nodes in the new network. */
-        int node_num_new = count_the_number_of_nodes(variate_num, RM_product,
-                                                     optimal_polarity);
+        int node_num_new = form.cost;
 
         if (ps_ntk.multiplicative_complexity == true) {
           int optimization_nodes = dcut.num_gates() - node_num_new -
@@ -592,8 +243,7 @@ class rm_mixed_polarity_impl {
 
             int and_num = 0;
             /* Count the number of and nodes in the new network. */
-            int and_num_new =
-                count_node_num(RM_product, variate_num, optimal_polarity);
+            int and_num_new = rm_and_gates(form);
 
             dcut.foreach_gate([&](auto const& n1) {
               if (ntk.is_and(n1)) and_num++;
@@ -605,12 +255,8 @@ class rm_mixed_polarity_impl {
             LevelOrder(n, pis, optimization_and_nodes);
 
             if (optimization_and_nodes >= 0) {
-              /* Create expression. */
-              string expression = create_expression(RM_product, variate_num,
-                                                    optimal_polarity, binary);
-
               /* Replace network. */
-              substitute_network_cut(expression, leaves, n);
+              substitute_network_cut(rm_form_terms(form), leaves, n);
             }
           }
         } else {
@@ -618,12 +264,8 @@ class rm_mixed_polarity_impl {
                                    (dcut.num_gates() - mffc_num_nodes);
 
           if (optimization_nodes > 0) {
-            /* Create expression. */
-            string expression = create_expression(RM_product, variate_num,
-                                                  optimal_polarity, binary);
-
             /* Replace network. */
-            substitute_network_cut(expression, leaves, n);
+            substitute_network_cut(rm_form_terms(form), leaves, n);
           }
         }
       }
@@ -658,7 +300,7 @@ class rm_mixed_polarity_impl {
       if (mffc_size(ntk, n) == 1) return true;
 
       mffc_view mffc{ntk, n};
-      if (mffc.num_pos() == 0 || mffc.num_pis() > 6) {
+      if (mffc.num_pos() == 0 || mffc.num_pis() > ps_ntk.cut_size) {
         return true;
       }
 
@@ -666,57 +308,18 @@ class rm_mixed_polarity_impl {
       mffc.foreach_pi([&](auto const& m, auto j) { leaves[j] = m; });
 
       default_simulator<kitty::dynamic_truth_table> sim(mffc.num_pis());
-      string tt = to_binary(simulate<kitty::dynamic_truth_table>(mffc, sim)[0]);
-      string str = "1";
-
-      int index1 = tt.find(str);
-      if (index1 >= tt.length()) return true;
-
-      int len = tt.length();
-      /* Stores the number of input variables. */
-      int variate_num = log(len) / log(2);
-
-      /* List all possible variable values/List truth table. */
-      vector<string> binary = list_truth_table(variate_num);
-
-      /* Stores the output of the truth table. */
-      vector<char> c_out;
-      for (int i = len - 1; i >= 0; i--) {
-        c_out.push_back(tt[i]);
-      }
-
-      vector<char> c_out1;
-      /* Minimum item for storing binary. */
-      vector<string> minterm;
-      for (int i = 0; i < binary.size(); i++) {
-        if (c_out[i] != '0') {
-          minterm.push_back(binary[i]);
-          c_out1.push_back(c_out[i]);
-        }
-      }
-
-      /* Store all polarities. */
-      vector<string> polarity = list_all_polarities(variate_num);
-
-      /* Count the initial cost. */
-      /* Storage optimal polarity. */
-      string optimal_polarity = polarity[0];
-      /* Mixed polarity conversion algorithm based on list technique. */
-      vector<string> RM_product =
-          polarity_conversion(variate_num, minterm, optimal_polarity);
+      const auto func = simulate<kitty::dynamic_truth_table>(mffc, sim)[0];
+      if (kitty::is_const0(func)) return true;
 
       /* Search for the optimal polarity and the corresponding product term. */
-      search_for_optimal_polarity(minterm, polarity, variate_num, RM_product,
-                                  optimal_polarity);
+      const auto form = rm_optimal_polarity(func);
 
       /* Count the number of nodes in the new network. */
-      int node_num_new =
-          count_the_number_of_nodes(variate_num, RM_product, optimal_polarity);
+      int node_num_new = form.cost;
 
       if (ps_ntk.multiplicative_complexity == true) {
         /* Count the number of and nodes in the new network. */
-        int and_num_new =
-            count_node_num(RM_product, variate_num, optimal_polarity);
+        int and_num_new = rm_and_gates(form);
         int and_num = 0;
         mffc.foreach_gate([&](auto const& n1, auto i) {
           if (ntk.is_and(n1)) and_num++;
@@ -726,22 +329,14 @@ class rm_mixed_polarity_impl {
         int optimization_and_nodes = and_num - and_num_new;
 
         if (optimization_nodes > 0 && optimization_and_nodes >= 0) {
-          /* Create expression. */
-          string expression = create_expression(RM_product, variate_num,
-                                                optimal_polarity, binary);
-
           /* Replace network. */
-          substitute_network_mffc(expression, leaves, n);
+          substitute_network_mffc(rm_form_terms(form), leaves, n);
         }
       } else {
         int optimization_nodes = mffc.num_gates() - node_num_new;
         if (optimization_nodes > 0) {
-          /* Create expression. */
-          string expression = create_expression(RM_product, variate_num,
-                                                optimal_polarity, binary);
-
           /* Replace network. */
-          substitute_network_mffc(expression, leaves, n);
+          substitute_network_mffc(rm_form_terms(form), leaves, n);
         }
       }
 
@@ -15,9 +15,15 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <limits>
 #include <mockturtle/mockturtle.hpp>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
+
+#include "rm_spectrum.hpp"
+#include "utils/parallel.hpp"
 using namespace std;
 
 namespace mockturtle {
@@ -38,6 +44,19 @@ struct rm_rewriting_params2 {
 
   /*! \brief minimum multiplicative complexity in XAG. */
   bool multiplicative_complexity{false};
+
+  /*! \brief Number of threads computing RM forms (0 = all cores).
+   *
+   * With more than one thread, the RM forms of all cuts (or MFFCs) are
+   * computed up front on a read-only network, and the rewrites are then
+   * re-checked and applied serially.  With cuts the result equals the serial
+   * one.  With MFFCs it may differ: a gate is skipped if its gain, estimated
+   * on the network before any rewrite and without sharing existing gates, is
+   * not positive, and the precomputed MFFC is used while its leaves are
+   * alive, even if earlier rewrites changed it.  The result is the same for
+   * any number of threads above one.
+   */
+  uint32_t num_threads{1u};
 };
 
 namespace detail {
@@ -693,53 +712,6 @@ class rm_mixed_polarity_impl2 {
         [&](auto const& n) { ntk1.set_value(n, ntk1.fanout_size(n)); });
   }
   /**************************************************************************************************************/
-  /* Count the number of nodes in the new network. */
-  int count_the_number_of_nodes(int& variate_num, vector<string>& RM_product,
-                                string& optimal_polarity) {
-    /* Count the number of nodes. */
-    int node_num = 0;
-    if (RM_product.size() > 1) node_num = RM_product.size() - 1;
-
-    if (variate_num > 1) {
-      for (int i = 0; i < RM_product.size(); i++) {
-        int n = 0;
-        for (int j = variate_num - 1; j >= 0; j--) {
-          if (RM_product[i][j] == '1' || optimal_polarity[j] == '2') n++;
-        }
-        if (n > 0) node_num = node_num + n - 1;
-      }
-    }
-    return node_num;
-  }
-  /**************************************************************************************************************/
-  /* Convert ternary to decimal. */
-  int atoint(string s, int radix) {
-    int ans = 0;
-    for (int i = 0; i < s.size(); i++) {
-      char t = s[i];
-      if (t >= '0' && t <= '9')
-        ans = ans * radix + t - '0';
-      else
-        ans = ans * radix + t - 'a' + 10;
-    }
-    return ans;
-  }
-  /**************************************************************************************************************/
-  /* Convert decimal to ternary. */
-  string intToA(int n, int radix) {
-    string ans = "";
-    do {
-      int t = n % radix;
-      if (t >= 0 && t <= 9)
-        ans += t + '0';
-      else
-        ans += t - 10 + 'a';
-      n /= radix;
-    } while (n != 0);
-    reverse(ans.begin(), ans.end());
-    return ans;
-  }
-  /**************************************************************************************************************/
   /* create signal by expression. */
   signal_t create_ntk_from_str(std::string const& s,
                                std::vector<signal<Ntk>> const& children) {
@@ -790,212 +762,209 @@ class rm_mixed_polarity_impl2 {
     return inputs.top();
   }
   /**************************************************************************************************************/
-  /* List all possible variable values/List truth table. */
-  vector<string> list_truth_table(int& variate_num) {
-    int a = pow(2, variate_num);
-    vector<int> b;
-    for (int i = 0; i < a; i++) {
-      b.push_back(i);
-    }
-    vector<string> binary;
-    for (int i = 0; i < a; i++) {
-      string binary1;
-      for (int j = variate_num - 1; j >= 0; j--) {
-        int d = ((b[i] >> j) & 1);
-        binary1 += d + 48;
-      }
-      binary.push_back(binary1);
-    }
-    return binary;
-  }
-  /**************************************************************************************************************/
-  /* List all possible polarity values. */
-  vector<string> list_all_polarities(int& variate_num) {
-    int a_1 = pow(2, variate_num);
-    vector<int> c;
-    for (int i = 0; i < a_1; i++) {
-      c.push_back(i);
-    }
-    vector<string> polarity1;
-    for (int i = 0; i < a_1; i++) {
-      string polarity2;
-      for (int j = variate_num - 1; j >= 0; j--) {
-        int d = ((c[i] >> j) & 1);
-        polarity2 += d + 48;
-      }
-      polarity1.push_back(polarity2);
+  /* Create the signal of an RM form.  Mixed polarities are built directly
+   * from the product terms, fixed polarities are factored by the onset table.
+   */
+  signal_t create_ntk_from_form(rm_form const& form,
+                                std::vector<signal<Ntk>> const& children) {
+    if (std::find(form.polarity.begin(), form.polarity.end(),
+                  rm_polarity::shannon) != form.polarity.end()) {
+      return rm_create_signal(ntk, rm_form_terms(form), children);
     }
 
-    /* Store all polarities. */
-    vector<string> polarity;
-    polarity.push_back(polarity1[0]);
-    int a2 = pow(3, variate_num);
-    string str1 = polarity1[0];
-    string str2 = polarity1[1];
-    for (int i = 0; i < a2 - 1; i++) {
-      int num1 = atoint(str1, 3);
-      int num2 = atoint(str2, 3);
+    int variate_num = form.num_vars;
+    string optimal_polarity;
+    vector<string> RM_product;
+    rm_form_to_strings(form, RM_product, optimal_polarity);
 
-      int sum = num1 + num2;
-      string str3 = intToA(sum, 3);
+    onset.clear();  // 初始化onset表
+    for (int i = 0; i < optimal_polarity.size(); i++)
+      onset[0][i] = optimal_polarity[i] - '0';
 
-      str1 = "0";
-      if (str3.size() < variate_num) {
-        for (int i = 0; i < variate_num - str3.size() - 1; i++) str1 += '0';
+    for (int i = 0; i < variate_num; i++) onset[1][i] = variate_num - i - 1;
 
-        str1 += str3;
-      } else
-        str1 = str3;
-
-      polarity.push_back(str1);
+    for (int i = 0; i < RM_product.size(); i++) {
+      for (int j = 0; j < variate_num; j++) {
+        onset[i + 2][j] = RM_product[i][j] - '0';
+      }
     }
-    return polarity;
+
+    expression_new = "";
+    pw_opt_by_onset(onset);
+    expression_adjusted = "";
+    adjust_the_expression();
+    return create_ntk_from_str(expression_adjusted, children);
   }
   /**************************************************************************************************************/
-  /* Mixed polarity conversion algorithm based on list technique. */
-  vector<string> polarity_conversion(int& variate_num, vector<string>& minterm,
-                                     string& polarity) {
-    vector<string> RM_product = minterm;
-    string str;
-    for (int i = 0; i < variate_num; i++) {
-      for (int j = 0; j < RM_product.size(); j++) {
-        if (polarity[i] == '0') {
-          if (RM_product[j][i] == '0') {
-            str = RM_product[j];
-            str[i] = '1';
-            RM_product.push_back(str);
-          }
-        } else if (polarity[i] == '1') {
-          if (RM_product[j][i] == '1') {
-            str = RM_product[j];
-            str[i] = '0';
-            RM_product.push_back(str);
-          }
-        }
-      }
-      if (polarity[i] == '0') {
-        /* Delete the minimum number of even items. */
-        if (RM_product.size() > 0) {
-          sort(RM_product.begin(), RM_product.end());
-          for (int m = 0; m < RM_product.size() - 1; m++) {
-            if (RM_product[m] == RM_product[m + 1]) {
-              RM_product[m] = "0";
-              RM_product[m + 1] = "0";
-            }
-          }
-        }
-        /* Delete item with '0' in array. */
-        vector<string> final_term;
-        final_term.clear();
-        for (int m = 0; m < RM_product.size(); m++) {
-          if (RM_product[m] != "0") final_term.push_back(RM_product[m]);
-        }
-        RM_product.clear();
-        RM_product = final_term;
-      } else if (polarity[i] == '1') {
-        /* Delete the minimum number of even items. */
-        if (RM_product.size() > 0) {
-          sort(RM_product.begin(), RM_product.end());
-          for (int m = 0; m < RM_product.size() - 1; m++) {
-            if (RM_product[m] == RM_product[m + 1]) {
-              RM_product[m] = "0";
-              RM_product[m + 1] = "0";
-            }
-          }
+  /* Scratch space of one worker, indexed by node index.  Entries are reset
+   * after each MFFC, so that no hash maps are needed. */
+  struct mffc_scratch {
+    static constexpr uint32_t unset = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> refs; /* remaining fanouts outside the MFFC */
+    std::vector<uint32_t> slot; /* position in the MFFC nodes or leaves */
+    std::vector<node<Ntk>> touched;
+    std::vector<kitty::dynamic_truth_table> tts;
+  };
+
+  /* Collect the MFFC of n without touching the reference counters, so that it
+   * can run on worker threads.  Nodes are returned in reverse topological
+   * order, leaves in ascending order. */
+  void snapshot_mffc(node<Ntk> const& n, std::vector<node<Ntk>>& nodes,
+                     std::vector<node<Ntk>>& leaves,
+                     mffc_scratch& scratch) const {
+    std::vector<node<Ntk>> stack{n};
+    nodes.clear();
+    scratch.slot[ntk.node_to_index(n)] = 0u;
+    scratch.touched.push_back(n);
+    while (!stack.empty()) {
+      const auto m = stack.back();
+      stack.pop_back();
+      nodes.push_back(m);
+      ntk.foreach_fanin(m, [&](auto const& s) {
+        const auto c = ntk.get_node(s);
+        if (ntk.is_constant(c) || ntk.is_pi(c)) return;
+        auto& refs = scratch.refs[ntk.node_to_index(c)];
+        if (refs == mffc_scratch::unset) {
+          refs = ntk.fanout_size(c);
+          scratch.touched.push_back(c);
         }
-        /* Delete item with '0' in array. */
-        vector<string> final_term;
-        final_term.clear();
-        for (int m = 0; m < RM_product.size(); m++) {
-          if (RM_product[m] != "0") {
-            if (RM_product[m][i] == '0')
-              RM_product[m][i] = '1';
-            else if (RM_product[m][i] == '1')
-              RM_product[m][i] = '0';
-            final_term.push_back(RM_product[m]);
-          }
+        /* all fanouts are inside the MFFC */
+        if (--refs == 0u) {
+          scratch.slot[ntk.node_to_index(c)] = 0u;
+          stack.push_back(c);
         }
-        RM_product.clear();
-        RM_product = final_term;
-      }
+      });
+    }
+
+    leaves.clear();
+    for (const auto& m : nodes) {
+      ntk.foreach_fanin(m, [&](auto const& s) {
+        const auto c = ntk.get_node(s);
+        if (!ntk.is_constant(c) &&
+            scratch.slot[ntk.node_to_index(c)] == mffc_scratch::unset)
+          leaves.push_back(c);
+      });
     }
-    return RM_product;
+    std::sort(leaves.begin(), leaves.end());
+    leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
   }
   /**************************************************************************************************************/
-  /* Search for the optimal polarity and the corresponding product term. */
-  void search_for_optimal_polarity(vector<string>& minterm,
-                                   vector<string>& polarity, int& variate_num,
-                                   vector<string>& RM_product,
-                                   string& optimal_polarity) {
-    int minimum = INT_MAX;
-    vector<string> RM_product_initial;
-    for (int l = 0; l < polarity.size(); l++) {
-      RM_product_initial =
-          polarity_conversion(variate_num, minterm, polarity[l]);
-
-      int count = 0;
-      count = count_the_number_of_nodes(variate_num, RM_product_initial,
-                                        polarity[l]);
-
-      if (count < minimum) {
-        optimal_polarity = polarity[l];
-        RM_product.clear();
-        RM_product = RM_product_initial;
-        RM_product_initial.clear();
-        minimum = count;
-      } else {
-        RM_product_initial.clear();
-      }
+  /* Simulate the MFFC collected by snapshot_mffc over its leaves. */
+  kitty::dynamic_truth_table simulate_snapshot(
+      std::vector<node<Ntk>> const& nodes,
+      std::vector<node<Ntk>> const& leaves, mffc_scratch& scratch) const {
+    const auto num_vars = static_cast<uint32_t>(leaves.size());
+    auto& tts = scratch.tts;
+    tts.assign(num_vars + nodes.size(), kitty::dynamic_truth_table(num_vars));
+    for (auto i = 0u; i < num_vars; ++i) {
+      kitty::create_nth_var(tts[i], i);
+      scratch.slot[ntk.node_to_index(leaves[i])] = i;
+      scratch.touched.push_back(leaves[i]);
+    }
+
+    std::vector<kitty::dynamic_truth_table> fanin_tts;
+    auto next = num_vars;
+    for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+      fanin_tts.clear();
+      ntk.foreach_fanin(*it, [&](auto const& s) {
+        const auto c = ntk.get_node(s);
+        if (ntk.is_constant(c)) {
+          fanin_tts.emplace_back(num_vars);
+        } else {
+          fanin_tts.push_back(tts[scratch.slot[ntk.node_to_index(c)]]);
+        }
+      });
+      scratch.slot[ntk.node_to_index(*it)] = next;
+      tts[next++] = ntk.compute(*it, fanin_tts.begin(), fanin_tts.end());
     }
+    return tts[scratch.slot[ntk.node_to_index(nodes.front())]];
+  }
+
+  void reset_scratch(mffc_scratch& scratch) const {
+    for (auto const& m : scratch.touched) {
+      scratch.refs[ntk.node_to_index(m)] = mffc_scratch::unset;
+      scratch.slot[ntk.node_to_index(m)] = mffc_scratch::unset;
+    }
+    scratch.touched.clear();
   }
   /**************************************************************************************************************/
-  /* Create expression. */
-  string create_expression(vector<string>& RM_product, int& variate_num,
-                           string& optimal_polarity, vector<string>& binary) {
-    string st = "abcdefghijklmnopqrstuvwxyz";
-    string expression = "";
-    if (RM_product.size() > 1)
-      for (int i = 0; i < RM_product.size() - 1; i++) expression += '[';
-    for (int i = 0; i < RM_product.size(); i++) {
-      int k = 0;
-      int l = 0;
-      int m = 0;
-      for (int j = variate_num - 1; j >= 0; j--) {
-        if (RM_product[i][j] == '1' || optimal_polarity[j] == '2') l++;
-      }
-      for (int j = 0; j < l - 1; j++) expression += '(';
-      for (int j = variate_num - 1; j >= 0; j--) {
-        if (optimal_polarity[j] == '0' && RM_product[i][j] == '1') {
-          expression += st[k];
-          m++;
-        } else if (optimal_polarity[j] == '1' && RM_product[i][j] == '1') {
-          expression += '!';
-          expression += st[k];
-          m++;
-        } else if (optimal_polarity[j] == '2' && RM_product[i][j] == '1') {
-          expression += st[k];
-          m++;
-        } else if (optimal_polarity[j] == '2' && RM_product[i][j] == '0') {
-          expression += '!';
-          expression += st[k];
-          m++;
-        }
+  /* Compute the RM forms of all candidate cuts on worker threads.  The
+   * forms are indexed by node index and by position in the cut set. */
+  template <class Cuts>
+  std::vector<std::vector<rm_form>> compute_cut_forms(Cuts const& cuts,
+                                                      uint32_t size) const {
+    std::vector<node<Ntk>> nodes;
+    ntk.foreach_node([&](auto const& n, auto index) {
+      if (index >= size) return false;
+      if (!ntk.is_constant(n) && !ntk.is_pi(n)) nodes.push_back(n);
+      return true;
+    });
 
-        if ((m > 1 && RM_product[i][j] == '1') ||
-            (m > 1 && optimal_polarity[j] == '2'))
-          expression += ')';
-        k++;
-      }
-      if (RM_product[i] == binary[0]) {
-        int flag = 0;
-        for (int m = variate_num - 1; m >= 0; m--) {
-          if (optimal_polarity[m] == '2') flag = 1;
-        }
-        if (flag == 0) expression += '1';
-      }
-      if (i > 0 && RM_product.size() > 1) expression += ']';
+    std::vector<std::vector<rm_form>> forms(size);
+    phyLS::parallel_for(
+        ps_ntk.num_threads, 0u, nodes.size(),
+        [&](auto i, auto) {
+          const auto index = ntk.node_to_index(nodes[i]);
+          auto& node_forms = forms[index];
+          for (auto& cut : cuts.cuts(index)) {
+            node_forms.emplace_back();
+            if (cut->size() < ps.min_cand_cut_size) continue;
+            node_forms.back() = rm_optimal_polarity(cuts.truth_table(*cut));
+          }
+        },
+        16u);
+    return forms;
+  }
+  /**************************************************************************************************************/
+  /* Compute the MFFCs of all gates, their RM forms and the estimated gain
+   * on worker threads.  The estimate assumes that no gate of the new
+   * structure already exists, so it is a lower bound of the gain that the
+   * serial pass re-checks exactly. */
+  struct mffc_candidate {
+    std::vector<node<Ntk>> leaves;
+    rm_form form;
+    int32_t gain{0};
+    bool valid{false};
+  };
+
+  std::vector<mffc_candidate> compute_mffc_forms(uint32_t size) const {
+    std::vector<node<Ntk>> gates;
+    ntk.foreach_gate([&](auto const& n, auto i) {
+      if (i >= size) return false;
+      gates.push_back(n);
+      return true;
+    });
+
+    std::vector<mffc_scratch> scratches(
+        phyLS::resolve_num_threads(ps_ntk.num_threads));
+    for (auto& scratch : scratches) {
+      scratch.refs.assign(ntk.size(), mffc_scratch::unset);
+      scratch.slot.assign(ntk.size(), mffc_scratch::unset);
     }
-    return expression;
+
+    std::vector<mffc_candidate> candidates(ntk.size());
+    phyLS::parallel_for(
+        ps_ntk.num_threads, 0u, gates.size(),
+        [&](auto i, auto thread_id) {
+          const auto n = gates[i];
+          if (ntk.fanout_size(n) == 0u) return;
+
+          auto& scratch = scratches[thread_id];
+          std::vector<node<Ntk>> nodes;
+          auto& cand = candidates[ntk.node_to_index(n)];
+          snapshot_mffc(n, nodes, cand.leaves, scratch);
+          if (cand.leaves.size() <= ps.cut_enumeration_ps.cut_size) {
+            int32_t cost = 0;
+            for (const auto& m : nodes) cost += NodeCostFn{}(ntk, m);
+            cand.form = rm_optimal_polarity(
+                simulate_snapshot(nodes, cand.leaves, scratch));
+            cand.gain = cost - static_cast<int32_t>(cand.form.cost);
+            cand.valid = true;
+          }
+          reset_scratch(scratch);
+        },
+        16u);
+    return candidates;
   }
   /**************************************************************************************************************/
   /* Cut is used to divide the network. */
@@ -1016,6 +985,12 @@ class rm_mixed_polarity_impl2 {
 
     /* iterate over all original nodes in the network */
     const auto size = ntk.size();
+
+    /* in parallel mode, the RM forms are computed up front */
+    const bool parallel = phyLS::resolve_num_threads(ps_ntk.num_threads) > 1u;
+    std::vector<std::vector<rm_form>> cut_forms;
+    if (parallel) cut_forms = compute_cut_forms(cuts, size);
+
     auto max_total_gain = 0u;
     progress_bar pbar{ntk.size(),
                       "rm_optimization_by_cut |{0}| node = {1:>4}@{2:>2} / " +
@@ -1052,80 +1027,12 @@ class rm_mixed_polarity_impl2 {
         and_node_deref = 0;
         int32_t value = recursive_deref1(ntk, n);
         {
-          string tt = to_binary(cuts.truth_table(*cut));
-
-          int len = tt.length();
-          /* Stores the number of input variables. */
-          int variate_num = log(len) / log(2);
-
-          /* List all possible variable values/List truth table. */
-          vector<string> binary = list_truth_table(variate_num);
-
-          /* Stores the output of the truth table. */
-          vector<char> c_out;
-          for (int i = len - 1; i >= 0; i--) {
-            c_out.push_back(tt[i]);
-          }
-
-          vector<char> c_out1;
-          /* Minimum item for storing binary. */
-          vector<string> minterm;
-          for (int i = 0; i < binary.size(); i++) {
-            if (c_out[i] != '0') {
-              minterm.push_back(binary[i]);
-              c_out1.push_back(c_out[i]);
-            }
-          }
-
-          /* Store all polarities. */
-          vector<string> polarity = list_all_polarities(variate_num);
-
-          /* Storage optimal polarity. */
-          string optimal_polarity;
-          /* Mixed polarity conversion algorithm based on list technique. */
-          vector<string> RM_product;
-
           /* Search for the optimal polarity and the corresponding product
            * term.*/
-          search_for_optimal_polarity(minterm, polarity, variate_num,
-                                      RM_product, optimal_polarity);
-
-          int pos = optimal_polarity.find("2");
-          string expression = "";
-          if (pos != optimal_polarity.npos) {
-            expression = create_expression(RM_product, variate_num,
-                                           optimal_polarity, binary);
-          } else {
-            onset.clear();  // 初始化onset表
-            for (int i = 0; i < optimal_polarity.size(); i++)
-              onset[0][i] = optimal_polarity[i] - '0';
-
-            for (int i = 0; i < variate_num; i++)
-              onset[1][i] = variate_num - i - 1;
-
-            for (int i = 0; i < RM_product.size(); i++) {
-              for (int j = 0; j < variate_num; j++) {
-                onset[i + 2][j] = RM_product[i][j] - '0';
-              }
-            }
-
-            // cout<<"-----------------------------------"<<endl;
-            //   for(int i=0;i<onset.size();i++)
-            //   {
-            //     for(int j=0;j<onset[i].size();j++)
-            //       cout<<onset[i][j]<<" ";
-            //     cout<<endl;
-            //   }
-            //   cout<<endl;
-            // cout<<"-----------------------------------"<<endl;
-            expression_new = "";
-            pw_opt_by_onset(onset);
-            expression_adjusted = "";
-            adjust_the_expression();
-            expression = expression_adjusted;
-          }
-
-          auto f_new = create_ntk_from_str(expression, children);
+          const auto form =
+              parallel ? std::move(cut_forms[ntk.node_to_index(n)][a - 1])
+                       : rm_optimal_polarity(cuts.truth_table(*cut));
+          auto f_new = create_ntk_from_form(form, children);
 
           and_node_ref = 0;
           auto [v, contains] =
@@ -1203,6 +1110,26 @@ class rm_mixed_polarity_impl2 {
     }
   }
   /**************************************************************************************************************/
+  /* Leaves and RM form of the current MFFC of n, false if it is too large. */
+  bool mffc_form(node<Ntk> const& n, std::vector<signal<Ntk>>& leaves,
+                 rm_form& form) {
+    mffc_view mffc{ntk, n};
+    if (mffc.num_pos() == 0 ||
+        mffc.num_pis() > ps.cut_enumeration_ps.cut_size) {
+      return false;
+    }
+
+    leaves.resize(mffc.num_pis());
+    mffc.foreach_pi(
+        [&](auto const& m, auto j) { leaves[j] = ntk.make_signal(m); });
+
+    /* Search for the optimal polarity and the corresponding product term. */
+    default_simulator<kitty::dynamic_truth_table> sim(mffc.num_pis());
+    form = rm_optimal_polarity(
+        simulate<kitty::dynamic_truth_table>(mffc, sim)[0]);
+    return true;
+  }
+  /**************************************************************************************************************/
   /* mffc is used to divide the network. */
   void ntk_mffc() {
     progress_bar pbar{ntk.size(),
@@ -1216,6 +1143,15 @@ class rm_mixed_polarity_impl2 {
         [&](auto const& n) { ntk.set_value(n, ntk.fanout_size(n)); });
 
     const auto size = ntk.num_gates();
+
+    /* in parallel mode, MFFCs, RM forms and estimated gains are computed up
+     * front on the unmodified network; gates without estimated gain are
+     * skipped, the others are re-checked exactly while their leaves are
+     * alive */
+    const bool parallel = phyLS::resolve_num_threads(ps_ntk.num_threads) > 1u;
+    std::vector<mffc_candidate> candidates;
+    if (parallel) candidates = compute_mffc_forms(size);
+
     ntk.foreach_gate([&](auto const& n, auto i) {
       if (i >= size) {
         return false;
@@ -1223,84 +1159,30 @@ class rm_mixed_polarity_impl2 {
       if (ntk.fanout_size(n) == 0u) {
         return true;
       }
-      mffc_view mffc{ntk, n};
 
       pbar(i, i, _candidates, _estimated_gain);
 
-      if (mffc.num_pos() == 0 || mffc.num_pis() > 6) {
-        return true;
-      }
-
-      std::vector<signal<Ntk>> leaves(mffc.num_pis());
-      mffc.foreach_pi(
-          [&](auto const& m, auto j) { leaves[j] = ntk.make_signal(m); });
-
-      default_simulator<kitty::dynamic_truth_table> sim(mffc.num_pis());
-      string tt = to_binary(simulate<kitty::dynamic_truth_table>(mffc, sim)[0]);
-
-      int len = tt.length();
-      /* Stores the number of input variables. */
-      int variate_num = log(len) / log(2);
-
-      /* List all possible variable values/List truth table. */
-      vector<string> binary = list_truth_table(variate_num);
-
-      /* Stores the output of the truth table. */
-      vector<char> c_out;
-      for (int i = len - 1; i >= 0; i--) {
-        c_out.push_back(tt[i]);
-      }
-
-      vector<char> c_out1;
-      /* Minimum item for storing binary. */
-      vector<string> minterm;
-      for (int i = 0; i < binary.size(); i++) {
-        if (c_out[i] != '0') {
-          minterm.push_back(binary[i]);
-          c_out1.push_back(c_out[i]);
+      std::vector<signal<Ntk>> leaves;
+      rm_form form;
+      if (parallel) {
+        auto& cand = candidates[ntk.node_to_index(n)];
+        if (!cand.valid || cand.gain <= 0) {
+          return true;
         }
-      }
-
-      /* Store all polarities. */
-      vector<string> polarity = list_all_polarities(variate_num);
-
-      /* Count the initial cost. */
-      /* Storage optimal polarity. */
-      string optimal_polarity = polarity[0];
-      /* Mixed polarity conversion algorithm based on list technique. */
-      vector<string> RM_product =
-          polarity_conversion(variate_num, minterm, optimal_polarity);
-
-      /* Search for the optimal polarity and the corresponding product term. */
-      search_for_optimal_polarity(minterm, polarity, variate_num, RM_product,
-                                  optimal_polarity);
-
-      int pos = optimal_polarity.find("2");
-      string expression = "";
-      if (pos != optimal_polarity.npos) {
-        expression = create_expression(RM_product, variate_num,
-                                       optimal_polarity, binary);
-      } else {
-        onset.clear();  // 初始化onset表
-        for (int i = 0; i < optimal_polarity.size(); i++)
-          onset[0][i] = optimal_polarity[i] - '0';
-
-        for (int i = 0; i < variate_num; i++) onset[1][i] = variate_num - i - 1;
-
-        for (int i = 0; i < RM_product.size(); i++) {
-          for (int j = 0; j < variate_num; j++) {
-            onset[i + 2][j] = RM_product[i][j] - '0';
-          }
+        const bool alive =
+            std::none_of(cand.leaves.begin(), cand.leaves.end(),
+                         [&](auto const& l) { return ntk.is_dead(l); });
+        if (alive) {
+          for (const auto& l : cand.leaves) leaves.push_back(ntk.make_signal(l));
+          form = std::move(cand.form);
+        } else if (!mffc_form(n, leaves, form)) {
+          return true;
         }
-
-        expression_new = "";
-        pw_opt_by_onset(onset);
-        expression_adjusted = "";
-        adjust_the_expression();
-        expression = expression_adjusted;
+      } else if (!mffc_form(n, leaves, form)) {
+        return true;
       }
 
-      auto f_new = create_ntk_from_str(expression, leaves);
+      auto f_new = create_ntk_from_form(form, leaves);
 
       and_node_deref = 0;
       int32_t value = recursive_deref1(ntk, n);
@@ -0,0 +1,449 @@
+/* phyLS: powerful heightened yielded Logic Synthesis
+ * Copyright (C) 2022-2023 */
+
+/**
+ * @file rm_spectrum.hpp
+ *
+ * @brief Bit-parallel mixed-polarity Reed-Muller forms
+ *
+ * @author Homyoung
+ * @since  2023/11/16
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <kitty/dynamic_truth_table.hpp>
+#include <mockturtle/traits.hpp>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mockturtle {
+
+/*! \brief Polarity of one variable in a mixed-polarity RM form.
+ *
+ * The values match the characters used by the string based RM code:
+ * '0' is a positive Davio expansion (x), '1' a negative Davio expansion (!x)
+ * and '2' keeps the variable unexpanded (x or !x in every product term).
+ */
+enum class rm_polarity : uint8_t { positive = 0, negative = 1, shannon = 2 };
+
+/*! \brief Mixed-polarity RM form of a single-output function.
+ *
+ * Bit `m` of `coefficients` is set iff the product term with literal mask `m`
+ * occurs in the form.  For a positive (negative) variable `v`, bit `v` of `m`
+ * selects whether x_v (!x_v) is part of the product; for a shannon variable it
+ * selects between x_v and !x_v.
+ */
+struct rm_form {
+  uint32_t num_vars{0};
+  std::vector<rm_polarity> polarity;
+  std::vector<uint64_t> coefficients;
+  uint32_t num_terms{0};
+  uint32_t cost{0};
+};
+
+/*! \brief Product term of an RM form as literal bitmasks.
+ *
+ * Bit `v` of `pos` (`neg`) is set iff x_v (!x_v) is part of the product.  The
+ * term without literals is the constant 1.
+ */
+struct rm_term {
+  uint32_t pos{0};
+  uint32_t neg{0};
+};
+
+namespace detail {
+
+/* masks of the minterms in which variable `v` is 0, for v < 6 */
+static constexpr uint64_t rm_lo_masks[] = {
+    0x5555555555555555u, 0x3333333333333333u, 0x0f0f0f0f0f0f0f0fu,
+    0x00ff00ff00ff00ffu, 0x0000ffff0000ffffu, 0x00000000ffffffffu};
+
+/*! \brief Word-level RM spectrum with per-variable polarity transforms.
+ *
+ * The spectrum starts as the truth table itself, i.e., all variables are in
+ * shannon polarity.  Moving a variable between shannon and positive polarity
+ * is the butterfly `hi ^= lo`, and moving it between positive and negative
+ * polarity is `lo ^= hi`, both applied over the 64-bit words of the table.
+ */
+class rm_spectrum {
+ public:
+  explicit rm_spectrum(kitty::dynamic_truth_table const& tt)
+      : _num_vars(tt.num_vars()),
+        _words(tt.cbegin(), tt.cend()),
+        _polarity(tt.num_vars(), rm_polarity::shannon) {}
+
+  uint32_t num_vars() const { return _num_vars; }
+  std::vector<uint64_t> const& words() const { return _words; }
+  std::vector<rm_polarity> const& polarity() const { return _polarity; }
+
+  /*! \brief Changes the polarity of `var` to an adjacent one.
+   *
+   * Valid transitions are shannon <-> positive and positive <-> negative.
+   */
+  void flip(uint32_t var, rm_polarity to) {
+    auto const from = _polarity[var];
+    if (from == rm_polarity::shannon || to == rm_polarity::shannon) {
+      xor_lo_into_hi(var);
+    } else {
+      xor_hi_into_lo(var);
+    }
+    _polarity[var] = to;
+  }
+
+  /*! \brief Number of product terms. */
+  uint32_t num_terms() const {
+    uint32_t count = 0;
+    for (auto const& w : _words) count += __builtin_popcountll(w);
+    return count;
+  }
+
+  /*! \brief Number of 2-input gates of the form.
+   *
+   * Same metric as `count_the_number_of_nodes` of the string based code:
+   * XOR gates between the product terms plus AND gates inside each term.
+   */
+  uint32_t cost() const { return cost(num_terms()); }
+
+  uint32_t cost(uint32_t terms) const {
+    if (terms == 0u) return 0u;
+
+    uint32_t shannon = 0u;
+    uint32_t literals = 0u;
+    for (auto v = 0u; v < _num_vars; ++v) {
+      if (_polarity[v] == rm_polarity::shannon) {
+        ++shannon;
+      } else {
+        literals += count_var(v);
+      }
+    }
+
+    uint32_t and_gates = literals + terms * shannon - terms;
+    /* the constant-1 term has no literals and needs no gate */
+    if (shannon == 0u && (_words[0] & 1u)) ++and_gates;
+    return terms - 1u + and_gates;
+  }
+
+ private:
+  /* number of product terms that contain variable `var` */
+  uint32_t count_var(uint32_t var) const {
+    uint32_t count = 0u;
+    if (var < 6u) {
+      auto const mask = ~rm_lo_masks[var];
+      for (auto const& w : _words) count += __builtin_popcountll(w & mask);
+    } else {
+      auto const stride = 1u << (var - 6u);
+      for (auto i = 0u; i < _words.size(); i += 2u * stride) {
+        for (auto k = 0u; k < stride; ++k) {
+          count += __builtin_popcountll(_words[i + stride + k]);
+        }
+      }
+    }
+    return count;
+  }
+
+  void xor_lo_into_hi(uint32_t var) {
+    if (var < 6u) {
+      auto const shift = 1u << var;
+      for (auto& w : _words) w ^= (w & rm_lo_masks[var]) << shift;
+    } else {
+      auto const stride = 1u << (var - 6u);
+      for (auto i = 0u; i < _words.size(); i += 2u * stride) {
+        for (auto k = 0u; k < stride; ++k) {
+          _words[i + stride + k] ^= _words[i + k];
+        }
+      }
+    }
+  }
+
+  void xor_hi_into_lo(uint32_t var) {
+    if (var < 6u) {
+      auto const shift = 1u << var;
+      for (auto& w : _words) w ^= (w & ~rm_lo_masks[var]) >> shift;
+    } else {
+      auto const stride = 1u << (var - 6u);
+      for (auto i = 0u; i < _words.size(); i += 2u * stride) {
+        for (auto k = 0u; k < stride; ++k) {
+          _words[i + k] ^= _words[i + stride + k];
+        }
+      }
+    }
+  }
+
+ private:
+  uint32_t _num_vars;
+  std::vector<uint64_t> _words;
+  std::vector<rm_polarity> _polarity;
+};
+
+}  // namespace detail
+
+/*! \brief Finds the mixed-polarity RM form with the fewest gates.
+ *
+ * All 3^n polarity vectors are visited in reflected ternary Gray code order
+ * (shannon, positive, negative per digit), so that each step changes the
+ * polarity of a single variable and updates the spectrum with one butterfly.
+ * Ties are broken towards the polarity that comes first in the enumeration
+ * order of the string based code, which keeps the results unchanged.
+ */
+inline rm_form rm_optimal_polarity(kitty::dynamic_truth_table const& tt) {
+  static constexpr rm_polarity gray_digit[] = {
+      rm_polarity::shannon, rm_polarity::positive, rm_polarity::negative};
+
+  detail::rm_spectrum spectrum(tt);
+  auto const n = spectrum.num_vars();
+
+  /* rank of a polarity vector in the string enumeration order */
+  std::vector<uint64_t> power(n, 1u);
+  for (auto v = 1u; v < n; ++v) power[v] = power[v - 1] * 3u;
+  uint64_t rank = 0u;
+  for (auto v = 0u; v < n; ++v) rank += 2u * power[v];
+
+  rm_form best;
+  best.num_vars = n;
+  best.polarity = spectrum.polarity();
+  best.coefficients = spectrum.words();
+  best.num_terms = spectrum.num_terms();
+  best.cost = spectrum.cost(best.num_terms);
+  uint64_t best_rank = rank;
+
+  std::vector<uint8_t> digit(n, 0u), counter(n, 0u);
+  std::vector<int8_t> direction(n, 1);
+  while (true) {
+    /* next step of the reflected ternary Gray code */
+    auto i = 0u;
+    while (i < n && counter[i] == 2u) {
+      counter[i] = 0u;
+      direction[i] = -direction[i];
+      ++i;
+    }
+    if (i == n) break;
+    ++counter[i];
+
+    auto const from = gray_digit[digit[i]];
+    digit[i] += direction[i];
+    auto const to = gray_digit[digit[i]];
+    spectrum.flip(i, to);
+    rank = rank - static_cast<uint64_t>(from) * power[i] +
+           static_cast<uint64_t>(to) * power[i];
+
+    auto const terms = spectrum.num_terms();
+    /* the XOR gates alone already exceed the best cost */
+    if (terms > best.cost + 1u) continue;
+
+    auto const cost = spectrum.cost(terms);
+    if (cost < best.cost || (cost == best.cost && rank < best_rank)) {
+      best.polarity = spectrum.polarity();
+      best.coefficients = spectrum.words();
+      best.num_terms = terms;
+      best.cost = cost;
+      best_rank = rank;
+    }
+  }
+
+  return best;
+}
+
+/*! \brief Converts an RM form into the product-term strings of the RM code.
+ *
+ * Character `j` of each term and of the polarity string refers to variable
+ * `num_vars - 1 - j`, as in `list_truth_table`.
+ */
+inline void rm_form_to_strings(rm_form const& form,
+                               std::vector<std::string>& RM_product,
+                               std::string& polarity) {
+  auto const n = form.num_vars;
+  polarity.assign(n, '0');
+  for (auto v = 0u; v < n; ++v) {
+    polarity[n - 1 - v] = '0' + static_cast<char>(form.polarity[v]);
+  }
+
+  RM_product.clear();
+  for (auto i = 0u; i < form.coefficients.size(); ++i) {
+    auto w = form.coefficients[i];
+    while (w) {
+      uint64_t const m = i * 64u + __builtin_ctzll(w);
+      w &= w - 1u;
+      std::string term(n, '0');
+      for (auto v = 0u; v < n; ++v) {
+        if ((m >> v) & 1u) term[n - 1 - v] = '1';
+      }
+      RM_product.push_back(term);
+    }
+  }
+}
+
+/*! \brief Number of AND gates of an RM form. */
+inline uint32_t rm_and_gates(rm_form const& form) {
+  return form.num_terms == 0u ? 0u : form.cost - (form.num_terms - 1u);
+}
+
+/*! \brief Lists the product terms of an RM form as literal bitmasks. */
+inline std::vector<rm_term> rm_form_terms(rm_form const& form) {
+  assert(form.num_vars <= 32u);
+
+  uint32_t positive = 0u, negative = 0u, shannon = 0u;
+  for (auto v = 0u; v < form.num_vars; ++v) {
+    switch (form.polarity[v]) {
+      case rm_polarity::positive:
+        positive |= 1u << v;
+        break;
+      case rm_polarity::negative:
+        negative |= 1u << v;
+        break;
+      case rm_polarity::shannon:
+        shannon |= 1u << v;
+        break;
+    }
+  }
+
+  std::vector<rm_term> terms;
+  terms.reserve(form.num_terms);
+  for (auto i = 0u; i < form.coefficients.size(); ++i) {
+    auto w = form.coefficients[i];
+    while (w) {
+      auto const m = static_cast<uint32_t>(i * 64u + __builtin_ctzll(w));
+      w &= w - 1u;
+      terms.push_back({m & (positive | shannon), (m & negative) | (~m & shannon)});
+    }
+  }
+  return terms;
+}
+
+namespace detail {
+
+/*! \brief Builds the signal of an RM term list without going through text.
+ *
+ * Literals are ordered by decreasing number of occurrences and every product
+ * is a balanced AND tree over that order, with sub-products memoized by their
+ * literal set, so that terms sharing frequent literals share gates.  The
+ * products are combined by an XOR tree that always merges the two shallowest
+ * operands.
+ */
+template <class Ntk>
+class rm_signal_builder {
+ public:
+  using signal_t = signal<Ntk>;
+
+  rm_signal_builder(Ntk& ntk, std::vector<signal_t> const& leaves)
+      : ntk(ntk), leaves(leaves), depths(leaves.size(), 0u) {
+    assert(leaves.size() <= 32u);
+    if constexpr (has_level_v<Ntk>) {
+      for (auto i = 0u; i < leaves.size(); ++i) {
+        depths[i] = ntk.level(ntk.get_node(leaves[i]));
+      }
+    }
+  }
+
+  signal_t run(std::vector<rm_term> const& terms) {
+    /* literal 2v is x_v, literal 2v + 1 is !x_v */
+    std::vector<uint32_t> occurrences(2u * leaves.size(), 0u);
+    bool complement = false;
+    for (auto const& t : terms) {
+      if (t.pos == 0u && t.neg == 0u) {
+        complement = !complement;
+        continue;
+      }
+      for (auto v = 0u; v < leaves.size(); ++v) {
+        if ((t.pos >> v) & 1u) ++occurrences[2u * v];
+        if ((t.neg >> v) & 1u) ++occurrences[2u * v + 1u];
+      }
+    }
+
+    std::vector<uint32_t> order(occurrences.size());
+    for (auto i = 0u; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](auto const& a, auto const& b) {
+                       return occurrences[a] > occurrences[b];
+                     });
+
+    std::vector<operand_t> products;
+    std::vector<uint32_t> literals;
+    for (auto const& t : terms) {
+      if (t.pos == 0u && t.neg == 0u) continue;
+      literals.clear();
+      for (auto const& l : order) {
+        auto const mask = (l & 1u) ? t.neg : t.pos;
+        if ((mask >> (l >> 1u)) & 1u) literals.push_back(l);
+      }
+      products.push_back(
+          create_product(literals.data(), literals.data() + literals.size()));
+    }
+
+    if (products.empty()) return ntk.get_constant(complement);
+    return create_xor_tree(products) ^ complement;
+  }
+
+ private:
+  /* depth and signal of an intermediate result */
+  using operand_t = std::pair<uint32_t, signal_t>;
+
+  operand_t create_literal(uint32_t l) {
+    auto const s = leaves[l >> 1u];
+    return {depths[l >> 1u], (l & 1u) ? ntk.create_not(s) : s};
+  }
+
+  operand_t create_product(uint32_t const* begin, uint32_t const* end) {
+    if (end - begin == 1) return create_literal(*begin);
+
+    uint64_t key = 0u;
+    for (auto it = begin; it != end; ++it) key |= uint64_t(1) << *it;
+    if (auto const it = sub_products.find(key); it != sub_products.end()) {
+      return it->second;
+    }
+
+    auto const mid = begin + (end - begin + 1) / 2;
+    auto const a = create_product(begin, mid);
+    auto const b = create_product(mid, end);
+    operand_t const p{std::max(a.first, b.first) + 1u,
+                      ntk.create_and(a.second, b.second)};
+    sub_products.emplace(key, p);
+    return p;
+  }
+
+  signal_t create_xor_tree(std::vector<operand_t> const& operands) {
+    /* min-heap on depth, ties broken by creation order */
+    std::vector<operand_t> nodes(operands);
+    auto const cmp = [&](uint32_t a, uint32_t b) {
+      return nodes[a].first > nodes[b].first ||
+             (nodes[a].first == nodes[b].first && a > b);
+    };
+    std::priority_queue<uint32_t, std::vector<uint32_t>, decltype(cmp)> heap(
+        cmp);
+    for (auto i = 0u; i < nodes.size(); ++i) heap.push(i);
+
+    while (heap.size() > 1u) {
+      auto const a = heap.top();
+      heap.pop();
+      auto const b = heap.top();
+      heap.pop();
+      nodes.emplace_back(std::max(nodes[a].first, nodes[b].first) + 1u,
+                         ntk.create_xor(nodes[a].second, nodes[b].second));
+      heap.push(static_cast<uint32_t>(nodes.size() - 1u));
+    }
+    return nodes[heap.top()].second;
+  }
+
+ private:
+  Ntk& ntk;
+  std::vector<signal_t> const& leaves;
+  std::vector<uint32_t> depths;
+  std::unordered_map<uint64_t, operand_t> sub_products;
+};
+
+}  // namespace detail
+
+/*! \brief Creates the signal of an RM term list over `leaves`. */
+template <class Ntk>
+signal<Ntk> rm_create_signal(Ntk& ntk, std::vector<rm_term> const& terms,
+                             std::vector<signal<Ntk>> const& leaves) {
+  detail::rm_signal_builder<Ntk> builder(ntk, leaves);
+  return builder.run(terms);
+}
+
+} /* namespace mockturtle */
@@ -0,0 +1,457 @@
+/* phyLS: powerful heightened yielded Logic Synthesis
+ * Copyright (C) 2023 */
+
+/**
+ * @file sta.hpp
+ *
+ * @brief Placement-aware static timing analysis of mapped networks
+ *
+ * @author Homyoung
+ * @since  2023/11/16
+ */
+
+#pragma once
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <mockturtle/algorithms/mapper.hpp>
+#include <mockturtle/networks/klut.hpp>
+#include <mockturtle/views/binding_view.hpp>
+
+#include "utils/parallel.hpp"
+
+namespace phyLS {
+
+/* how the delay of a wire from a driver to a sink pin is estimated */
+enum class wire_model {
+  none,  /* gate delays only */
+  hpwl,  /* every sink sees the lumped RC of the half-perimeter of its net */
+  elmore /* star net, Elmore delay of the Manhattan path to each sink */
+};
+
+/*! \brief Parses "none", "hpwl" or "elmore". */
+inline bool parse_wire_model(std::string const& name, wire_model& model) {
+  if (name == "none") {
+    model = wire_model::none;
+  } else if (name == "hpwl") {
+    model = wire_model::hpwl;
+  } else if (name == "elmore") {
+    model = wire_model::elmore;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+struct sta_params {
+  wire_model wires{wire_model::elmore};
+  double resistance{0.0};  /* wire resistance per placement unit */
+  double capacitance{0.0}; /* wire capacitance per placement unit */
+  double required_time{0.0}; /* at the outputs, 0 uses the worst arrival */
+  uint32_t num_threads{1u};  /* 0 uses all cores */
+};
+
+/*! \brief Static timing analysis of a mapped network with placed cells.
+ *
+ * Gate delays come from the genlib pins of the bound gates, a pin has the
+ * larger of its rise and fall delays, each the block delay plus the fanout
+ * delay times the load of the gate.  The load is the input load of all sink
+ * pins plus the capacitance of the wires of the net.  Wire delays between a
+ * driver and its sinks follow `sta_params::wires`.
+ *
+ * `positions` is indexed by node index, the pins of the outputs may follow
+ * at index `ntk.size() + i` as in the placement of the subject graph.  Nodes
+ * without position get no wires.  Nodes must be stored in topological
+ * order, as all mappers create them.
+ *
+ * Arrival and required times are propagated level by level, the nodes of a
+ * level on several threads.  No ABC data is touched, so independent
+ * analyses may run concurrently.
+ */
+template <class Ntk = mockturtle::binding_view<mockturtle::klut_network>>
+class static_timing {
+ public:
+  using node = typename Ntk::node;
+
+  static_timing(Ntk const& ntk,
+                std::vector<mockturtle::node_position> const& positions,
+                sta_params const& ps = {})
+      : ntk(ntk), positions(positions), ps(ps) {
+    build();
+  }
+
+  /*! \brief Computes arrival, required times and slacks. */
+  void run() {
+    compute_loads();
+    compute_arcs();
+    propagate_arrival();
+    propagate_required();
+  }
+
+  /*! \brief Worst arrival time over all outputs. */
+  double delay() const { return worst_arrival; }
+
+  /*! \brief Total area of the bound gates. */
+  double area() const { return total_area; }
+
+  double arrival(node const& n) const {
+    return arrivals[ntk.node_to_index(n)];
+  }
+
+  /*! \brief Required time, infinite for nodes not driving an output. */
+  double required(node const& n) const {
+    return requireds[ntk.node_to_index(n)];
+  }
+
+  double slack(node const& n) const {
+    auto const index = ntk.node_to_index(n);
+    return requireds[index] - arrivals[index];
+  }
+
+  /*! \brief Required time at the outputs. */
+  double target() const { return target_time; }
+
+  /*! \brief Smallest slack over all outputs. */
+  double worst_slack() const { return wns; }
+
+  /*! \brief Sum of the negative slacks of the outputs. */
+  double total_negative_slack() const { return tns; }
+
+  /*! \brief Nodes of the critical path, from an input to the driver of the
+   * latest output. */
+  std::vector<node> critical_path() const {
+    std::vector<node> path;
+    if (worst_output == no_node) return path;
+
+    for (auto v = worst_output; v != no_node;) {
+      path.push_back(ntk.index_to_node(v));
+      auto next = no_node;
+      double latest = std::numeric_limits<double>::lowest();
+      for (auto a = arc_offsets[v]; a < arc_offsets[v + 1]; ++a) {
+        auto const t = arrivals[arc_from[a]] + arc_delay[a];
+        if (t > latest) {
+          latest = t;
+          next = arc_from[a];
+        }
+      }
+      v = next;
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+  }
+
+  /*! \brief Prints the summary and the critical path. */
+  void report(std::ostream& os = std::cout) const {
+    os << fmt::format(
+        "[i] STA: delay = {:.2f}, area = {:.2f}, WNS = {:.2f}, TNS = {:.2f} "
+        "(required time {:.2f})\n",
+        worst_arrival, total_area, wns, tns, target_time);
+
+    auto const path = critical_path();
+    if (path.empty()) return;
+    os << fmt::format("[i] critical path of {} nodes:\n", path.size());
+    os << fmt::format("    {:>8} {:>16} {:>12} {:>12}\n", "node", "gate",
+                      "arrival", "slack");
+    for (auto const& n : path) {
+      std::string gate = ntk.is_ci(n) ? "input" : "-";
+      if (!ntk.is_ci(n) && !ntk.is_constant(n) && ntk.has_binding(n))
+        gate = ntk.get_binding(n).name;
+      os << fmt::format("    {:>8} {:>16} {:>12.2f} {:>12.2f}\n",
+                        ntk.node_to_index(n), gate, arrival(n), slack(n));
+    }
+  }
+
+ private:
+  static constexpr uint32_t no_node = std::numeric_limits<uint32_t>::max();
+  static constexpr double infinity = std::numeric_limits<double>::max();
+
+  struct output {
+    uint32_t driver;
+    uint32_t index;
+    double wire; /* wire delay from the driver to the output pin */
+  };
+
+  /* levels, fanin arcs and fanouts, which only depend on the network */
+  void build() {
+    auto const size = ntk.size();
+    std::vector<uint32_t> level(size, 0u);
+    uint32_t depth = 0u;
+
+    arc_offsets.assign(size + 1u, 0u);
+    std::vector<uint32_t> num_fanouts(size, 0u);
+    ntk.foreach_gate([&](auto const& n) {
+      auto const index = ntk.node_to_index(n);
+      arc_offsets[index + 1u] = ntk.fanin_size(n);
+      ntk.foreach_fanin(n, [&](auto const& f) {
+        auto const from = ntk.node_to_index(ntk.get_node(f));
+        level[index] = std::max(level[index], level[from] + 1u);
+        ++num_fanouts[from];
+      });
+      depth = std::max(depth, level[index]);
+    });
+    for (auto i = 0u; i < size; ++i) arc_offsets[i + 1u] += arc_offsets[i];
+
+    arc_from.resize(arc_offsets.back());
+    arc_sink.resize(arc_offsets.back());
+    arc_delay.assign(arc_offsets.back(), 0.0);
+    ntk.foreach_gate([&](auto const& n) {
+      auto const index = ntk.node_to_index(n);
+      auto a = arc_offsets[index];
+      ntk.foreach_fanin(n, [&](auto const& f) {
+        arc_from[a] = ntk.node_to_index(ntk.get_node(f));
+        arc_sink[a++] = index;
+      });
+    });
+
+    fanout_offsets.assign(size + 1u, 0u);
+    for (auto i = 0u; i < size; ++i)
+      fanout_offsets[i + 1u] = fanout_offsets[i] + num_fanouts[i];
+    fanout_arcs.resize(fanout_offsets.back());
+    std::vector<uint32_t> next(fanout_offsets.begin(), fanout_offsets.end() - 1);
+    for (auto a = 0u; a < arc_from.size(); ++a)
+      fanout_arcs[next[arc_from[a]]++] = a;
+
+    outputs.clear();
+    ntk.foreach_po([&](auto const& f, auto i) {
+      outputs.push_back({ntk.node_to_index(ntk.get_node(f)),
+                         static_cast<uint32_t>(i), 0.0});
+    });
+    output_offsets.assign(size + 1u, 0u);
+    for (auto const& o : outputs) ++output_offsets[o.driver + 1u];
+    for (auto i = 0u; i < size; ++i)
+      output_offsets[i + 1u] += output_offsets[i];
+    output_order.resize(outputs.size());
+    next.assign(output_offsets.begin(), output_offsets.end() - 1);
+    for (auto i = 0u; i < outputs.size(); ++i)
+      output_order[next[outputs[i].driver]++] = i;
+
+    level_offsets.assign(depth + 2u, 0u);
+    for (auto i = 0u; i < size; ++i) ++level_offsets[level[i] + 1u];
+    for (auto l = 0u; l <= depth; ++l) level_offsets[l + 1u] += level_offsets[l];
+    level_order.resize(size);
+    next.assign(level_offsets.begin(), level_offsets.end() - 1);
+    for (auto i = 0u; i < size; ++i) level_order[next[level[i]]++] = i;
+
+    total_area = 0.0;
+    ntk.foreach_gate([&](auto const& n) {
+      if (ntk.has_binding(n)) total_area += ntk.get_binding(n).area;
+    });
+  }
+
+  bool has_position(uint32_t index) const { return index < positions.size(); }
+
+  bool has_output_position(output const& o) const {
+    return has_position(static_cast<uint32_t>(ntk.size()) + o.index);
+  }
+
+  mockturtle::node_position const& output_position(output const& o) const {
+    return positions[ntk.size() + o.index];
+  }
+
+  static double distance(mockturtle::node_position const& a,
+                         mockturtle::node_position const& b) {
+    return std::abs(static_cast<double>(a.x_coordinate) - b.x_coordinate) +
+           std::abs(static_cast<double>(a.y_coordinate) - b.y_coordinate);
+  }
+
+  double input_load(uint32_t a) const {
+    auto const n = ntk.index_to_node(arc_sink[a]);
+    if (!ntk.has_binding(n)) return 0.0;
+    auto const& pins = ntk.get_binding(n).pins;
+    auto const pin = a - arc_offsets[arc_sink[a]];
+    return pin < pins.size() ? pins[pin].input_load : 0.0;
+  }
+
+  /* half-perimeter of the net driven by `v` */
+  double net_hpwl(uint32_t v) const {
+    if (!has_position(v)) return 0.0;
+    double x_min = positions[v].x_coordinate, x_max = x_min;
+    double y_min = positions[v].y_coordinate, y_max = y_min;
+    auto const extend = [&](mockturtle::node_position const& p) {
+      x_min = std::min<double>(x_min, p.x_coordinate);
+      x_max = std::max<double>(x_max, p.x_coordinate);
+      y_min = std::min<double>(y_min, p.y_coordinate);
+      y_max = std::max<double>(y_max, p.y_coordinate);
+    };
+    for (auto i = fanout_offsets[v]; i < fanout_offsets[v + 1u]; ++i) {
+      auto const sink = arc_sink[fanout_arcs[i]];
+      if (has_position(sink)) extend(positions[sink]);
+    }
+    for (auto i = output_offsets[v]; i < output_offsets[v + 1u]; ++i) {
+      auto const& o = outputs[output_order[i]];
+      if (has_output_position(o)) extend(output_position(o));
+    }
+    return (x_max - x_min) + (y_max - y_min);
+  }
+
+  /* wire length seen from the driver, and from the driver to one sink */
+  double net_length(uint32_t v) const {
+    if (ps.wires == wire_model::hpwl) return net_hpwl(v);
+    if (ps.wires == wire_model::none || !has_position(v)) return 0.0;
+
+    double length = 0.0;
+    for (auto i = fanout_offsets[v]; i < fanout_offsets[v + 1u]; ++i) {
+      auto const sink = arc_sink[fanout_arcs[i]];
+      if (has_position(sink)) length += distance(positions[v], positions[sink]);
+    }
+    for (auto i = output_offsets[v]; i < output_offsets[v + 1u]; ++i) {
+      auto const& o = outputs[output_order[i]];
+      if (has_output_position(o))
+        length += distance(positions[v], output_position(o));
+    }
+    return length;
+  }
+
+  double wire_delay(uint32_t v, double length, double pin_load) const {
+    if (ps.wires == wire_model::hpwl) length = nets[v];
+    return ps.resistance * length *
+           (0.5 * ps.capacitance * length + pin_load);
+  }
+
+  void compute_loads() {
+    auto const size = ntk.size();
+    loads.assign(size, 0.0);
+    nets.assign(size, 0.0);
+    run_parallel(0u, size, [&](uint64_t v) {
+      double load = 0.0;
+      for (auto i = fanout_offsets[v]; i < fanout_offsets[v + 1u]; ++i)
+        load += input_load(fanout_arcs[i]);
+      nets[v] = net_length(static_cast<uint32_t>(v));
+      loads[v] = load + ps.capacitance * nets[v];
+    });
+  }
+
+  void compute_arcs() {
+    run_parallel(0u, ntk.size(), [&](uint64_t g) {
+      if (arc_offsets[g] == arc_offsets[g + 1u]) return;
+      auto const n = ntk.index_to_node(g);
+      auto const* gate = ntk.has_binding(n) ? &ntk.get_binding(n) : nullptr;
+
+      for (auto a = arc_offsets[g]; a < arc_offsets[g + 1u]; ++a) {
+        auto const pin = a - arc_offsets[g];
+        double cell = 0.0, pin_load = 0.0;
+        if (gate != nullptr && pin < gate->pins.size()) {
+          auto const& p = gate->pins[pin];
+          cell = std::max(p.rise_block_delay + p.rise_fanout_delay * loads[g],
+                          p.fall_block_delay + p.fall_fanout_delay * loads[g]);
+          pin_load = p.input_load;
+        }
+
+        double wire = 0.0;
+        auto const from = arc_from[a];
+        if (ps.wires != wire_model::none && has_position(from) &&
+            has_position(g))
+          wire = wire_delay(from, distance(positions[from], positions[g]),
+                            pin_load);
+        arc_delay[a] = wire + cell;
+      }
+    });
+
+    for (auto& o : outputs) {
+      o.wire = 0.0;
+      if (ps.wires != wire_model::none && has_position(o.driver) &&
+          has_output_position(o))
+        o.wire = wire_delay(o.driver,
+                            distance(positions[o.driver], output_position(o)),
+                            0.0);
+    }
+  }
+
+  void propagate_arrival() {
+    arrivals.assign(ntk.size(), 0.0);
+    for (auto l = 0u; l + 1u < level_offsets.size(); ++l) {
+      run_parallel(level_offsets[l], level_offsets[l + 1u], [&](uint64_t i) {
+        auto const v = level_order[i];
+        double t = 0.0;
+        for (auto a = arc_offsets[v]; a < arc_offsets[v + 1u]; ++a)
+          t = std::max(t, arrivals[arc_from[a]] + arc_delay[a]);
+        arrivals[v] = t;
+      });
+    }
+
+    worst_arrival = 0.0;
+    worst_output = no_node;
+    for (auto const& o : outputs) {
+      auto const t = arrivals[o.driver] + o.wire;
+      if (worst_output == no_node || t > worst_arrival) {
+        worst_arrival = t;
+        worst_output = o.driver;
+      }
+    }
+  }
+
+  void propagate_required() {
+    target_time = ps.required_time > 0.0 ? ps.required_time : worst_arrival;
+    requireds.assign(ntk.size(), infinity);
+    for (auto l = level_offsets.size() - 1u; l-- > 0u;) {
+      run_parallel(level_offsets[l], level_offsets[l + 1u], [&](uint64_t i) {
+        auto const v = level_order[i];
+        double t = infinity;
+        for (auto j = output_offsets[v]; j < output_offsets[v + 1u]; ++j)
+          t = std::min(t, target_time - outputs[output_order[j]].wire);
+        for (auto j = fanout_offsets[v]; j < fanout_offsets[v + 1u]; ++j) {
+          auto const a = fanout_arcs[j];
+          if (requireds[arc_sink[a]] != infinity)
+            t = std::min(t, requireds[arc_sink[a]] - arc_delay[a]);
+        }
+        requireds[v] = t;
+      });
+    }
+
+    wns = outputs.empty() ? 0.0 : infinity;
+    tns = 0.0;
+    for (auto const& o : outputs) {
+      auto const s = target_time - (arrivals[o.driver] + o.wire);
+      wns = std::min(wns, s);
+      if (s < 0.0) tns += s;
+    }
+  }
+
+  template <typename Fn>
+  void run_parallel(uint64_t begin, uint64_t end, Fn&& fn) const {
+    parallel_for(ps.num_threads, begin, end,
+                 [&](uint64_t i, uint32_t) { fn(i); }, 256u);
+  }
+
+  Ntk const& ntk;
+  std::vector<mockturtle::node_position> const& positions;
+  sta_params ps;
+
+  /* fanin arcs of node v are [arc_offsets[v], arc_offsets[v + 1]) */
+  std::vector<uint32_t> arc_offsets;
+  std::vector<uint32_t> arc_from;
+  std::vector<uint32_t> arc_sink;
+  std::vector<double> arc_delay;
+  /* arcs leaving node v */
+  std::vector<uint32_t> fanout_offsets;
+  std::vector<uint32_t> fanout_arcs;
+  /* outputs driven by node v */
+  std::vector<output> outputs;
+  std::vector<uint32_t> output_offsets;
+  std::vector<uint32_t> output_order;
+  /* nodes grouped by level */
+  std::vector<uint32_t> level_order;
+  std::vector<uint32_t> level_offsets;
+
+  std::vector<double> loads;
+  std::vector<double> nets; /* wire length of the net of each node */
+  std::vector<double> arrivals;
+  std::vector<double> requireds;
+
+  double total_area{0.0};
+  double worst_arrival{0.0};
+  double target_time{0.0};
+  double wns{0.0};
+  double tns{0.0};
+  uint32_t worst_output{no_node};
+};
+
+}  // namespace phyLS
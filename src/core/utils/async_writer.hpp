@@ -0,0 +1,183 @@
+/* phyLS: powerful heightened yielded Logic Synthesis
+ * Copyright (C) 2023 */
+
+/**
+ * @file async_writer.hpp
+ *
+ * @brief Writes result files on a background thread
+ *
+ * @author Homyoung
+ * @since  2023/11/16
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef PHYLS_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace phyLS {
+
+/*! \brief Bounded queue of files written by one background thread.
+ *
+ * A write is given as a function printing the file content to a stream; it
+ * runs on the writer thread, so everything it captures must stay unchanged
+ * until it has run.  A pending write of the same file is replaced instead of
+ * queued twice.  When the queue is full, droppable writes are discarded and
+ * other writes evict the oldest droppable one, so the caller only waits if
+ * the queue is full of writes that must not be lost.
+ *
+ * With compression, files get a `.gz` suffix and are written with zlib if
+ * phyLS is built with PHYLS_HAVE_ZLIB, and uncompressed otherwise.
+ */
+class async_writer {
+ public:
+  using content_fn = std::function<void(std::ostream&)>;
+
+  explicit async_writer(size_t capacity = 16u, bool compress = false)
+      : capacity(capacity == 0u ? 1u : capacity), compress(compress) {
+#ifndef PHYLS_HAVE_ZLIB
+    if (compress) {
+      std::cerr << "[w] phyLS is built without zlib, results are written "
+                   "uncompressed\n";
+      this->compress = false;
+    }
+#endif
+    worker = std::thread([this] { run(); });
+  }
+
+  async_writer(async_writer const&) = delete;
+  async_writer& operator=(async_writer const&) = delete;
+
+  /*! \brief Writes all pending files before returning. */
+  ~async_writer() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    has_jobs.notify_one();
+    worker.join();
+  }
+
+  /*! \brief Queues a write of `filename`. */
+  void write(std::string filename, content_fn content, bool droppable) {
+    if (compress) filename += ".gz";
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (auto& pending : jobs) {
+      if (pending.filename == filename) {
+        pending.content = std::move(content);
+        pending.droppable = pending.droppable && droppable;
+        return;
+      }
+    }
+
+    while (jobs.size() >= capacity) {
+      if (droppable) {
+        ++dropped;
+        return;
+      }
+      bool evicted = false;
+      for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+        if (it->droppable) {
+          jobs.erase(it);
+          ++dropped;
+          evicted = true;
+          break;
+        }
+      }
+      if (!evicted) has_space.wait(lock);
+    }
+
+    jobs.push_back({std::move(filename), std::move(content), droppable});
+    lock.unlock();
+    has_jobs.notify_one();
+  }
+
+  /*! \brief Waits until all queued files are written. */
+  void flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return jobs.empty() && !busy; });
+  }
+
+  uint64_t num_written() const { return written; }
+  uint64_t num_dropped() const { return dropped; }
+
+ private:
+  struct job {
+    std::string filename;
+    content_fn content;
+    bool droppable;
+  };
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      has_jobs.wait(lock, [this] { return stop || !jobs.empty(); });
+      if (jobs.empty()) break; /* stopped and drained */
+
+      auto current = std::move(jobs.front());
+      jobs.pop_front();
+      busy = true;
+      lock.unlock();
+      has_space.notify_one();
+
+      std::ostringstream text;
+      current.content(text);
+      if (store(current.filename, text.str())) {
+        ++written;
+      } else {
+        std::cerr << "[w] cannot write " << current.filename << "\n";
+      }
+
+      lock.lock();
+      busy = false;
+      if (jobs.empty()) idle.notify_all();
+    }
+  }
+
+  bool store(std::string const& filename, std::string const& text) const {
+#ifdef PHYLS_HAVE_ZLIB
+    if (compress) {
+      gzFile file = gzopen(filename.c_str(), "wb");
+      if (file == nullptr) return false;
+      bool const ok =
+          text.empty() || gzwrite(file, text.data(),
+                                  static_cast<unsigned>(text.size())) > 0;
+      return gzclose(file) == Z_OK && ok;
+    }
+#endif
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) return false;
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    return static_cast<bool>(out);
+  }
+
+  size_t capacity;
+  bool compress;
+  std::deque<job> jobs;
+  std::mutex mutex;
+  std::condition_variable has_jobs;
+  std::condition_variable has_space;
+  std::condition_variable idle;
+  bool busy{false};
+  bool stop{false};
+  std::atomic<uint64_t> written{0u};
+  std::atomic<uint64_t> dropped{0u};
+  std::thread worker;
+};
+
+}  // namespace phyLS
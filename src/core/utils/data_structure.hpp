@@ -1,5 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 
@@ -82,5 +87,52 @@ struct index_cut_supergate {
     }
   };
 };
+
+/* Max-priority queue over a fixed set of items with respect to Compare, the
+ * top is the element a std::multiset<T, Compare> would keep last.  The items
+ * are sorted once into an immutable array that all copies share, a copy only
+ * holds its read position, so copying a queue costs O(1). */
+template <typename T, typename Compare>
+class shared_sorted_queue {
+public:
+  /* replaces the content by items in O(n log n) */
+  void assign(std::vector<T> const& items) {
+    auto sorted = std::make_shared<std::vector<T>>(items);
+    /* Compare may be non-strict, only its strict part orders the items */
+    std::stable_sort(sorted->begin(), sorted->end(), [this](T const& a, T const& b) {
+      return comp(b, a) && !comp(a, b);
+    });
+    data = std::move(sorted);
+    head = 0u;
+  }
+
+  /* puts back all popped elements */
+  void rewind() { head = 0u; }
+
+  /* removes up to count elements from the top and appends those accepted by
+   * is_valid to out, largest first; stale elements are dropped here instead
+   * of being searched for when they become stale */
+  template <typename Valid>
+  void pop_top(size_t count, Valid&& is_valid, std::vector<T>& out) {
+    for (; count > 0u && head < size_total(); --count, ++head)
+      if (is_valid((*data)[head])) out.push_back((*data)[head]);
+  }
+
+  T const& top() const { return (*data)[head]; }
+  size_t size() const { return size_total() - head; }
+  bool empty() const { return size() == 0u; }
+  void clear() {
+    data.reset();
+    head = 0u;
+  }
+
+private:
+  size_t size_total() const { return data ? data->size() : 0u; }
+
+  std::shared_ptr<const std::vector<T>> data;
+  size_t head{0u};
+  Compare comp;
+};
+
 } // namespace mockturtle
 
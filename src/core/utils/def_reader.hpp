@@ -0,0 +1,270 @@
+/* phyLS: powerful heightened yielded Logic Synthesis
+ * Copyright (C) 2023 */
+
+/**
+ * @file def_reader.hpp
+ *
+ * @brief Fast reader for the COMPONENTS and PINS sections of DEF files
+ *
+ * @author Homyoung
+ * @since  2023/11/16
+ */
+
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PHYLS_DEF_READER_MMAP 1
+#endif
+
+namespace phyLS {
+
+/*! \brief Read-only view of a whole file, memory mapped where possible. */
+class mapped_file {
+ public:
+  mapped_file() = default;
+  mapped_file(mapped_file const&) = delete;
+  mapped_file& operator=(mapped_file const&) = delete;
+  ~mapped_file() { close(); }
+
+  bool open(std::string const& filename) {
+    close();
+#ifdef PHYLS_DEF_READER_MMAP
+    int const fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                          MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        ::madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        mapped = static_cast<char const*>(addr);
+        length = static_cast<size_t>(st.st_size);
+        ::close(fd);
+        return true;
+      }
+    }
+    ::close(fd);
+#endif
+    /* empty files, pipes and platforms without mmap */
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) return false;
+    buffer.assign(std::istreambuf_iterator<char>(in),
+                  std::istreambuf_iterator<char>());
+    return true;
+  }
+
+  std::string_view view() const {
+    return mapped ? std::string_view(mapped, length)
+                  : std::string_view(buffer);
+  }
+
+ private:
+  void close() {
+#ifdef PHYLS_DEF_READER_MMAP
+    if (mapped) ::munmap(const_cast<char*>(mapped), length);
+#endif
+    mapped = nullptr;
+    length = 0u;
+    buffer.clear();
+  }
+
+  char const* mapped{nullptr};
+  size_t length{0u};
+  std::string buffer;
+};
+
+enum class def_direction : uint8_t { none, input, output, inout, feedthru };
+
+/*! \brief A component; `name` and `macro` point into the mapped file. */
+struct def_component {
+  std::string_view name;
+  std::string_view macro;
+  int32_t x{0};
+  int32_t y{0};
+  bool placed{false}; /* PLACED, FIXED or COVER */
+};
+
+/*! \brief An I/O pin; `name` points into the mapped file. */
+struct def_pin {
+  std::string_view name;
+  def_direction direction{def_direction::none};
+  int32_t x{0};
+  int32_t y{0};
+  bool placed{false};
+};
+
+/*! \brief Components and pins of a DEF file.
+ *
+ * The file is memory mapped and tokenized in place, numbers are converted
+ * with `std::from_chars`, and no string is copied, so the names stay valid
+ * as long as the reader lives.  Sections are recognized by their keyword at
+ * the start of a line, all other sections are skipped line by line.
+ */
+class def_reader {
+ public:
+  /*! \brief Reads `filename`, returns false if it cannot be opened. */
+  bool read(std::string const& filename) {
+    comps.clear();
+    pin_list.clear();
+    if (!file.open(filename)) return false;
+
+    text = file.view();
+    pos = 0u;
+    while (pos < text.size()) {
+      auto const keyword = line_keyword();
+      if (keyword == "COMPONENTS") {
+        read_components();
+      } else if (keyword == "PINS") {
+        read_pins();
+      } else {
+        skip_line();
+      }
+    }
+    return true;
+  }
+
+  std::vector<def_component> const& components() const { return comps; }
+  std::vector<def_pin> const& pins() const { return pin_list; }
+
+ private:
+  static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+  }
+
+  /* first token of the current line, the cursor is left behind it */
+  std::string_view line_keyword() {
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t')) ++pos;
+    return next_token();
+  }
+
+  void skip_line() {
+    auto const* nl = static_cast<char const*>(
+        std::memchr(text.data() + pos, '\n', text.size() - pos));
+    pos = nl ? static_cast<size_t>(nl - text.data()) + 1u : text.size();
+  }
+
+  std::string_view next_token() {
+    while (pos < text.size() && is_space(text[pos])) ++pos;
+    auto const begin = pos;
+    while (pos < text.size() && !is_space(text[pos])) ++pos;
+    return text.substr(begin, pos - begin);
+  }
+
+  static bool ends_statement(std::string_view token) {
+    return !token.empty() && token.back() == ';';
+  }
+
+  /* parses `( x y )` following PLACED, FIXED or COVER */
+  bool read_point(int32_t& x, int32_t& y) {
+    auto const read_coordinate = [&](int32_t& value) {
+      while (pos < text.size() && (is_space(text[pos]) || text[pos] == '('))
+        ++pos;
+      auto const* first = text.data() + pos;
+      auto const [ptr, ec] =
+          std::from_chars(first, text.data() + text.size(), value);
+      pos += static_cast<size_t>(ptr - first);
+      return ec == std::errc();
+    };
+    if (!read_coordinate(x) || !read_coordinate(y)) return false;
+    while (pos < text.size() && is_space(text[pos])) ++pos;
+    if (pos < text.size() && text[pos] == ')') ++pos;
+    return true;
+  }
+
+  /* count of a section header, the cursor is moved to the next line */
+  size_t section_count() {
+    auto const token = next_token();
+    size_t count = 0u;
+    std::from_chars(token.data(), token.data() + token.size(), count);
+    skip_line();
+    return count;
+  }
+
+  static bool is_placement(std::string_view token) {
+    return token == "PLACED" || token == "FIXED" || token == "COVER";
+  }
+
+  /* skips to the first `-` of a record, false at the END of the section */
+  bool next_record() {
+    while (pos < text.size()) {
+      auto const token = next_token();
+      if (token == "-") return true;
+      if (token == "END") {
+        skip_line();
+        return false;
+      }
+    }
+    return false;
+  }
+
+  void read_components() {
+    comps.reserve(section_count()); /* COMPONENTS <count> ; */
+    while (next_record()) {
+      def_component c;
+      c.name = next_token();
+      c.macro = next_token();
+      for (auto token = c.macro; !ends_statement(token) && pos < text.size();) {
+        token = next_token();
+        if (!c.placed && is_placement(token))
+          c.placed = read_point(c.x, c.y);
+      }
+      comps.push_back(c);
+    }
+  }
+
+  void read_pins() {
+    pin_list.reserve(section_count()); /* PINS <count> ; */
+    while (next_record()) {
+      def_pin p;
+      p.name = next_token();
+      for (auto token = p.name; !ends_statement(token) && pos < text.size();) {
+        token = next_token();
+        if (token == "DIRECTION") {
+          auto const dir = next_token();
+          if (dir.rfind("INPUT", 0) == 0) {
+            p.direction = def_direction::input;
+          } else if (dir.rfind("OUTPUT", 0) == 0) {
+            p.direction = def_direction::output;
+          } else if (dir.rfind("INOUT", 0) == 0) {
+            p.direction = def_direction::inout;
+          } else if (dir.rfind("FEEDTHRU", 0) == 0) {
+            p.direction = def_direction::feedthru;
+          }
+          token = dir;
+        } else if (!p.placed && is_placement(token)) {
+          p.placed = read_point(p.x, p.y);
+        }
+      }
+      pin_list.push_back(p);
+    }
+  }
+
+  mapped_file file;
+  std::string_view text;
+  size_t pos{0u};
+  std::vector<def_component> comps;
+  std::vector<def_pin> pin_list;
+};
+
+/*! \brief Value of the first run of digits in `name`, -1 if there is none. */
+inline int def_name_index(std::string_view name, size_t from = 0u) {
+  auto const first = name.find_first_of("0123456789", from);
+  if (first == std::string_view::npos) return -1;
+  int value = -1;
+  std::from_chars(name.data() + first, name.data() + name.size(), value);
+  return value;
+}
+
+}  // namespace phyLS
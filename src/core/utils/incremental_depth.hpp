@@ -0,0 +1,136 @@
+/* phyLS: powerful heightened yielded Logic Synthesis
+ * Copyright (C) 2023 */
+
+/**
+ * @file incremental_depth.hpp
+ *
+ * @brief Incremental levels and critical paths for depth rewriting
+ *
+ * @author Homyoung
+ * @since  2023/11/16
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include <mockturtle/networks/events.hpp>
+#include <mockturtle/traits.hpp>
+
+namespace mockturtle
+{
+
+/*! \brief Incremental level maintenance for depth rewriting.
+ *
+ * Keeps the levels of a `depth_view` up to date after `substitute_node` by
+ * only revisiting the transitive fanout of nodes whose fanins changed,
+ * instead of recomputing all levels with `update_levels`.  The network must
+ * provide fanouts (e.g., `fanout_view<depth_view<Ntk>>`) and the depth view
+ * must use unit cost without counting complemented edges.
+ *
+ * Levels of new nodes are assigned by the depth view itself when they are
+ * created, modified nodes are collected through the network events and
+ * propagated in ascending level order when calling `update`.
+ */
+template<class Ntk>
+class incremental_depth
+{
+public:
+  using node = typename Ntk::node;
+
+  explicit incremental_depth( Ntk& ntk )
+      : ntk( ntk )
+  {
+    static_assert( has_foreach_fanout_v<Ntk>, "Ntk does not implement the foreach_fanout method" );
+    static_assert( has_level_v<Ntk>, "Ntk does not implement the level method" );
+
+    modified_event = ntk.events().register_modified_event( [this]( auto const& n, auto const& previous ) {
+      (void)previous;
+      dirty.push_back( n );
+    } );
+  }
+
+  ~incremental_depth()
+  {
+    ntk.events().release_modified_event( modified_event );
+  }
+
+  incremental_depth( incremental_depth const& ) = delete;
+  incremental_depth& operator=( incremental_depth const& ) = delete;
+
+  /*! \brief Propagates level changes of all nodes modified since the last call. */
+  void update()
+  {
+    /* outputs may have been redirected without modifying any node */
+    valid_depth = false;
+    ++updates;
+    if ( dirty.empty() )
+      return;
+
+    std::priority_queue<std::pair<uint32_t, node>, std::vector<std::pair<uint32_t, node>>, std::greater<>> queue;
+    for ( auto const& n : dirty )
+    {
+      queue.emplace( ntk.level( n ), n );
+    }
+    dirty.clear();
+
+    while ( !queue.empty() )
+    {
+      const auto n = queue.top().second;
+      queue.pop();
+
+      if ( ntk.is_dead( n ) || ntk.is_pi( n ) || ntk.is_constant( n ) )
+        continue;
+
+      uint32_t level{0};
+      ntk.foreach_fanin( n, [&]( auto const& f ) {
+        level = std::max( level, ntk.level( ntk.get_node( f ) ) );
+      } );
+      ++level;
+
+      if ( level == ntk.level( n ) )
+        continue;
+
+      ntk.set_level( n, level );
+      ntk.foreach_fanout( n, [&]( auto const& p ) {
+        queue.emplace( level, p );
+      } );
+    }
+  }
+
+  /*! \brief Current depth, recomputed from the outputs only after an update. */
+  uint32_t depth()
+  {
+    if ( !valid_depth )
+    {
+      current_depth = 0;
+      ntk.foreach_po( [this]( auto const& f ) {
+        current_depth = std::max( current_depth, ntk.level( ntk.get_node( f ) ) );
+      } );
+      valid_depth = true;
+    }
+    return current_depth;
+  }
+
+  /*! \brief Number of calls to `update`, i.e., of substitutions seen so far. */
+  uint64_t num_updates() const
+  {
+    return updates;
+  }
+
+private:
+  Ntk& ntk;
+  std::vector<node> dirty;
+  std::shared_ptr<typename network_events<Ntk>::modified_event_type> modified_event;
+  uint64_t updates{0};
+  uint32_t current_depth{0};
+  bool valid_depth{false};
+};
+
+} /* namespace mockturtle */
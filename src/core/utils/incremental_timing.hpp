@@ -0,0 +1,285 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace mockturtle
+{
+
+/*! \brief Timing arc from a fanin vertex. */
+struct timing_arc
+{
+  uint32_t from;
+  double delay;
+};
+
+/*! \brief Incremental arrival and required times of a cover.
+ *
+ * Vertices are the signals of a cover (e.g., one per node and phase), each
+ * driven by a gate given as its fanin arcs, a cost and a rank that must be
+ * larger than the ranks of its fanins.  Only vertices in the transitive
+ * fanin of the outputs are live, liveness is maintained by reference
+ * counting when drivers change.
+ *
+ * Changing a driver only schedules work: `update` re-propagates arrival
+ * times in rank order through the transitive fanout of the changed vertices
+ * and the downstream delay to the outputs (from which required times are
+ * derived for any target) in reverse rank order through their transitive
+ * fanin, stopping wherever a value does not change.
+ */
+class incremental_timing
+{
+public:
+  void reset( uint32_t num_vertices )
+  {
+    vertices.assign( num_vertices, vertex{} );
+    fanouts.assign( num_vertices, {} );
+    outputs.clear();
+    live_cost = 0.0;
+    evaluations = 0u;
+    arrival_queue = {};
+    down_queue = {};
+  }
+
+  /*! \brief Replaces the driver of `v`. */
+  void set_driver( uint32_t v, uint32_t rank, double cost, std::vector<timing_arc> fanins )
+  {
+    auto& data = vertices[v];
+    for ( auto const& arc : data.fanins )
+    {
+      erase_fanout( arc.from, v );
+      schedule_down( arc.from );
+    }
+    for ( auto const& arc : fanins )
+    {
+      fanouts[arc.from].push_back( v );
+      schedule_down( arc.from );
+    }
+
+    /* reference the new fanins first, shared cones then stay live */
+    auto const old_fanins = std::exchange( data.fanins, std::move( fanins ) );
+    if ( data.refs > 0 )
+    {
+      live_cost += cost - data.cost;
+      for ( auto const& arc : data.fanins )
+        ref( arc.from );
+      for ( auto const& arc : old_fanins )
+        deref( arc.from );
+    }
+    data.rank = rank;
+    data.cost = cost;
+
+    schedule_arrival( v );
+    schedule_down( v );
+  }
+
+  /*! \brief Marks `v` as an output, outputs may be added more than once. */
+  void add_output( uint32_t v )
+  {
+    outputs.push_back( v );
+    ++vertices[v].outputs;
+    ref( v );
+    schedule_down( v );
+  }
+
+  /*! \brief Propagates all changes since the last call. */
+  void update()
+  {
+    while ( !arrival_queue.empty() )
+    {
+      auto const v = arrival_queue.top().second;
+      arrival_queue.pop();
+      auto& data = vertices[v];
+      data.in_arrival_queue = false;
+      ++evaluations;
+
+      double arrival = 0.0;
+      for ( auto const& arc : data.fanins )
+        arrival = std::max( arrival, vertices[arc.from].arrival + arc.delay );
+      if ( arrival == data.arrival && data.arrival_valid )
+        continue;
+
+      data.arrival = arrival;
+      data.arrival_valid = true;
+      for ( auto const w : fanouts[v] )
+        schedule_arrival( w );
+    }
+
+    while ( !down_queue.empty() )
+    {
+      auto const v = down_queue.top().second;
+      down_queue.pop();
+      auto& data = vertices[v];
+      data.in_down_queue = false;
+      ++evaluations;
+
+      double down = unreachable;
+      if ( data.refs > 0 )
+      {
+        if ( data.outputs > 0 )
+          down = 0.0;
+        for ( auto const w : fanouts[v] )
+        {
+          auto const& fanout = vertices[w];
+          if ( fanout.refs == 0 )
+            continue;
+          for ( auto const& arc : fanout.fanins )
+          {
+            if ( arc.from == v )
+              down = std::max( down, fanout.down + arc.delay );
+          }
+        }
+      }
+      if ( down == data.down )
+        continue;
+
+      data.down = down;
+      for ( auto const& arc : data.fanins )
+        schedule_down( arc.from );
+    }
+  }
+
+  /*! \brief Worst arrival time over all outputs. */
+  double delay() const
+  {
+    double worst = 0.0;
+    for ( auto const v : outputs )
+      worst = std::max( worst, vertices[v].arrival );
+    return worst;
+  }
+
+  /*! \brief Total cost of the live vertices. */
+  double area() const
+  {
+    return live_cost;
+  }
+
+  double arrival( uint32_t v ) const
+  {
+    return vertices[v].arrival;
+  }
+
+  /*! \brief Required time of `v` for a target delay at the outputs. */
+  double required( uint32_t v, double target ) const
+  {
+    auto const down = vertices[v].down;
+    return down == unreachable ? std::numeric_limits<double>::max() : target - down;
+  }
+
+  bool is_live( uint32_t v ) const
+  {
+    return vertices[v].refs > 0;
+  }
+
+  /*! \brief Number of vertex evaluations so far, a measure of the work done. */
+  uint64_t num_evaluations() const
+  {
+    return evaluations;
+  }
+
+private:
+  static constexpr double unreachable = std::numeric_limits<double>::lowest();
+
+  struct vertex
+  {
+    std::vector<timing_arc> fanins;
+    double arrival{0.0};
+    double down{unreachable}; /* largest delay from the vertex to an output */
+    double cost{0.0};
+    uint32_t rank{0};
+    uint32_t refs{0};
+    uint32_t outputs{0};
+    bool arrival_valid{false};
+    bool in_arrival_queue{false};
+    bool in_down_queue{false};
+  };
+
+  void erase_fanout( uint32_t from, uint32_t v )
+  {
+    auto& list = fanouts[from];
+    auto const it = std::find( list.begin(), list.end(), v );
+    if ( it != list.end() )
+    {
+      *it = list.back();
+      list.pop_back();
+    }
+  }
+
+  void schedule_arrival( uint32_t v )
+  {
+    auto& data = vertices[v];
+    if ( data.in_arrival_queue )
+      return;
+    data.in_arrival_queue = true;
+    arrival_queue.emplace( data.rank, v );
+  }
+
+  void schedule_down( uint32_t v )
+  {
+    auto& data = vertices[v];
+    if ( data.in_down_queue )
+      return;
+    data.in_down_queue = true;
+    down_queue.emplace( data.rank, v );
+  }
+
+  /* references `v`, its fanins become live when it does */
+  void ref( uint32_t v )
+  {
+    std::vector<uint32_t> stack{ v };
+    while ( !stack.empty() )
+    {
+      auto const u = stack.back();
+      stack.pop_back();
+      auto& data = vertices[u];
+      if ( data.refs++ > 0 )
+        continue;
+
+      live_cost += data.cost;
+      schedule_down( u );
+      for ( auto const& arc : data.fanins )
+      {
+        schedule_down( arc.from );
+        stack.push_back( arc.from );
+      }
+    }
+  }
+
+  /* dereferences `v`, its fanins are released when it becomes dead */
+  void deref( uint32_t v )
+  {
+    std::vector<uint32_t> stack{ v };
+    while ( !stack.empty() )
+    {
+      auto const u = stack.back();
+      stack.pop_back();
+      auto& data = vertices[u];
+      if ( --data.refs > 0 )
+        continue;
+
+      live_cost -= data.cost;
+      schedule_down( u );
+      for ( auto const& arc : data.fanins )
+      {
+        schedule_down( arc.from );
+        stack.push_back( arc.from );
+      }
+    }
+  }
+
+  std::vector<vertex> vertices;
+  std::vector<std::vector<uint32_t>> fanouts;
+  std::vector<uint32_t> outputs;
+  double live_cost{0.0};
+  uint64_t evaluations{0u};
+
+  std::priority_queue<std::pair<uint32_t, uint32_t>, std::vector<std::pair<uint32_t, uint32_t>>, std::greater<>> arrival_queue;
+  std::priority_queue<std::pair<uint32_t, uint32_t>> down_queue;
+};
+
+} /* namespace mockturtle */
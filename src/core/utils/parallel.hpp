@@ -0,0 +1,79 @@
+/* phyLS: powerful heightened yielded Logic Synthesis
+ * Copyright (C) 2023 */
+
+/**
+ * @file parallel.hpp
+ *
+ * @brief Minimal helpers for running independent work items on threads
+ *
+ * @author Homyoung
+ * @since  2023/11/16
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace phyLS {
+
+/*! \brief Resolves a user supplied thread count, 0 means all cores. */
+inline uint32_t resolve_num_threads(uint32_t num_threads) {
+  if (num_threads != 0u) return num_threads;
+  auto const hw = std::thread::hardware_concurrency();
+  return hw == 0u ? 1u : hw;
+}
+
+/*! \brief Calls `fn(i, thread_id)` for every `i` in `[begin, end)`.
+ *
+ * Indices are handed out in chunks of `chunk` from a shared counter, so the
+ * order in which they are processed is not specified.  `fn` must only write
+ * to data owned by index `i` or by `thread_id` to keep results deterministic.
+ * With a single thread the loop runs on the calling thread.  The first
+ * exception thrown by a worker is rethrown after all workers have joined.
+ */
+template <typename Fn>
+void parallel_for(uint32_t num_threads, uint64_t begin, uint64_t end, Fn&& fn,
+                  uint64_t chunk = 64u) {
+  if (begin >= end) return;
+  num_threads = std::min<uint64_t>(resolve_num_threads(num_threads),
+                                   (end - begin + chunk - 1u) / chunk);
+  if (num_threads <= 1u) {
+    for (auto i = begin; i < end; ++i) fn(i, 0u);
+    return;
+  }
+
+  std::atomic<uint64_t> next{begin};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+
+  auto worker = [&](uint32_t thread_id) {
+    try {
+      while (true) {
+        auto const first = next.fetch_add(chunk);
+        if (first >= end) break;
+        auto const last = std::min(first + chunk, end);
+        for (auto i = first; i < last; ++i) fn(i, thread_id);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error) error = std::current_exception();
+      next = end;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1u);
+  for (auto t = 1u; t < num_threads; ++t) threads.emplace_back(worker, t);
+  worker(0u);
+  for (auto& t : threads) t.join();
+
+  if (error) std::rethrow_exception(error);
+}
+
+}  // namespace phyLS
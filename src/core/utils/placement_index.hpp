@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <mockturtle/algorithms/mapper.hpp>
+
+namespace mockturtle {
+/* Placement of the subject graph for placement-aware matching.
+ *
+ * Coordinates are kept as structure of arrays. The centroid and bounding box
+ * of the pins of a cut only depend on the cut, so they are computed once
+ * when the cut is matched. The geometries of
+ * the matched cuts of a node are stored contiguously in match order, so a
+ * cut is found by its node and the `match_index` in its cut data. The cache
+ * is filled before matching and only read while matching, so lookups may
+ * run concurrently.
+ */
+class placement_index {
+public:
+  struct cut_geometry {
+    node_position centroid{0, 0}; /* of the pins */
+    double x_min{0};
+    double y_min{0};
+    double x_max{0};
+    double y_max{0};
+  };
+
+  placement_index() = default;
+
+  explicit placement_index(std::vector<node_position> const& np) { reset(np); }
+
+  void reset(std::vector<node_position> const& np) {
+    xs.resize(np.size());
+    ys.resize(np.size());
+    for (auto i = 0u; i < np.size(); ++i) {
+      xs[i] = np[i].x_coordinate;
+      ys[i] = np[i].y_coordinate;
+    }
+    offsets.assign(np.size(), 0u);
+    geometries.clear();
+  }
+
+  double x(uint32_t index) const { return xs[index]; }
+  double y(uint32_t index) const { return ys[index]; }
+
+  /* centroid and bounding box of the placed nodes in pins */
+  template <typename Pins>
+  cut_geometry compute(Pins const& pins) const {
+    cut_geometry g;
+    g.x_min = g.y_min = std::numeric_limits<double>::max();
+    g.x_max = g.y_max = std::numeric_limits<double>::lowest();
+
+    double sum_x = 0, sum_y = 0;
+    int crt = 0;
+    for (auto const p : pins) {
+      sum_x += xs[p];
+      sum_y += ys[p];
+      g.x_min = std::min(g.x_min, xs[p]);
+      g.y_min = std::min(g.y_min, ys[p]);
+      g.x_max = std::max(g.x_max, xs[p]);
+      g.y_max = std::max(g.y_max, ys[p]);
+      ++crt;
+    }
+    g.centroid.x_coordinate = sum_x / crt;
+    g.centroid.y_coordinate = sum_y / crt;
+    return g;
+  }
+
+  /* starts the matched cuts of the node with index, nodes in any order */
+  void begin_node(uint32_t index) {
+    offsets[index] = static_cast<uint32_t>(geometries.size());
+  }
+
+  /* caches the geometry of the next matched cut of the current node */
+  template <typename Cut>
+  void add_cut(Cut const& cut) {
+    geometries.push_back(compute(cut.pins));
+  }
+
+  /* geometry of a matched cut of the node with index */
+  template <typename Cut>
+  cut_geometry const& cut(uint32_t index, Cut const& cut) const {
+    return geometries[offsets[index] + cut->data.match_index];
+  }
+
+  uint32_t num_cuts() const { return static_cast<uint32_t>(geometries.size()); }
+
+private:
+  std::vector<double> xs;
+  std::vector<double> ys;
+  std::vector<uint32_t> offsets;        /* first geometry by node index */
+  std::vector<cut_geometry> geometries; /* by offset and match index */
+};
+
+} // namespace mockturtle
@@ -4,6 +4,9 @@
 #include <optional>
 
 #include <mockturtle/mockturtle.hpp>
+#include <mockturtle/views/fanout_view.hpp>
+
+#include "utils/incremental_depth.hpp"
 
 namespace mockturtle
 {
@@ -58,7 +61,7 @@ class xag_depth_rewriting_impl
 {
 public:
   xag_depth_rewriting_impl( Ntk& ntk, xag_depth_rewriting_params const& ps )
-      : ntk( ntk ), ps( ps )
+      : ntk( ntk ), ps( ps ), levels( ntk )
   {
   }
 
@@ -85,7 +88,7 @@ private:
   {
     ntk.foreach_po( [this]( auto po ) {
       const auto driver = ntk.get_node( po );
-      if ( ntk.level( driver ) < ntk.depth() )
+      if ( ntk.level( driver ) < levels.depth() )
         return;
       topo_view topo{ntk, po};
       topo.foreach_node( [this]( auto n ) {
@@ -100,12 +103,19 @@ private:
     uint32_t counter{0};
     while ( true )
     {
+      const auto updates = levels.num_updates();
       mark_critical_paths();
 
-      topo_view topo{ntk};
-      topo.foreach_node( [this, &counter]( auto n ) {
-        if ( ntk.fanout_size( n ) == 0 || ntk.value( n ) == 0 )
-          return;
+      /* only critical nodes are visited, ordered by level to stay topological */
+      auto worklist = critical;
+      std::sort( worklist.begin(), worklist.end(), [this]( auto const& a, auto const& b ) {
+        return ntk.level( a ) < ntk.level( b ) || ( ntk.level( a ) == ntk.level( b ) && a < b );
+      } );
+
+      for ( auto const& n : worklist )
+      {
+        if ( ntk.is_dead( n ) || ntk.fanout_size( n ) == 0 || !is_critical( n ) )
+          continue;
 
         if ( reduce_depth_ultimate( n ) )
         {
@@ -115,9 +125,10 @@ private:
         {
           ++counter;
         }
-      } );
+      }
 
-      if ( counter > ntk.size() )
+      /* a pass without substitutions leaves the network unchanged */
+      if ( counter > ntk.size() || levels.num_updates() == updates )
         break;
     }
   }
@@ -186,7 +197,7 @@ private:
             
       auto opt = ntk.create_xor( ocs[0], ocs[1] );
       ntk.substitute_node( n, opt );
-      ntk.update_levels();
+      levels.update();
     }
 
     return true;
@@ -223,7 +234,7 @@ private:
     
     auto opt = ntk.create_xor(ocs[0], ocs[1]) ^ true;
     ntk.substitute_node( n, opt );
-    ntk.update_levels();
+    levels.update();
    
     return true;
   }
@@ -246,14 +257,14 @@ private:
           {
             auto opt = ntk.is_complemented(ocs[0])? !ocs[1] : ocs[1];
             ntk.substitute_node(n,opt);
-            ntk.update_levels();
+            levels.update();
           }
 
           if (ocs[1].index == 0 )
           {
             auto opt = ntk.is_complemented(ocs[1])? !ocs[0] : ocs[0];
             ntk.substitute_node(n,opt);
-            ntk.update_levels();
+            levels.update();
           }
         }
 
@@ -263,14 +274,14 @@ private:
           {
             auto opt = ntk.is_complemented(ocs[0])? ocs[1] : !ocs[1];
             ntk.substitute_node(n, opt);
-            ntk.update_levels();	  
+            levels.update();	  
           }
 
           if(ocs[1].index == 1 )
           {
             auto opt = ntk.is_complemented(ocs[1])? ocs[0] : !ocs[0];
             ntk.substitute_node(n, opt);
-            ntk.update_levels(); 
+            levels.update(); 
           }
         }
       }
@@ -283,13 +294,13 @@ private:
           {
             auto opt = ocs[1];
             ntk.substitute_node(n,opt);
-            ntk.update_levels();
+            levels.update();
           }
           else if(ocs[1].index == 1 && ntk.is_complemented(ocs[1]))
           {
             auto opt = ocs[0];
             ntk.substitute_node(n,opt);
-            ntk.update_levels();
+            levels.update();
           }	  
         }
       }
@@ -328,7 +339,7 @@ private:
       {
         auto opt = ntk.create_and( ocs[0], ocs2[1] );
         ntk.substitute_node( n, opt );
-        ntk.update_levels();
+        levels.update();
       }
       return true;
     }
@@ -362,7 +373,7 @@ private:
     {
       auto opt = ocs[1];
       ntk.substitute_node(n,opt);
-      ntk.update_levels();
+      levels.update();
     }
     /*if( auto cand = find_common_grand_child_two( ocs, ocs2 ); cand)
     { 
@@ -370,7 +381,7 @@ private:
       
       auto opt = ntk.create_and( r.y, r.a );
       ntk.substitute_node( n, opt );
-      ntk.update_levels();
+      levels.update();
       return true;
     }*/
 
@@ -405,14 +416,14 @@ private:
       {
         auto opt = ntk.create_xor(ocs[0], ntk.create_and(ocs2[0], ocs2[1]));
         ntk.substitute_node(n, opt);
-        ntk.update_levels();
+        levels.update();
       }
     /*if ( auto cand = find_common_grand_child_two( ocs, ocs2 ); cand )
     {
       auto r = *cand;
       auto opt = ntk.create_xor( r.a, ntk.create_and( r.a, r.y ) );
       ntk.substitute_node( n, opt );
-      ntk.update_levels();
+      levels.update();
       return true;
     }*/
     }
@@ -444,14 +455,14 @@ private:
         ocs2[1] = !ocs2[1];
         auto opt =  ntk.create_nand(ocs2[0], ocs2[1]);
         ntk.substitute_node(n, opt);
-        ntk.update_levels();
+        levels.update();
       }
       else
       {
         ocs2[1] = !ocs2[1];
         auto opt = ntk.create_and(ocs2[0], ocs2[1]);
         ntk.substitute_node(n, opt);
-        ntk.update_levels();
+        levels.update();
       }
     }
     return true;
@@ -481,7 +492,7 @@ private:
       {
          auto opt = ntk.create_or(ocs2[0], ocs2[1]);
          ntk.substitute_node(n, opt);
-         ntk.update_levels();
+         levels.update();
       }
       return true;
     }
@@ -588,14 +599,20 @@ private:
     } );
     return children;
   }
+/**************************************************************************************************************/
+  bool is_critical( node<Ntk> const& n ) const
+  {
+    return ntk.visited( n ) == ntk.trav_id();
+  }
 /**************************************************************************************************************/
   void mark_critical_path( node<Ntk> const& n )
   {
-    if ( ntk.is_pi( n ) || ntk.is_constant( n ) || ntk.value( n ) )
+    if ( ntk.is_pi( n ) || ntk.is_constant( n ) || is_critical( n ) )
       return;
 
     const auto level = ntk.level( n );
-    ntk.set_value( n, 1 );
+    ntk.set_visited( n, ntk.trav_id() );
+    critical.push_back( n );
     ntk.foreach_fanin( n, [this, level]( auto const& f ) {
       if ( ntk.level( ntk.get_node( f ) ) == level - 1 )
       {
@@ -604,11 +621,14 @@ private:
     } );
   }
 /**************************************************************************************************************/
+  /* marks use traversal ids, so only the critical cone is touched */
   void mark_critical_paths()
   {
-    ntk.clear_values();
-    ntk.foreach_po( [this]( auto const& f ) {
-      if ( ntk.level( ntk.get_node( f ) ) == ntk.depth() )
+    ntk.incr_trav_id();
+    critical.clear();
+    const auto depth = levels.depth();
+    ntk.foreach_po( [this, depth]( auto const& f ) {
+      if ( ntk.level( ntk.get_node( f ) ) == depth )
       {
         mark_critical_path( ntk.get_node( f ) );
       }
@@ -618,6 +638,8 @@ private:
 private:
   Ntk& ntk;
   xag_depth_rewriting_params const& ps;
+  incremental_depth<Ntk> levels;
+  std::vector<node<Ntk>> critical;
 };
 
 } // namespace detail
@@ -640,9 +662,10 @@ private:
  * - `foreach_po`
  * - `foreach_fanin`
  * - `is_maj`
- * - `clear_values`
- * - `set_value`
- * - `value`
+ * - `set_level`
+ * - `incr_trav_id`
+ * - `set_visited`
+ * - `visited`
  * - `fanout_size`
  *
    \verbatim embed:rst
@@ -666,13 +689,20 @@ void xag_depth_rewriting( Ntk& ntk, xag_depth_rewriting_params const& ps = {} )
   static_assert( has_foreach_fanin_v<Ntk>, "Ntk does not implement the foreach_fanin method" );
   static_assert( has_is_and_v<Ntk>, "Ntk does not implement the is_and method" );
   static_assert( has_is_xor_v<Ntk>, "Ntk does not implement the is_xor method" );
-  static_assert( has_clear_values_v<Ntk>, "Ntk does not implement the clear_values method" );
-  static_assert( has_set_value_v<Ntk>, "Ntk does not implement the set_value method" );
-  static_assert( has_value_v<Ntk>, "Ntk does not implement the value method" );
+  static_assert( has_incr_trav_id_v<Ntk>, "Ntk does not implement the incr_trav_id method" );
+  static_assert( has_set_visited_v<Ntk>, "Ntk does not implement the set_visited method" );
+  static_assert( has_visited_v<Ntk>, "Ntk does not implement the visited method" );
   static_assert( has_fanout_size_v<Ntk>, "Ntk does not implement the fanout_size method" );
 
-  detail::xag_depth_rewriting_impl<Ntk> p( ntk, ps );
+  /* fanouts let levels be updated on the transitive fanout only */
+  using fanout_view_t = fanout_view<Ntk>;
+  fanout_view_t fanout_view{ntk};
+
+  detail::xag_depth_rewriting_impl<fanout_view_t> p( fanout_view, ps );
   p.run();
+
+  /* bring the depth of the view in sync after incremental level updates */
+  ntk.update_levels();
 }
 
 } /* namespace mockturtle */
@@ -4,6 +4,9 @@
 #include <optional>
 
 #include <mockturtle/mockturtle.hpp>
+#include <mockturtle/views/fanout_view.hpp>
+
+#include "utils/incremental_depth.hpp"
 
 namespace mockturtle
 {
@@ -67,7 +70,7 @@ class xmg_depth_rewriting_impl
 {
 public:
   xmg_depth_rewriting_impl( Ntk& ntk, xmg_depth_rewriting_params const& ps )
-      : ntk( ntk ), ps( ps )
+      : ntk( ntk ), ps( ps ), levels( ntk )
   {
   }
 
@@ -101,7 +104,7 @@ private:
     /* reduce depth */
     ntk.foreach_po( [this]( auto po ) {
       const auto driver = ntk.get_node( po );
-      if ( ntk.level( driver ) < ntk.depth() )
+      if ( ntk.level( driver ) < levels.depth() )
         return;
       topo_view topo{ntk, po};
       topo.foreach_node( [this]( auto n ) {
@@ -124,7 +127,7 @@ private:
   {
     ntk.foreach_po( [this]( auto po ) {
       const auto driver = ntk.get_node( po );
-      if ( ntk.level( driver ) < ntk.depth() )
+      if ( ntk.level( driver ) < levels.depth() )
         return;
       topo_view topo{ntk, po};
       topo.foreach_node( [this]( auto n ) {
@@ -139,12 +142,19 @@ private:
     uint32_t counter{0};
     while ( true )
     {
+      const auto updates = levels.num_updates();
       mark_critical_paths();
 
-      topo_view topo{ntk};
-      topo.foreach_node( [this, &counter]( auto n ) {
-        if ( ntk.fanout_size( n ) == 0 || ntk.value( n ) == 0 )
-          return;
+      /* only critical nodes are visited, ordered by level to stay topological */
+      auto worklist = critical;
+      std::sort( worklist.begin(), worklist.end(), [this]( auto const& a, auto const& b ) {
+        return ntk.level( a ) < ntk.level( b ) || ( ntk.level( a ) == ntk.level( b ) && a < b );
+      } );
+
+      for ( auto const& n : worklist )
+      {
+        if ( ntk.is_dead( n ) || ntk.fanout_size( n ) == 0 || !is_critical( n ) )
+          continue;
 
         if ( reduce_depth_ultimate( n ) )
         {
@@ -154,9 +164,10 @@ private:
         {
           ++counter;
         }
-      } );
+      }
 
-      if ( counter > ntk.size() )
+      /* a pass without substitutions leaves the network unchanged */
+      if ( counter > ntk.size() || levels.num_updates() == updates )
         break;
     }
   }
@@ -226,7 +237,7 @@ private:
 
     auto opt = ntk.create_xor( ocs[2], ntk.create_xor( ocs[0], ocs[1] ) );
     ntk.substitute_node( n, opt );
-    ntk.update_levels();
+    levels.update();
 
     return true;
   }
@@ -269,7 +280,7 @@ private:
         {
           auto opt = ntk.create_xor3( ocs[1], ocs2[1], ocs2[2] );
           ntk.substitute_node( n, opt );
-          ntk.update_levels();
+          levels.update();
         }
 
         return true;
@@ -296,7 +307,7 @@ private:
         {
           auto opt = ntk.create_xor3( ocs[2], ocs2[1], ocs2[2] );
           ntk.substitute_node( n, opt );
-          ntk.update_levels();
+          levels.update();
         }
 
         return true;
@@ -348,7 +359,7 @@ private:
       const auto& [x, y, z, u, assoc] = *cand;
       auto opt = ntk.create_maj( z, assoc ? u : x, ntk.create_maj( x, y, u ) );
       ntk.substitute_node( n, opt );
-      ntk.update_levels();
+      levels.update();
 
       return true;
     }
@@ -360,7 +371,7 @@ private:
                                  ntk.create_maj( ocs[0], ocs[1], ocs2[0] ),
                                  ntk.create_maj( ocs[0], ocs[1], ocs2[1] ) );
       ntk.substitute_node( n, opt );
-      ntk.update_levels();
+      levels.update();
       return true;
     }
     return false;
@@ -429,7 +440,7 @@ private:
       auto opt = ntk.create_xor3( ocs[0], ocs2[2],
                                   ntk.create_xor3( ocs2[0], ocs2[1], ocs[1] ) );
       ntk.substitute_node( n, opt );
-      ntk.update_levels();
+      levels.update();
       return true;
     }
 
@@ -493,7 +504,7 @@ private:
       const auto& [x, y, z, u, assoc] = *cand;
       auto opt = ntk.create_maj( x, u, ntk.create_xor3( assoc ? !x : x, y, z ) );
       ntk.substitute_node( n, opt );
-      ntk.update_levels();
+      levels.update();
 
       return true;
     }
@@ -593,7 +604,7 @@ private:
         auto r = *cand;
         auto opt = ntk.create_xor3( r.a, r.b, ntk.create_maj( r.x, r.y, r.z ) );
         ntk.substitute_node( n, opt );
-        ntk.update_levels();
+        levels.update();
 
         return true;
       }
@@ -610,7 +621,7 @@ private:
         auto r = *cand;
         auto opt = ntk.create_xor3( r.a, r.b, ntk.create_maj( r.x, r.y, r.z ) );
         ntk.substitute_node( n, opt );
-        ntk.update_levels();
+        levels.update();
 
         return true;
       }
@@ -834,13 +845,19 @@ private:
     return children;
   }
 
+  bool is_critical( node<Ntk> const& n ) const
+  {
+    return ntk.visited( n ) == ntk.trav_id();
+  }
+
   void mark_critical_path( node<Ntk> const& n )
   {
-    if ( ntk.is_pi( n ) || ntk.is_constant( n ) || ntk.value( n ) )
+    if ( ntk.is_pi( n ) || ntk.is_constant( n ) || is_critical( n ) )
       return;
 
     const auto level = ntk.level( n );
-    ntk.set_value( n, 1 );
+    ntk.set_visited( n, ntk.trav_id() );
+    critical.push_back( n );
     ntk.foreach_fanin( n, [this, level]( auto const& f ) {
       if ( ntk.level( ntk.get_node( f ) ) == level - 1 )
       {
@@ -849,11 +866,14 @@ private:
     } );
   }
 
+  /* marks use traversal ids, so only the critical cone is touched */
   void mark_critical_paths()
   {
-    ntk.clear_values();
-    ntk.foreach_po( [this]( auto const& f ) {
-      if ( ntk.level( ntk.get_node( f ) ) == ntk.depth() )
+    ntk.incr_trav_id();
+    critical.clear();
+    const auto depth = levels.depth();
+    ntk.foreach_po( [this, depth]( auto const& f ) {
+      if ( ntk.level( ntk.get_node( f ) ) == depth )
       {
         mark_critical_path( ntk.get_node( f ) );
       }
@@ -863,6 +883,8 @@ private:
 private:
   Ntk& ntk;
   xmg_depth_rewriting_params const& ps;
+  incremental_depth<Ntk> levels;
+  std::vector<node<Ntk>> critical;
 };
 
 } // namespace detail
@@ -885,9 +907,10 @@ private:
  * - `foreach_po`
  * - `foreach_fanin`
  * - `is_maj`
- * - `clear_values`
- * - `set_value`
- * - `value`
+ * - `set_level`
+ * - `incr_trav_id`
+ * - `set_visited`
+ * - `visited`
  * - `fanout_size`
  *
    \verbatim embed:rst
@@ -913,13 +936,20 @@ void xmg_depth_rewriting( Ntk& ntk, xmg_depth_rewriting_params const& ps = {} )
   static_assert( has_foreach_fanin_v<Ntk>, "Ntk does not implement the foreach_fanin method" );
   static_assert( has_is_maj_v<Ntk>, "Ntk does not implement the is_maj method" );
   static_assert( has_is_xor3_v<Ntk>, "Ntk does not implement the is_maj method" );
-  static_assert( has_clear_values_v<Ntk>, "Ntk does not implement the clear_values method" );
-  static_assert( has_set_value_v<Ntk>, "Ntk does not implement the set_value method" );
-  static_assert( has_value_v<Ntk>, "Ntk does not implement the value method" );
+  static_assert( has_incr_trav_id_v<Ntk>, "Ntk does not implement the incr_trav_id method" );
+  static_assert( has_set_visited_v<Ntk>, "Ntk does not implement the set_visited method" );
+  static_assert( has_visited_v<Ntk>, "Ntk does not implement the visited method" );
   static_assert( has_fanout_size_v<Ntk>, "Ntk does not implement the fanout_size method" );
 
-  detail::xmg_depth_rewriting_impl<Ntk> p( ntk, ps );
+  /* fanouts let levels be updated on the transitive fanout only */
+  using fanout_view_t = fanout_view<Ntk>;
+  fanout_view_t fanout_view{ntk};
+
+  detail::xmg_depth_rewriting_impl<fanout_view_t> p( fanout_view, ps );
   p.run();
+
+  /* bring the depth of the view in sync after incremental level updates */
+  ntk.update_levels();
 }
 
 } /* namespace mockturtle */